@@ -0,0 +1,253 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+/**
+ * @file nori-control-decode-benchmark.cc
+ * @brief Long-run memory benchmark of the RIC Control message decoding
+ *
+ * Decodes the same RIC Control request many times, as a gNB receiving controls
+ * for hours would, and prints the resident set size along the way. With the
+ * decode context of the E2 node the RSS must stay flat after the first messages.
+ *
+ * By default the request is built by the benchmark, as the RAN slicing xApp sends
+ * it: an E2SM-RC Control Header Format 1 with an RRM policy ratio group per slice,
+ * APER-encoded in a RIC Control request:
+ *
+ * \code{.unparsed}
+$ ./ns3 run "nori-control-decode-benchmark --messages=10000000 --slices=3"
+    \endcode
+ *
+ * A request captured from a RIC can be decoded instead, from a file holding the
+ * APER-encoded E2AP PDU:
+ *
+ * \code{.unparsed}
+$ ./ns3 run "nori-control-decode-benchmark --pdu=control.aper --messages=10000000"
+    \endcode
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/ric-control-message.h"
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+
+extern "C"
+{
+#include "E2AP-PDU.h"
+#include "InitiatingMessage.h"
+#include "ProtocolIE-Field.h"
+#include "RICcontrolRequest.h"
+#include <E2SM-RC-ControlHeader-Format1.h>
+#include <E2SM-RC-ControlHeader.h>
+#include <RRMPolicyMember.h>
+#include <RRMPolicyRatioGroup.h>
+#include <RRMPolicyRatioList.h>
+}
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("NoriControlDecodeBenchmark");
+
+/**
+ * @return the resident set size of the process, in kB
+ */
+static uint64_t
+GetRssKb()
+{
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    statm >> size >> resident;
+    return resident * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+/**
+ * @brief Allocate a PRB policy ratio, released with the structure holding it
+ * @param ratio the ratio, percentage
+ * @return the ratio
+ */
+static long*
+NewRatio(long ratio)
+{
+    auto* value = (long*)calloc(1, sizeof(long));
+    *value = ratio;
+    return value;
+}
+
+/**
+ * @brief Add an IE to a RIC Control request
+ * @param request the request
+ * @param present the type of the IE value
+ * @return the value of the IE, to be filled
+ */
+static decltype(RICcontrolRequest_IEs_t::value)&
+AddIe(RICcontrolRequest_t& request, RICcontrolRequest_IEs__value_PR present)
+{
+    auto* ie = (RICcontrolRequest_IEs_t*)calloc(1, sizeof(RICcontrolRequest_IEs_t));
+    ie->value.present = present;
+    ASN_SEQUENCE_ADD(&request.protocolIEs.list, ie);
+    return ie->value;
+}
+
+/**
+ * @brief Build the RIC Control request of the RAN slicing xApp: an E2SM-RC Control
+ * Header Format 1 holding an RRM policy ratio group per slice
+ * @param slices the number of slices
+ * @return the request, to be released with ASN_STRUCT_FREE
+ */
+static E2AP_PDU_t*
+BuildSlicingControl(uint32_t slices)
+{
+    auto* header = (E2SM_RC_ControlHeader_t*)calloc(1, sizeof(E2SM_RC_ControlHeader_t));
+    header->present = E2SM_RC_ControlHeader_PR_controlHeader_Format1;
+    auto* format1 =
+        (E2SM_RC_ControlHeader_Format1_t*)calloc(1, sizeof(E2SM_RC_ControlHeader_Format1_t));
+    header->choice.controlHeader_Format1 = format1;
+    std::string ueId = "00001";
+    OCTET_STRING_fromBuf(&format1->ueId, ueId.c_str(), ueId.size());
+    format1->ric_ControlStyle_Type = 1;
+    format1->ric_ControlAction_ID = 1;
+
+    format1->rrmPolicyList = (RRMPolicyRatioList_t*)calloc(1, sizeof(RRMPolicyRatioList_t));
+    for (uint32_t slice = 0; slice < slices; slice++)
+    {
+        auto* snssai = (SNSSAI_t*)calloc(1, sizeof(SNSSAI_t));
+        uint8_t sst = slice;
+        OCTET_STRING_fromBuf(&snssai->sST, (const char*)&sst, 1);
+        auto* member = (RRMPolicyMember_t*)calloc(1, sizeof(RRMPolicyMember_t));
+        member->sNSSAI = reinterpret_cast<decltype(member->sNSSAI)>(snssai);
+
+        // The PRBs split evenly, as the xApp does before it has learnt anything
+        auto* group = (RRMPolicyRatioGroup_t*)calloc(1, sizeof(RRMPolicyRatioGroup_t));
+        ASN_SEQUENCE_ADD(&group->rrmPolicy.rrmPolicyMemberList.list, member);
+        group->maxPRBPolicyRatio = NewRatio(100 / slices);
+        group->minPRBPolicyRatio = NewRatio(100 / slices / 2);
+        group->dedicatedPRBPolicyRatio = NewRatio(100 / slices / 4);
+        ASN_SEQUENCE_ADD(&format1->rrmPolicyList->list, group);
+    }
+
+    asn_encode_to_new_buffer_result_s encoded =
+        asn_encode_to_new_buffer(nullptr,
+                                 ATS_ALIGNED_BASIC_PER,
+                                 &asn_DEF_E2SM_RC_ControlHeader,
+                                 header);
+    NS_ABORT_MSG_IF(encoded.result.encoded < 0,
+                    "Can't encode the E2SM-RC Control Header, failed type "
+                        << encoded.result.failed_type->name);
+    ASN_STRUCT_FREE(asn_DEF_E2SM_RC_ControlHeader, header);
+
+    auto* pdu = (E2AP_PDU_t*)calloc(1, sizeof(E2AP_PDU_t));
+    pdu->present = E2AP_PDU_PR_initiatingMessage;
+    pdu->choice.initiatingMessage = (InitiatingMessage_t*)calloc(1, sizeof(InitiatingMessage_t));
+    auto& value = pdu->choice.initiatingMessage->value;
+    value.present = InitiatingMessage__value_PR_RICcontrolRequest;
+    auto& request = value.choice.RICcontrolRequest;
+
+    // Requestor 1003 is the RAN slicing xApp, the SN of the indication answered is
+    // echoed as call process ID
+    auto& requestId = AddIe(request, RICcontrolRequest_IEs__value_PR_RICrequestID);
+    requestId.choice.RICrequestID.ricRequestorID = 1003;
+    requestId.choice.RICrequestID.ricInstanceID = 1;
+    AddIe(request, RICcontrolRequest_IEs__value_PR_RANfunctionID).choice.RANfunctionID = 300;
+    std::string callProcessId = "1";
+    OCTET_STRING_fromBuf(
+        &AddIe(request, RICcontrolRequest_IEs__value_PR_RICcallProcessID).choice.RICcallProcessID,
+        callProcessId.c_str(),
+        callProcessId.size());
+    // The encoded header is handed over to the PDU, which releases it
+    auto& controlHeader =
+        AddIe(request, RICcontrolRequest_IEs__value_PR_RICcontrolHeader).choice.RICcontrolHeader;
+    controlHeader.buf = (uint8_t*)encoded.buffer;
+    controlHeader.size = encoded.result.encoded;
+    return pdu;
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string pduFile;
+    uint32_t slices = 3;
+    uint64_t messages = 1000000;
+    uint64_t printEvery = 100000;
+    bool sharedContext = true;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("pdu", "File holding an APER-encoded RIC Control request, if any", pduFile);
+    cmd.AddValue("slices", "Slices of the request built when no --pdu is given", slices);
+    cmd.AddValue("messages", "Number of messages to decode", messages);
+    cmd.AddValue("printEvery", "Messages between two RSS samples", printEvery);
+    cmd.AddValue("sharedContext",
+                 "Decode with the context of the E2 node instead of one per message",
+                 sharedContext);
+    cmd.Parse(argc, argv);
+
+    E2AP_PDU_t* pdu = nullptr;
+    if (pduFile.empty())
+    {
+        NS_ABORT_MSG_IF(slices == 0 || slices > 256, "Between 1 and 256 slices, see --slices");
+        pdu = BuildSlicingControl(slices);
+    }
+    else
+    {
+        std::ifstream file(pduFile, std::ios::binary);
+        NS_ABORT_MSG_UNLESS(file.is_open(), "Can't open file " << pduFile);
+        std::vector<uint8_t> encoded{std::istreambuf_iterator<char>(file),
+                                     std::istreambuf_iterator<char>()};
+
+        asn_dec_rval_t rval = asn_decode(nullptr,
+                                         ATS_ALIGNED_BASIC_PER,
+                                         &asn_DEF_E2AP_PDU,
+                                         (void**)&pdu,
+                                         encoded.data(),
+                                         encoded.size());
+        NS_ABORT_MSG_UNLESS(rval.code == RC_OK &&
+                                pdu->present == E2AP_PDU_PR_initiatingMessage &&
+                                pdu->choice.initiatingMessage->value.present ==
+                                    InitiatingMessage__value_PR_RICcontrolRequest,
+                            "Not a RIC Control request: " << pduFile);
+    }
+
+    auto decoder = Create<RicControlDecoder>();
+    if (pduFile.empty())
+    {
+        // The request built must decode to the quotas it was built with
+        RicControlMessage msg(pdu, *decoder);
+        NS_ABORT_MSG_UNLESS(msg.m_prbQuotas.size() == slices,
+                            "Decoded " << msg.m_prbQuotas.size() << " slice quotas out of "
+                                       << slices);
+    }
+    uint64_t startRss = GetRssKb();
+    auto start = std::chrono::steady_clock::now();
+    size_t quotas = 0;
+    std::cout << "messages,rssKb" << std::endl;
+    for (uint64_t i = 1; i <= messages; i++)
+    {
+        if (sharedContext)
+        {
+            RicControlMessage msg(pdu, *decoder);
+            quotas += msg.m_prbQuotas.size();
+        }
+        else
+        {
+            RicControlMessage msg(pdu);
+            quotas += msg.m_prbQuotas.size();
+        }
+        if (i % printEvery == 0)
+        {
+            std::cout << i << "," << GetRssKb() << std::endl;
+        }
+    }
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Decoded " << messages << " messages (" << quotas << " slice quotas) in "
+              << seconds << " s, " << messages / seconds << " messages/s" << std::endl;
+    std::cout << "RSS growth: " << static_cast<int64_t>(GetRssKb() - startRss) << " kB"
+              << std::endl;
+
+    ASN_STRUCT_FREE(asn_DEF_E2AP_PDU, pdu);
+    return 0;
+}
@@ -0,0 +1,557 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+/**
+ * @file nori-e2-replay.cc
+ * @brief Replay a log of E2 indications recorded offline to load-test xApps
+ *
+ * Streams the RIC Indications of a log written with the RecordFile attribute of
+ * E2TermHelper, without running the simulation again. The log is mapped and the
+ * recorded PDUs are sent as they are, paced on their simulation time:
+ * --speed=1 replays at the original pace, --speed=10 or 100 faster, and --speed=0
+ * as fast as the endpoint accepts them.
+ *
+ * The indications go either to a local agent through the shared memory rings of
+ * each cell, as with the ShmName attribute of E2TermHelper:
+ *
+ * \code{.unparsed}
+$ ./ns3 run "nori-e2-replay --log=campaign.e2log --shmName=/nori --speed=100"
+    \endcode
+ *
+ * or to a RIC through e2sim, one E2 node per recorded cell. The replay then waits
+ * for the RIC to subscribe to each cell, once per subscription recorded for it, and
+ * the RIC request and action IDs of the indications of each recorded subscription
+ * are rewritten to those of a RIC subscription. When the RIC subscribes fewer times,
+ * the recorded subscriptions share its subscriptions in turn:
+ *
+ * \code{.unparsed}
+$ ./ns3 run "nori-e2-replay --log=campaign.e2log --ricIp=10.0.2.10 --speed=0"
+    \endcode
+ *
+ * At the end, the indication rate achieved and the latency of the controls of the
+ * xApp are printed. As in E2Interface, a control is matched, within the subscription
+ * named by its RIC request ID, to the indication whose sequence number the RIC
+ * echoes as RIC call process ID, or else to the last indication of the subscription.
+ * When --loops repeats a sequence number, the last indication sent with it is used.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/e2-record-log.h"
+#include "ns3/kpm-function-description.h"
+#include "ns3/latency-histogram.h"
+#include "ns3/oran-interface.h"
+#include "ns3/ric-control-function-description.h"
+#include "ns3/shm-ring.h"
+
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+extern "C"
+{
+#include "E2AP-PDU.h"
+#include "InitiatingMessage.h"
+#include "ProtocolIE-Field.h"
+#include "RICcontrolRequest.h"
+#include "RICindication.h"
+}
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("NoriE2Replay");
+
+using Clock = std::chrono::steady_clock;
+
+/// RIC requestor and instance IDs naming a subscription
+using RequestId = std::pair<uint16_t, uint16_t>;
+
+/// Subscription, RIC indication SN and replay loop of an indication sent
+using SentKey = std::tuple<uint16_t, uint16_t, uint32_t, uint32_t>;
+
+/// RIC requestor, instance and action IDs of a recorded subscription
+using RecordedSubscription = std::tuple<uint16_t, uint16_t, uint8_t>;
+
+/**
+ * Replay state of a recorded cell
+ */
+struct ReplayCell
+{
+    Ptr<ShmRing> indicationRing; //!< Ring to the agent, shm mode
+    Ptr<ShmRing> controlRing;    //!< Ring from the agent, shm mode
+    Ptr<E2Termination> e2Term;   //!< E2 node, e2sim mode
+    //! Subscriptions of the RIC, in the order they came, e2sim mode
+    std::vector<E2Termination::RicSubscriptionRequest_rval_s> subscriptions;
+    std::set<RecordedSubscription> recorded; //!< Subscriptions of the log
+    //! Index in subscriptions of each recorded subscription, assigned on first use
+    std::map<RecordedSubscription, size_t> subscriptionOf;
+    std::map<SentKey, Clock::time_point> sent; //!< Send time of the recent indications
+    std::deque<SentKey> sentOrder;             //!< Keys of sent, oldest first
+    std::map<RequestId, SentKey> lastSent;     //!< Last indication of each subscription
+};
+
+static std::map<uint16_t, ReplayCell> g_cells; //!< Recorded cells
+static std::mutex g_mutex; //!< Protects the subscriptions, the sent times and g_latency
+static LatencyHistogram g_latency;       //!< Indication to control latency
+static uint64_t g_unmatchedControls = 0; //!< Controls without a matching indication
+
+/**
+ * Fields of a RIC Control request naming the indication it answers
+ */
+struct ControlIds
+{
+    RequestId requestId;     //!< RIC request ID of the subscription
+    bool hasSequenceNumber;  //!< Whether the RIC call process ID holds an SN
+    uint32_t sequenceNumber; //!< SN of the indication answered
+};
+
+/**
+ * @brief Find the RIC request ID and the SN echoed as RIC call process ID of a RIC
+ * Control request, the same way as E2Interface::FindOpenLoop
+ * @param pdu the E2AP PDU
+ * @param ids the IDs found
+ * @return false if the PDU is not a RIC Control request or has no RIC request ID
+ */
+static bool
+GetControlIds(const E2AP_PDU_t* pdu, ControlIds& ids)
+{
+    if (pdu->present != E2AP_PDU_PR_initiatingMessage ||
+        pdu->choice.initiatingMessage->value.present !=
+            InitiatingMessage__value_PR_RICcontrolRequest)
+    {
+        return false;
+    }
+    bool hasRequestId = false;
+    ids.hasSequenceNumber = false;
+    const auto& ies = pdu->choice.initiatingMessage->value.choice.RICcontrolRequest.protocolIEs;
+    for (int i = 0; i < ies.list.count; i++)
+    {
+        const auto& value = ies.list.array[i]->value;
+        if (value.present == RICcontrolRequest_IEs__value_PR_RICrequestID)
+        {
+            ids.requestId = {value.choice.RICrequestID.ricRequestorID,
+                             value.choice.RICrequestID.ricInstanceID};
+            hasRequestId = true;
+        }
+        else if (value.present == RICcontrolRequest_IEs__value_PR_RICcallProcessID)
+        {
+            std::string callProcessId((const char*)value.choice.RICcallProcessID.buf,
+                                      value.choice.RICcallProcessID.size);
+            if (!callProcessId.empty() && std::isdigit((unsigned char)callProcessId[0]))
+            {
+                char* end = nullptr;
+                unsigned long long sequenceNumber = std::strtoull(callProcessId.c_str(), &end, 10);
+                if (*end == '\0' && sequenceNumber <= UINT32_MAX)
+                {
+                    ids.hasSequenceNumber = true;
+                    ids.sequenceNumber = static_cast<uint32_t>(sequenceNumber);
+                }
+            }
+        }
+    }
+    return hasRequestId;
+}
+
+/**
+ * @brief Account for a control received from the xApp
+ * @param cell the cell the control is addressed to
+ * @param pdu the E2AP PDU of the control
+ */
+static void
+ControlReceived(ReplayCell& cell, const E2AP_PDU_t* pdu)
+{
+    auto received = Clock::now();
+    ControlIds ids;
+    if (!GetControlIds(pdu, ids))
+    {
+        return;
+    }
+    auto [requestorId, instanceId] = ids.requestId;
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto it = cell.sent.end();
+    if (ids.hasSequenceNumber)
+    {
+        // Last loop that sent the SN, the keys are sorted by loop within it
+        auto next =
+            cell.sent.upper_bound({requestorId, instanceId, ids.sequenceNumber, UINT32_MAX});
+        if (next != cell.sent.begin())
+        {
+            auto [sentRequestorId, sentInstanceId, sentSequenceNumber, sentLoop] =
+                std::prev(next)->first;
+            if (sentRequestorId == requestorId && sentInstanceId == instanceId &&
+                sentSequenceNumber == ids.sequenceNumber)
+            {
+                it = std::prev(next);
+            }
+        }
+    }
+    else if (auto last = cell.lastSent.find(ids.requestId); last != cell.lastSent.end())
+    {
+        it = cell.sent.find(last->second);
+    }
+    if (it == cell.sent.end())
+    {
+        g_unmatchedControls++;
+        return;
+    }
+    g_latency.Add(std::chrono::duration<double, std::milli>(received - it->second).count());
+}
+
+/**
+ * @brief Decode and account for the controls waiting in the control rings
+ */
+static void
+PollControlRings()
+{
+    static std::vector<uint8_t> record;
+    for (auto& [cellId, cell] : g_cells)
+    {
+        uint16_t type;
+        while (cell.controlRing && cell.controlRing->Read(type, record))
+        {
+            if (type != ShmRing::E2AP_PDU)
+            {
+                continue;
+            }
+            E2AP_PDU_t* pdu = nullptr;
+            asn_dec_rval_t rval = asn_decode(nullptr,
+                                             ATS_ALIGNED_BASIC_PER,
+                                             &asn_DEF_E2AP_PDU,
+                                             (void**)&pdu,
+                                             record.data(),
+                                             record.size());
+            if (rval.code == RC_OK)
+            {
+                ControlReceived(cell, pdu);
+            }
+            ASN_STRUCT_FREE(asn_DEF_E2AP_PDU, pdu);
+        }
+    }
+}
+
+/**
+ * @brief Rewrite the RIC request and action IDs of a RIC Indication to those of a
+ * subscription
+ * @param pdu the E2AP PDU of the indication
+ * @param sub the subscription
+ */
+static void
+RewriteSubscription(E2AP_PDU_t* pdu, const E2Termination::RicSubscriptionRequest_rval_s& sub)
+{
+    auto& ies = pdu->choice.initiatingMessage->value.choice.RICindication.protocolIEs;
+    for (int i = 0; i < ies.list.count; i++)
+    {
+        auto& value = ies.list.array[i]->value;
+        if (value.present == RICindication_IEs__value_PR_RICrequestID)
+        {
+            value.choice.RICrequestID.ricRequestorID = sub.requestorId;
+            value.choice.RICrequestID.ricInstanceID = sub.instanceId;
+        }
+        else if (value.present == RICindication_IEs__value_PR_RICactionID)
+        {
+            value.choice.RICactionID = sub.actionId;
+        }
+    }
+}
+
+/**
+ * @brief Get the RIC subscription a recorded subscription is replayed on, g_mutex
+ * held. The recorded subscriptions take the RIC subscriptions in turn, in the order
+ * they first appear in the log.
+ * @param cell the cell that recorded it
+ * @param frame the frame header of an indication of the recorded subscription
+ * @return the RIC subscription
+ */
+static const E2Termination::RicSubscriptionRequest_rval_s&
+GetReplaySubscription(ReplayCell& cell, const E2RecordLog::FrameHeader& frame)
+{
+    RecordedSubscription recorded{frame.requestorId, frame.instanceId, frame.actionId};
+    auto index = cell.subscriptionOf.find(recorded);
+    if (index == cell.subscriptionOf.end())
+    {
+        size_t next = cell.subscriptionOf.size() % cell.subscriptions.size();
+        index = cell.subscriptionOf.emplace(recorded, next).first;
+    }
+    return cell.subscriptions[index->second];
+}
+
+/**
+ * @brief Send a recorded indication
+ * @param cell the cell that recorded it
+ * @param frame the frame header
+ * @param data the encoded PDU
+ * @param loop the replay loop, from 0
+ * @param ringStalls incremented each time the indication ring is full
+ * @return false if the PDU could not be sent
+ */
+static bool
+SendFrame(ReplayCell& cell,
+          const E2RecordLog::FrameHeader& frame,
+          const uint8_t* data,
+          uint32_t loop,
+          uint64_t& ringStalls)
+{
+    // The agent sees the recorded IDs, the RIC those of its own subscriptions
+    E2Termination::RicSubscriptionRequest_rval_s subscription{};
+    subscription.requestorId = frame.requestorId;
+    subscription.instanceId = frame.instanceId;
+    subscription.actionId = frame.actionId;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (cell.e2Term)
+        {
+            subscription = GetReplaySubscription(cell, frame);
+        }
+        SentKey key{subscription.requestorId,
+                    subscription.instanceId,
+                    frame.sequenceNumber,
+                    loop};
+        cell.sent[key] = Clock::now();
+        cell.sentOrder.push_back(key);
+        cell.lastSent[{subscription.requestorId, subscription.instanceId}] = key;
+        // Indications never answered are forgotten after a while
+        if (cell.sentOrder.size() > 1024)
+        {
+            cell.sent.erase(cell.sentOrder.front());
+            cell.sentOrder.pop_front();
+        }
+    }
+
+    if (cell.indicationRing)
+    {
+        // The agent sets the pace when it falls behind, nothing is dropped
+        while (!cell.indicationRing->Write(ShmRing::E2AP_PDU, data, frame.size))
+        {
+            ringStalls++;
+            PollControlRings();
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        return true;
+    }
+
+    E2AP_PDU_t* pdu = nullptr;
+    asn_dec_rval_t rval = asn_decode(nullptr,
+                                     ATS_ALIGNED_BASIC_PER,
+                                     &asn_DEF_E2AP_PDU,
+                                     (void**)&pdu,
+                                     data,
+                                     frame.size);
+    if (rval.code != RC_OK || pdu->present != E2AP_PDU_PR_initiatingMessage ||
+        pdu->choice.initiatingMessage->value.present != InitiatingMessage__value_PR_RICindication)
+    {
+        NS_LOG_WARN("Skipping a frame of cell " << frame.cellId
+                                                << " that is not a RIC Indication");
+        ASN_STRUCT_FREE(asn_DEF_E2AP_PDU, pdu);
+        return false;
+    }
+    RewriteSubscription(pdu, subscription);
+    // The contents are released once sent
+    bool sent = cell.e2Term->SendE2Message(pdu);
+    free(pdu);
+    return sent;
+}
+
+/**
+ * @brief Wait until a wall-clock time, accounting for the controls meanwhile
+ * @param deadline the time
+ */
+static void
+WaitUntil(Clock::time_point deadline)
+{
+    while (true)
+    {
+        PollControlRings();
+        auto now = Clock::now();
+        if (now >= deadline)
+        {
+            return;
+        }
+        std::this_thread::sleep_for(std::min<Clock::duration>(deadline - now,
+                                                              std::chrono::microseconds(100)));
+    }
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string logFile;
+    std::string shmName;
+    std::string ricIp;
+    uint16_t ricPort = 36422;
+    uint16_t localPort = 38470;
+    std::string plmnId = "111";
+    double speed = 1;
+    uint32_t loops = 1;
+    double drainS = 1;
+    double subscribeTimeoutS = 60;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("log", "Log of indications recorded with E2TermHelper::RecordFile", logFile);
+    cmd.AddValue("shmName", "Prefix of the shared memory rings of the local agent", shmName);
+    cmd.AddValue("ricIp", "IP address of the RIC E2 termination, if no shmName", ricIp);
+    cmd.AddValue("ricPort", "Port of the RIC E2 termination", ricPort);
+    cmd.AddValue("localPort", "First local port, the cell ID is added", localPort);
+    cmd.AddValue("plmnId", "PLMN ID of the E2 nodes", plmnId);
+    cmd.AddValue("speed", "Replay speed relative to the simulation time, 0 for max rate", speed);
+    cmd.AddValue("loops", "Number of times the log is replayed", loops);
+    cmd.AddValue("drain", "Time to wait for the last controls, in s", drainS);
+    cmd.AddValue("subscribeTimeout",
+                 "Time to wait for the RIC subscriptions, in s",
+                 subscribeTimeoutS);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_IF(logFile.empty(), "A log is needed, see --log");
+    NS_ABORT_MSG_IF(shmName.empty() == ricIp.empty(), "Set exactly one of --shmName and --ricIp");
+    NS_ABORT_MSG_IF(speed < 0, "The speed can't be negative");
+
+    auto reader = Create<E2RecordReader>(logFile);
+    const E2RecordLog::FrameHeader* frame;
+    const uint8_t* data;
+    uint64_t frames = 0;
+    int64_t firstNs = 0;
+    int64_t lastNs = 0;
+    while (reader->Next(frame, data))
+    {
+        firstNs = (frames == 0) ? frame->simTimeNs : firstNs;
+        lastNs = frame->simTimeNs;
+        frames++;
+        g_cells[frame->cellId].recorded.insert(
+            {frame->requestorId, frame->instanceId, frame->actionId});
+    }
+    NS_ABORT_MSG_IF(frames == 0, logFile << " holds no indication");
+    std::cout << logFile << ": " << frames << " indications of " << g_cells.size()
+              << " cells over " << (lastNs - firstNs) / 1e9 << " s of simulation" << std::endl;
+
+    for (auto& [cellId, cell] : g_cells)
+    {
+        std::string name = shmName + "-" + std::to_string(cellId);
+        if (!shmName.empty())
+        {
+            cell.indicationRing = Create<ShmRing>(name + "-ind", 1 << 24);
+            cell.controlRing = Create<ShmRing>(name + "-ctrl", 1 << 24);
+            continue;
+        }
+
+        cell.e2Term = CreateObject<E2Termination>(ricIp,
+                                                  ricPort,
+                                                  localPort + cellId,
+                                                  std::to_string(cellId),
+                                                  plmnId);
+        ReplayCell* replayCell = &cell;
+        Ptr<E2Termination> e2Term = cell.e2Term;
+        cell.e2Term->RegisterKpmCallbackToE2Sm(
+            200,
+            Create<KpmFunctionDescription>(),
+            [replayCell, e2Term](E2AP_PDU_t* pdu) {
+                auto request = e2Term->ProcessRicSubscriptionRequest(pdu);
+                e2Term->SendRicSubscriptionResponse(request);
+                std::lock_guard<std::mutex> lock(g_mutex);
+                for (const auto& action : request.actions)
+                {
+                    replayCell->subscriptions.push_back(action);
+                }
+            });
+        cell.e2Term->RegisterSmCallbackToE2Sm(
+            300,
+            Create<RicControlFunctionDescription>(),
+            [replayCell](E2AP_PDU_t* pdu) { ControlReceived(*replayCell, pdu); });
+        cell.e2Term->Start();
+    }
+
+    if (!ricIp.empty())
+    {
+        auto timeout = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                          std::chrono::duration<double>(subscribeTimeoutS));
+        for (auto& [cellId, cell] : g_cells)
+        {
+            // One RIC subscription per recorded subscription, or as many as came in time
+            size_t subscriptions = 0;
+            while (Clock::now() < timeout)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(g_mutex);
+                    subscriptions = cell.subscriptions.size();
+                }
+                if (subscriptions >= cell.recorded.size())
+                {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            NS_ABORT_MSG_IF(subscriptions == 0, "The RIC did not subscribe to cell " << cellId);
+            if (subscriptions < cell.recorded.size())
+            {
+                std::cout << "Cell " << cellId << ": " << cell.recorded.size()
+                          << " recorded subscriptions share " << subscriptions
+                          << " RIC subscriptions" << std::endl;
+            }
+        }
+    }
+
+    uint64_t sent = 0;
+    uint64_t failed = 0;
+    uint64_t ringStalls = 0;
+    auto start = Clock::now();
+    for (uint32_t loop = 0; loop < loops; loop++)
+    {
+        reader->Rewind();
+        auto loopStart = Clock::now();
+        while (reader->Next(frame, data))
+        {
+            if (speed > 0)
+            {
+                auto offset = std::chrono::duration<double, std::nano>(
+                    (frame->simTimeNs - firstNs) / speed);
+                WaitUntil(loopStart + std::chrono::duration_cast<Clock::duration>(offset));
+            }
+            if (SendFrame(g_cells[frame->cellId], *frame, data, loop, ringStalls))
+            {
+                sent++;
+            }
+            else
+            {
+                failed++;
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    WaitUntil(Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                 std::chrono::duration<double>(drainS)));
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    std::cout << "Sent " << sent << " indications (" << failed << " failed) in " << seconds
+              << " s: " << sent / seconds << " indications/s, "
+              << loops * (lastNs - firstNs) / 1e9 / seconds << "x the simulation time"
+              << std::endl;
+    if (ringStalls > 0)
+    {
+        std::cout << "The agent fell behind " << ringStalls << " times" << std::endl;
+    }
+    std::cout << "Controls: " << g_latency.GetCount() << " matched, " << g_unmatchedControls
+              << " unmatched" << std::endl;
+    if (g_latency.GetCount() > 0)
+    {
+        std::cout << "Indication to control latency (ms): mean " << g_latency.GetMean()
+                  << ", p50 " << g_latency.GetPercentile(50) << ", p99 "
+                  << g_latency.GetPercentile(99) << ", max " << g_latency.GetMax() << std::endl;
+    }
+    if (!ricIp.empty())
+    {
+        // e2sim keeps its threads running, the process exits without tearing them down
+        std::cout.flush();
+        _exit(0);
+    }
+    return 0;
+}
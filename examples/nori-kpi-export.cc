@@ -0,0 +1,140 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+/**
+ * @file nori-kpi-export.cc
+ * @brief Export a columnar KPI store to CSV
+ *
+ * Converts a store written with the KpiStorePrefix attribute of E2TermHelper,
+ * e.g. campaign-ue.kpi, to CSV rows of the timestamp, the cell ID and the
+ * columns asked for. Only the blocks of the cell and time range asked for are
+ * decoded, and only their selected columns:
+ *
+ * \code{.unparsed}
+$ ./ns3 run "nori-kpi-export --store=campaign-ue.kpi --cellId=2 --from=10000 --to=20000
+    --columns=imsi,dlThroughput,macPrb --output=cell2.csv"
+    \endcode
+ *
+ * The rows come block after block, each block holding the consecutive rows of
+ * one cell, so the rows of a cell are in time order but the cells are interleaved.
+ * Without --columns, the schema of the store is printed before the export.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/kpi-store.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("NoriKpiExport");
+
+int
+main(int argc, char* argv[])
+{
+    std::string storeFile;
+    std::string outputFile;
+    std::string columnList;
+    int64_t from = std::numeric_limits<int64_t>::min();
+    int64_t to = std::numeric_limits<int64_t>::max();
+    int32_t cellId = -1;
+    uint32_t precision = 10;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("store", "KPI store written with E2TermHelper::KpiStorePrefix", storeFile);
+    cmd.AddValue("output", "CSV file to write, the standard output if empty", outputFile);
+    cmd.AddValue("columns", "Comma separated columns to export, all if empty", columnList);
+    cmd.AddValue("from", "First timestamp to export, in ms", from);
+    cmd.AddValue("to", "Last timestamp to export, in ms", to);
+    cmd.AddValue("cellId", "Cell to export, -1 for all the cells", cellId);
+    cmd.AddValue("precision", "Significant digits of the floating point columns", precision);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_IF(storeFile.empty(), "A store is needed, see --store");
+    auto reader = Create<KpiStoreReader>(storeFile);
+    const auto& columns = reader->GetColumns();
+
+    std::vector<size_t> selected;
+    if (columnList.empty())
+    {
+        std::cerr << storeFile << ": " << reader->GetBlocks().size() << " blocks, "
+                  << reader->GetSize() << " bytes, columns:";
+        for (size_t i = 0; i < columns.size(); i++)
+        {
+            selected.push_back(i);
+            std::cerr << " " << columns[i].name
+                      << (columns[i].type == KpiStoreWriter::INT ? "(int)" : "(double)");
+        }
+        std::cerr << std::endl;
+    }
+    else
+    {
+        std::istringstream names(columnList);
+        std::string name;
+        while (std::getline(names, name, ','))
+        {
+            int column = reader->FindColumn(name);
+            NS_ABORT_MSG_IF(column < 0, "No column " << name << " in " << storeFile);
+            selected.push_back(column);
+        }
+    }
+
+    std::ofstream file;
+    if (!outputFile.empty())
+    {
+        file.open(outputFile);
+        NS_ABORT_MSG_UNLESS(file.is_open(), "Can't open file " << outputFile);
+    }
+    std::ostream& out = outputFile.empty() ? std::cout : file;
+    out.precision(precision);
+
+    out << "timestamp,cellId";
+    for (size_t column : selected)
+    {
+        out << "," << columns[column].name;
+    }
+    out << "\n";
+
+    std::vector<int64_t> timestamps;
+    std::vector<std::vector<double>> values(selected.size());
+    uint64_t rows = 0;
+    for (size_t block : reader->FindBlocks(from, to, cellId))
+    {
+        reader->ReadTimestamps(block, timestamps);
+        for (size_t i = 0; i < selected.size(); i++)
+        {
+            reader->ReadColumn(block, selected[i], values[i]);
+        }
+
+        uint16_t blockCellId = reader->GetBlocks()[block].cellId;
+        for (size_t row = 0; row < timestamps.size(); row++)
+        {
+            if (timestamps[row] < from || timestamps[row] > to)
+            {
+                continue;
+            }
+            out << timestamps[row] << "," << blockCellId;
+            for (size_t i = 0; i < selected.size(); i++)
+            {
+                if (columns[selected[i]].type == KpiStoreWriter::INT)
+                {
+                    out << "," << std::llround(values[i][row]);
+                }
+                else
+                {
+                    out << "," << values[i][row];
+                }
+            }
+            out << "\n";
+            rows++;
+        }
+    }
+    out.flush();
+    std::cerr << "Exported " << rows << " rows" << std::endl;
+    return 0;
+}
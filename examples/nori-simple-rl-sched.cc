@@ -57,6 +57,7 @@ main(int argc, char* argv[])
     uint16_t gNbNum = 1;
     uint16_t ueNumPergNb = 4;
     std::string ipE2TermRic = "10.244.0.33";
+    std::string policyPlugin = "";
     uint16_t slice1Ues = 2; // Other UEs are assigned to slice 2
     bool logging = false;
 
@@ -112,6 +113,9 @@ main(int argc, char* argv[])
                  "If set to true it enables Ofdma scheduler. Default value is false (Tdma)",
                  enableOfdma);
     cmd.AddValue("ipE2TermRic", "Ip address of the E2 termination", ipE2TermRic);
+    cmd.AddValue("policyPlugin",
+                 "Path of an in-process slicing policy plugin, used instead of the RIC",
+                 policyPlugin);
 
     cmd.Parse(argc, argv);
 
@@ -389,6 +393,7 @@ main(int argc, char* argv[])
 
     auto e2 = CreateObject<E2TermHelper>();
     e2->SetAttribute("E2TermIp", StringValue(ipE2TermRic));
+    e2->SetAttribute("PolicyPlugin", StringValue(policyPlugin));
     e2->InstallE2Term(gnbNetDev);
 
     // The filter for the low-latency traffic
@@ -0,0 +1,79 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+/**
+ * @file
+ * Minimal in-process slicing policy.
+ *
+ * Gives every slice a minimum share proportional to the PRBs it used in the last
+ * period, and lets all slices borrow up to the whole carrier. The optional config
+ * string sets the guaranteed floor of each slice, in percent (default 10).
+ */
+
+#include "nori-policy-plugin.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+
+struct Policy
+{
+    int32_t floor; //!< Minimum PRB percentage guaranteed to any slice
+};
+
+} // namespace
+
+extern "C"
+{
+    uint32_t nori_policy_abi_version(void)
+    {
+        return NORI_POLICY_ABI_VERSION;
+    }
+
+    void* nori_policy_create(uint16_t /* cellId */, const char* config)
+    {
+        auto policy = new Policy{10};
+        if (config != nullptr && config[0] != '\0')
+        {
+            policy->floor =
+                static_cast<int32_t>(std::clamp(std::strtol(config, nullptr, 10), 0L, 50L));
+        }
+        return policy;
+    }
+
+    uint32_t nori_policy_decide(void* instance,
+                                const nori_kpi_snapshot* snapshot,
+                                nori_slice_quota* quotas,
+                                uint32_t maxQuotas)
+    {
+        auto policy = static_cast<Policy*>(instance);
+
+        double totalUsage = 0;
+        for (uint32_t i = 0; i < snapshot->numSlices; i++)
+        {
+            totalUsage += snapshot->slices[i].dlPrbUsage;
+        }
+        if (totalUsage <= 0 || snapshot->numSlices > maxQuotas)
+        {
+            return 0;
+        }
+
+        int64_t shared =
+            std::max<int64_t>(0, 100 - policy->floor * static_cast<int64_t>(snapshot->numSlices));
+        for (uint32_t i = 0; i < snapshot->numSlices; i++)
+        {
+            const auto& slice = snapshot->slices[i];
+            auto share = static_cast<int32_t>(shared * slice.dlPrbUsage / totalUsage);
+            quotas[i] = {slice.sliceId, 100, policy->floor + share, 0};
+        }
+        return snapshot->numSlices;
+    }
+
+    void nori_policy_destroy(void* instance)
+    {
+        delete static_cast<Policy*>(instance);
+    }
+}
@@ -73,9 +73,9 @@ BuildAndSendReportMessage(E2Termination::RicSubscriptionRequest_rval_s params)
 
     Ptr<KpmIndicationMessage> msg = Create<KpmIndicationMessage>(msgValues);
 
-    E2AP_PDU* pdu_cuup_ue = new E2AP_PDU;
+    E2AP_PDU pdu_cuup_ue{};
     encoding::generate_e2apv1_indication_request_parameterized(
-        pdu_cuup_ue,
+        &pdu_cuup_ue,
         params.requestorId,
         params.instanceId,
         params.ranFuncionId,
@@ -85,8 +85,7 @@ BuildAndSendReportMessage(E2Termination::RicSubscriptionRequest_rval_s params)
         header->m_size,             // size of the encoded header
         (uint8_t*)msg->m_buffer,    // buffer containing the encoded message
         msg->m_size);               // size of the encoded message
-    e2Term->SendE2Message(pdu_cuup_ue);
-    delete pdu_cuup_ue;
+    e2Term->SendE2Message(&pdu_cuup_ue);
 }
 
 /**
@@ -101,13 +100,18 @@ KpmSubscriptionCallback(E2AP_PDU_t* sub_req_pdu)
 {
     NS_LOG_UNCOND("\n\nReceived RIC Subscription Request");
 
-    E2Termination::RicSubscriptionRequest_rval_s params =
+    E2Termination::RicSubscriptionRequest_s request =
         e2Term->ProcessRicSubscriptionRequest(sub_req_pdu);
-    NS_LOG_UNCOND("requestorId " << +params.requestorId << ", instanceId " << +params.instanceId
-                                 << ", ranFuncionId " << +params.ranFuncionId << ", actionId "
-                                 << +params.actionId);
+    e2Term->SendRicSubscriptionResponse(request);
 
-    BuildAndSendReportMessage(params);
+    for (const auto& params : request.actions)
+    {
+        NS_LOG_UNCOND("requestorId " << +params.requestorId << ", instanceId "
+                                     << +params.instanceId << ", ranFuncionId "
+                                     << +params.ranFuncionId << ", actionId " << +params.actionId);
+
+        BuildAndSendReportMessage(params);
+    }
 }
 
 /**
@@ -2,6 +2,7 @@
 
 #include "ns3/E2-report.h"
 #include "ns3/antenna-module.h"
+#include "ns3/boolean.h"
 #include "ns3/config-store.h"
 #include "ns3/config.h"
 #include "ns3/core-module.h"
@@ -20,6 +21,7 @@
 #include "ns3/object-map.h"
 #include "ns3/object.h"
 #include "ns3/oran-interface.h"
+#include "ns3/pdu-dump.h"
 #include "ns3/pointer.h"
 #include "ns3/simulator.h"
 #include "ns3/string.h"
@@ -63,7 +65,83 @@ E2TermHelper::GetTypeId()
                                           "The first port number for the local bind",
                                           UintegerValue(38470),
                                           MakeUintegerAccessor(&E2TermHelper::m_e2localPort),
-                                          MakeUintegerChecker<uint16_t>());
+                                          MakeUintegerChecker<uint16_t>())
+                            .AddAttribute("PolicyPlugin",
+                                          "Path of an in-process slicing policy plugin. If set, "
+                                          "no E2 termination is created and the plugin drives "
+                                          "the slicing scheduler directly",
+                                          StringValue(""),
+                                          MakeStringAccessor(&E2TermHelper::m_policyPlugin),
+                                          MakeStringChecker())
+                            .AddAttribute("PolicyPluginConfig",
+                                          "Opaque configuration string passed to the policy plugin",
+                                          StringValue(""),
+                                          MakeStringAccessor(&E2TermHelper::m_policyPluginConfig),
+                                          MakeStringChecker())
+                            .AddAttribute("ShmName",
+                                          "Prefix of the shared memory rings used to talk to a "
+                                          "local agent instead of the RIC; the cell ID is "
+                                          "appended. If empty, SCTP through e2sim is used",
+                                          StringValue(""),
+                                          MakeStringAccessor(&E2TermHelper::m_shmName),
+                                          MakeStringChecker())
+                            .AddAttribute("ShmRawKpi",
+                                          "Stream raw KPI snapshots through shared memory every "
+                                          "E2 period, instead of E2AP encoded KPM indications",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&E2TermHelper::m_shmRawKpi),
+                                          MakeBooleanChecker())
+                            .AddAttribute("BearerStatsFilePrefix",
+                                          "Prefix of the files where the E2 PDCP and RLC bearer "
+                                          "stats are written every window. Empty keeps them in "
+                                          "memory only",
+                                          StringValue(""),
+                                          MakeStringAccessor(
+                                              &E2TermHelper::m_bearerStatsFilePrefix),
+                                          MakeStringChecker())
+                            .AddAttribute("RecordFile",
+                                          "Binary log where the encoded E2AP indications are "
+                                          "appended, to run without a RIC: every gNB reports "
+                                          "all the KPM measurements on the E2 period. Empty "
+                                          "connects to the RIC",
+                                          StringValue(""),
+                                          MakeStringAccessor(&E2TermHelper::m_recordFile),
+                                          MakeStringChecker())
+                            .AddAttribute("KpiStorePrefix",
+                                          "Prefix of the columnar stores where the DU KPIs are "
+                                          "written every time they are reported, "
+                                          "<prefix>-cell.kpi and <prefix>-ue.kpi, instead of "
+                                          "metrics_du.csv and ml_slice_interface.csv. Empty "
+                                          "disables them",
+                                          StringValue(""),
+                                          MakeStringAccessor(&E2TermHelper::m_kpiStorePrefix),
+                                          MakeStringChecker())
+                            .AddAttribute("KpiHistoryDepth",
+                                          "Number of DU KPI reports kept in memory for each cell "
+                                          "and each UE, see E2Interface::GetUeKpiHistory. 0 "
+                                          "disables the histories",
+                                          UintegerValue(0),
+                                          MakeUintegerAccessor(&E2TermHelper::m_kpiHistoryDepth),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("KpiHistorySocket",
+                                          "Path of a Unix socket where the KPI histories are "
+                                          "served to local clients, see KpiHistoryServer. Empty "
+                                          "disables it",
+                                          StringValue(""),
+                                          MakeStringAccessor(&E2TermHelper::m_kpiHistorySocket),
+                                          MakeStringChecker())
+                            .AddAttribute("PduDumpFile",
+                                          "File where the XER dumps of the E2AP and E2SM PDUs "
+                                          "are written in the background. Empty disables it",
+                                          StringValue(""),
+                                          MakeStringAccessor(&E2TermHelper::m_pduDumpFile),
+                                          MakeStringChecker())
+                            .AddAttribute("PduDumpRing",
+                                          "Number of recent XER dumps of the E2AP and E2SM PDUs "
+                                          "kept in memory, see PduDump::PrintRing. 0 disables it",
+                                          UintegerValue(0),
+                                          MakeUintegerAccessor(&E2TermHelper::m_pduDumpRing),
+                                          MakeUintegerChecker<uint32_t>());
     return tid;
 }
 
@@ -72,11 +150,23 @@ E2TermHelper::InstallE2Term(Ptr<NetDevice> NetDevice)
 {
     NS_LOG_FUNCTION(this);
 
+    // The dumps are shared by all the E2 nodes
+    if (!m_pduDumpEnabled)
+    {
+        if (!m_pduDumpFile.empty())
+        {
+            PduDump::EnableFile(m_pduDumpFile);
+        }
+        if (m_pduDumpRing > 0)
+        {
+            PduDump::EnableRing(m_pduDumpRing);
+        }
+        m_pduDumpEnabled = true;
+    }
+
     // Create E2 messages scheduling
     auto e2Messages = CreateObject<E2Interface>(NetDevice);
 
-    m_e2Report = e2Messages->GetE2DuCalculator();
-
     // NetDevice is a gNB or eNB
     auto nrGnbNetDev = DynamicCast<NrGnbNetDevice>(NetDevice);
 
@@ -112,6 +202,68 @@ E2TermHelper::InstallE2Term(Ptr<NetDevice> NetDevice)
     {
         NS_ABORT_MSG("NetDevice is not a gNB or eNB");
     }
+    // The global traces are connected once for all the gNBs, the router hands
+    // each event to the E2 node of its cell
+    if (m_router == nullptr)
+    {
+        m_router = Create<E2TraceRouter>();
+        m_router->ConnectTraces();
+    }
+    m_router->AddGnb(NetDevice, e2Messages);
+
+    if (!m_kpiStorePrefix.empty())
+    {
+        // One store of each kind for all the gNBs, the blocks are split by cell
+        if (m_cellKpiStore == nullptr)
+        {
+            m_cellKpiStore = Create<KpiStoreWriter>(m_kpiStorePrefix + "-cell.kpi",
+                                                    E2Interface::GetCellKpiColumns());
+            m_ueKpiStore = Create<KpiStoreWriter>(m_kpiStorePrefix + "-ue.kpi",
+                                                  E2Interface::GetUeKpiColumns());
+            Simulator::ScheduleDestroy(&KpiStoreWriter::Close, m_cellKpiStore);
+            Simulator::ScheduleDestroy(&KpiStoreWriter::Close, m_ueKpiStore);
+        }
+        e2Messages->SetKpiStores(m_cellKpiStore, m_ueKpiStore);
+    }
+
+    if (m_kpiHistoryDepth > 0)
+    {
+        // Shared by all the gNBs, so that the history of a UE survives its handovers
+        if (m_cellKpiHistory == nullptr)
+        {
+            auto names = [](const std::vector<KpiStoreWriter::Column>& columns) {
+                std::vector<std::string> kpis;
+                for (const auto& column : columns)
+                {
+                    kpis.push_back(column.name);
+                }
+                return kpis;
+            };
+            m_cellKpiHistory =
+                Create<KpiHistory>(names(E2Interface::GetCellKpiColumns()), m_kpiHistoryDepth);
+            m_ueKpiHistory =
+                Create<KpiHistory>(names(E2Interface::GetUeKpiColumns()), m_kpiHistoryDepth);
+            if (!m_kpiHistorySocket.empty())
+            {
+                m_kpiHistoryServer = Create<KpiHistoryServer>(m_kpiHistorySocket,
+                                                              m_cellKpiHistory,
+                                                              m_ueKpiHistory);
+                Simulator::ScheduleDestroy(&KpiHistoryServer::Stop, m_kpiHistoryServer);
+            }
+        }
+        e2Messages->SetKpiHistories(m_cellKpiHistory, m_ueKpiHistory);
+    }
+
+    if (!m_policyPlugin.empty())
+    {
+        // Close the loop in process, the KPIs never leave the simulator
+        e2Messages->SetAttribute("PolicyPlugin", StringValue(m_policyPlugin));
+        e2Messages->SetAttribute("PolicyPluginConfig", StringValue(m_policyPluginConfig));
+        Simulator::Schedule(MicroSeconds(0), &E2Interface::StartPolicyPlugin, e2Messages);
+        NetDevice->AggregateObject(e2Messages);
+        return;
+    }
+
     // Assert that configuration was properly set
     //NS_ASSERT(plmnId == "00101" && cellId != 0 && localPort != 0);
     printf("E2TermHelper: PLMN ID %s, Cell ID %s, Cell id int %u, Local Port %u\n",
@@ -126,18 +278,20 @@ E2TermHelper::InstallE2Term(Ptr<NetDevice> NetDevice)
                                               encodedPlmnId);
     NetDevice->AggregateObject(e2Term);
     e2Messages->SetAttribute("E2Term", PointerValue(e2Term));
-
-    // Connect PDU's packets to callback report, after UEs registration.
-    // The schedule ensures that the connection is made after the UEs are registered.
-    Simulator::Schedule(Seconds(0.2),
-                        &E2TermHelper::ConnectPDUReports,
-                        this,
-                        NetDevice,
-                        e2Messages);
-    // Connect PHY traces
-    ConnectPhyTraces();
-    // Enable SINR traces
-    EnableSinrTraces(e2Messages);
+    if (!m_shmName.empty())
+    {
+        e2Term->SetAttribute("ShmName", StringValue(m_shmName + "-" + std::to_string(cellId)));
+    }
+    if (!m_recordFile.empty())
+    {
+        // One log for all the gNBs, the frames carry the cell ID
+        if (m_recordLog == nullptr)
+        {
+            m_recordLog = Create<E2RecordLog>(m_recordFile);
+            Simulator::ScheduleDestroy(&E2RecordLog::Flush, m_recordLog);
+        }
+        e2Term->SetRecordLog(m_recordLog, cellId);
+    }
 
     // Connect E2 termination to E2 messages via KPM subscription callback
     Ptr<KpmFunctionDescription> kpmFd = Create<KpmFunctionDescription>();
@@ -156,6 +310,14 @@ E2TermHelper::InstallE2Term(Ptr<NetDevice> NetDevice)
                                                std::placeholders::_1));
 
     Simulator::Schedule(MicroSeconds(0), &E2Termination::Start, e2Term);
+    if (!m_shmName.empty() && m_shmRawKpi)
+    {
+        Simulator::Schedule(MicroSeconds(0), &E2Interface::StartKpiStream, e2Messages);
+    }
+    else if (!m_recordFile.empty())
+    {
+        Simulator::Schedule(MicroSeconds(0), &E2Interface::StartRecording, e2Messages);
+    }
 
     NetDevice->AggregateObject(e2Messages);
 }
@@ -174,10 +336,17 @@ void
 E2TermHelper::EnableE2PdcpTraces()
 {
     NS_LOG_FUNCTION(this);
+    if (m_e2PdcpStats != nullptr)
+    {
+        return;
+    }
     // Enable E2 PDCP traces
-    m_e2PdcpStats = CreateObject<NrBearerStatsCalculator>("E2PDCP");
-    m_e2PdcpStats->SetAttribute("DlPdcpOutputFilename", StringValue("DlE2PdcpStats.txt"));
-    m_e2PdcpStats->SetAttribute("UlPdcpOutputFilename", StringValue("UlE2PdcpStats.txt"));
+    m_e2PdcpStats = CreateObject<NoriBearerStats>("PDCP");
+    if (!m_bearerStatsFilePrefix.empty())
+    {
+        m_e2PdcpStats->SetAttribute("OutputFilename",
+                                    StringValue(m_bearerStatsFilePrefix + "-pdcp.txt"));
+    }
     m_e2StatsConnector.EnablePdcpStats(m_e2PdcpStats);
 }
 
@@ -185,38 +354,18 @@ void
 E2TermHelper::EnableE2RlcTraces()
 {
     NS_LOG_FUNCTION(this);
+    if (m_e2RlcStats != nullptr)
+    {
+        return;
+    }
     // Enable E2 RLC traces
-    m_e2RlcStats = CreateObject<NrBearerStatsCalculator>("E2RLC");
-    m_e2RlcStats->SetAttribute("DlRlcOutputFilename", StringValue("DlE2RlcStats.txt"));
-    m_e2RlcStats->SetAttribute("UlRlcOutputFilename", StringValue("UlE2RlcStats.txt"));
+    m_e2RlcStats = CreateObject<NoriBearerStats>("RLC");
+    if (!m_bearerStatsFilePrefix.empty())
+    {
+        m_e2RlcStats->SetAttribute("OutputFilename",
+                                   StringValue(m_bearerStatsFilePrefix + "-rlc.txt"));
+    }
     m_e2StatsConnector.EnableRlcStats(m_e2RlcStats);
 }
 
-void
-E2TermHelper::EnableSinrTraces(Ptr<E2Interface> e2Messages)
-{
-    NS_LOG_FUNCTION(this);
-    Config::ConnectFailSafe("/NodeList/*/DeviceList/*/ComponentCarrierMapUe/*/NrUePhy/DlDataSinr",
-                            MakeCallback(&E2Interface::RegisterNewSinrReadingCallback, e2Messages));
-}
-
-void
-E2TermHelper::ConnectPDUReports([[maybe_unused]] Ptr<NetDevice> NetDevice,
-                                [[maybe_unused]] Ptr<E2Interface> e2Message)
-{
-    NS_LOG_FUNCTION(this << "Connecting PDU reports in E2 interface");
-
-    Config::ConnectWithoutContext(
-        "/NodeList/*/DeviceList/*/NrGnbRrc/UeMap/*/DataRadioBearerMap/*/NrRlc/TxPDU",
-        MakeCallback(&E2Interface::ReportTxPDU, e2Message));
-}
-
-void
-E2TermHelper::ConnectPhyTraces()
-{
-    Config::Connect(
-        "/NodeList/*/DeviceList/*/ComponentCarrierMapUe/*/NrUePhy/SpectrumPhy/RxPacketTraceUe",
-        MakeCallback(&NoriE2Report::UpdateTraces, m_e2Report));
-}
-
 } // namespace ns3
@@ -7,6 +7,8 @@
 #pragma once
 
 #include "ns3/E2-interface.h"
+#include "ns3/e2-trace-router.h"
+#include "ns3/nori-bearer-stats.h"
 #include "ns3/lte-enb-net-device.h"
 #include "ns3/net-device-container.h"
 #include "ns3/net-device.h"
@@ -57,38 +59,21 @@ class E2TermHelper : public Object
      */
     void InstallE2Term(NetDeviceContainer& NetDevices);
 
-    /**
-     * @brief Enable SINR traces
-     * @param e2Messages A pointer to the E2 interface
-     */
-    void EnableSinrTraces(Ptr<E2Interface> e2Messages);
-
   private:
     /***
-     * @brief Enable E2 RLC traces and report for LTE and NR cells.
+     * @brief Enable E2 RLC traces and report for LTE and NR cells, shared by all
+     * the E2 nodes. Done once.
      */
     void EnableE2RlcTraces();
 
     /***
-     * @brief Enable E2 PDCP traces and report for LTE and NR cells.
+     * @brief Enable E2 PDCP traces and report for LTE and NR cells, shared by all
+     * the E2 nodes. Done once.
      */
     void EnableE2PdcpTraces();
 
-    /**
-     * @brief Connect PDU reports to the E2 termination
-     * @param NetDevice the net device that provides the PDU information.
-     * @param e2Messages the E2 interface that will receive the PDU information.
-     */
-    void ConnectPDUReports(Ptr<NetDevice> NetDevice, Ptr<E2Interface> e2Messages);
-
-    /**
-     * @brief Connect PHY traces to the E2
-     *
-     */
-    void ConnectPhyTraces();
-
-    Ptr<NrBearerStatsCalculator> m_e2RlcStats;     // !< E2 RLC stats
-    Ptr<NrBearerStatsCalculator> m_e2PdcpStats;    // !< E2 PDCP stats
+    Ptr<NoriBearerStats> m_e2RlcStats;             // !< E2 RLC stats
+    Ptr<NoriBearerStats> m_e2PdcpStats;            // !< E2 PDCP stats
     Ptr<NrBearerStatsCalculator> m_e2LteRlcStats;  // !< E2 LTE RLC stats
     Ptr<NrBearerStatsCalculator> m_e2LtePdcpStats; // !< E2 LTE PDCP stats
 
@@ -99,13 +84,45 @@ class E2TermHelper : public Object
     uint16_t m_e2port;      // !< E2 termination port
     uint16_t m_e2localPort; // !< E2 termination local port
 
+    // In-process policy attributes
+    std::string m_policyPlugin;       // !< Policy plugin path, empty to use the RIC
+    std::string m_policyPluginConfig; // !< Policy plugin configuration
+
+    // Shared memory transport attributes
+    std::string m_shmName; // !< Prefix of the shared memory rings, empty to use SCTP
+    bool m_shmRawKpi;      // !< Stream raw KPI snapshots instead of KPM indications
+
+    // Bearer stats attributes
+    std::string m_bearerStatsFilePrefix; // !< Prefix of the bearer stats files, empty to disable
+
+    // Offline recording attributes
+    std::string m_recordFile;     // !< Log of the encoded indications, empty to use the RIC
+    Ptr<E2RecordLog> m_recordLog; // !< Log shared by all the E2 nodes
+
+    // KPI store attributes
+    std::string m_kpiStorePrefix;       // !< Prefix of the KPI stores, empty to disable
+    Ptr<KpiStoreWriter> m_cellKpiStore; // !< Cell KPI store shared by all the E2 nodes
+    Ptr<KpiStoreWriter> m_ueKpiStore;   // !< UE KPI store shared by all the E2 nodes
+
+    // KPI history attributes
+    uint32_t m_kpiHistoryDepth;               // !< Reports kept per cell and UE, 0 to disable
+    std::string m_kpiHistorySocket;           // !< Socket serving the histories, empty if none
+    Ptr<KpiHistory> m_cellKpiHistory;         // !< Cell KPI history shared by the E2 nodes
+    Ptr<KpiHistory> m_ueKpiHistory;           // !< UE KPI history shared by the E2 nodes
+    Ptr<KpiHistoryServer> m_kpiHistoryServer; // !< Socket server, null if disabled
+
+    // PDU dump attributes
+    std::string m_pduDumpFile;    // !< File receiving the XER dumps, empty to disable
+    uint32_t m_pduDumpRing;       // !< Recent XER dumps kept in memory, 0 to disable
+    bool m_pduDumpEnabled{false}; // !< Whether the dump sinks were enabled
+
     // E2 messages attributes
     bool m_e2ForceLog;  // !< E2 force log
     bool m_standardLog; // !< E2 standard message log
 
     Ptr<E2Termination> m_e2Term;    // !< E2 termination
     Ptr<E2Interface> m_e2Interface; // !< E2 interface
-    Ptr<NoriE2Report> m_e2Report;   // !< E2 report
+    Ptr<E2TraceRouter> m_router;    // !< Routes the PHY, SINR and RLC traces to the cells
 };
 
 } // namespace ns3
@@ -0,0 +1,74 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "e2-trace-router.h"
+
+#include "ns3/abort.h"
+#include "ns3/config.h"
+#include "ns3/log.h"
+#include "ns3/nr-gnb-net-device.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("E2TraceRouter");
+
+void
+E2TraceRouter::AddGnb(Ptr<NetDevice> netDevice, Ptr<E2Interface> e2Interface)
+{
+    NS_LOG_FUNCTION(this << netDevice << e2Interface);
+    auto gnbDev = DynamicCast<NrGnbNetDevice>(netDevice);
+    NS_ABORT_MSG_IF(gnbDev == nullptr, "NetDevice is not a gNB");
+
+    // A gNB has one cell per bandwidth part
+    for (auto cellId : gnbDev->GetCellIds())
+    {
+        NS_ABORT_MSG_IF(m_cellInterfaces.count(cellId) > 0,
+                        "Cell " << cellId << " already has an E2 node");
+        m_cellInterfaces[cellId] = e2Interface;
+        m_cellReports[cellId] = e2Interface->GetE2DuCalculator();
+    }
+}
+
+void
+E2TraceRouter::ConnectTraces()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_tracesConnected)
+    {
+        return;
+    }
+    Config::ConnectFailSafe("/NodeList/*/DeviceList/*/ComponentCarrierMapUe/*/NrUePhy/DlDataSinr",
+                            MakeCallback(&E2TraceRouter::RouteSinr, Ptr<E2TraceRouter>(this)));
+    Config::Connect(
+        "/NodeList/*/DeviceList/*/ComponentCarrierMapUe/*/NrUePhy/SpectrumPhy/RxPacketTraceUe",
+        MakeCallback(&E2TraceRouter::RouteRxPacket, Ptr<E2TraceRouter>(this)));
+    m_tracesConnected = true;
+}
+
+void
+E2TraceRouter::RouteSinr(std::string path,
+                         uint16_t cellId,
+                         uint16_t rnti,
+                         double avgSinr,
+                         uint16_t bwpId)
+{
+    auto it = m_cellInterfaces.find(cellId);
+    if (it != m_cellInterfaces.end())
+    {
+        it->second->RegisterNewSinrReadingCallback(path, cellId, rnti, avgSinr, bwpId);
+    }
+}
+
+void
+E2TraceRouter::RouteRxPacket(std::string path, RxPacketTraceParams params)
+{
+    auto it = m_cellReports.find(params.m_cellId);
+    if (it != m_cellReports.end())
+    {
+        it->second->UpdateTraces(path, params);
+    }
+}
+
+} // namespace ns3
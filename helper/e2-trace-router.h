@@ -0,0 +1,68 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include "ns3/E2-interface.h"
+#include "ns3/E2-report.h"
+#include "ns3/net-device.h"
+#include "ns3/nr-phy-mac-common.h"
+#include "ns3/simple-ref-count.h"
+
+#include <unordered_map>
+
+namespace ns3
+{
+
+/**
+ * @brief Dispatch the PHY, SINR and RLC traces of the whole simulation to the E2
+ * node of the cell they belong to.
+ *
+ * The global trace sources are connected once, whatever the number of gNBs, and
+ * each event is looked up by cell ID instead of being delivered to every E2 node.
+ * The RLC traces are not routed: each E2 node connects the DRBs of its own cell.
+ */
+class E2TraceRouter : public SimpleRefCount<E2TraceRouter>
+{
+  public:
+    /**
+     * @brief Route the events of the cells of a gNB to its E2 node
+     * @param netDevice the gNB net device
+     * @param e2Interface the E2 interface installed on it
+     */
+    void AddGnb(Ptr<NetDevice> netDevice, Ptr<E2Interface> e2Interface);
+
+    /**
+     * @brief Connect the global trace sources, once
+     */
+    void ConnectTraces();
+
+  private:
+    /**
+     * @brief Route a DL data SINR reading of a UE
+     * @param path the trace path
+     * @param cellId the serving cell
+     * @param rnti the RNTI of the UE
+     * @param avgSinr the average SINR
+     * @param bwpId the bandwidth part
+     */
+    void RouteSinr(std::string path,
+                   uint16_t cellId,
+                   uint16_t rnti,
+                   double avgSinr,
+                   uint16_t bwpId);
+
+    /**
+     * @brief Route a received packet trace of a UE PHY
+     * @param path the trace path
+     * @param params the trace parameters, holding the cell ID
+     */
+    void RouteRxPacket(std::string path, RxPacketTraceParams params);
+
+    std::unordered_map<uint16_t, Ptr<E2Interface>> m_cellInterfaces; //!< E2 nodes by cell ID
+    std::unordered_map<uint16_t, Ptr<NoriE2Report>> m_cellReports;   //!< E2 reports by cell ID
+    bool m_tracesConnected{false}; //!< Whether the traces are connected
+};
+
+} // namespace ns3
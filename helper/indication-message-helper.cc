@@ -15,6 +15,8 @@
 
 #include "indication-message-helper.h"
 
+#include <iterator>
+
 namespace ns3
 {
 
@@ -69,10 +71,60 @@ IndicationMessageHelper::~IndicationMessageHelper()
 {
 }
 
+void
+IndicationMessageHelper::AddReportTag(const std::string& name, long value)
+{
+    if (!m_msgValues.m_cellMeasurementItems)
+    {
+        m_msgValues.m_cellMeasurementItems = Create<MeasurementItemList>();
+    }
+    m_msgValues.m_cellMeasurementItems->AddItem<long>(name, value);
+    m_reportTags.emplace_back(name, value);
+}
+
 Ptr<KpmIndicationMessage>
 IndicationMessageHelper::CreateIndicationMessage()
 {
     return Create<KpmIndicationMessage>(m_msgValues);
 }
 
+Ptr<KpmIndicationMessage>
+IndicationMessageHelper::CreateIndicationMessage(size_t firstUe,
+                                                 size_t numUes,
+                                                 uint32_t segment,
+                                                 uint32_t numSegments)
+{
+    NS_ABORT_MSG_IF(firstUe + numUes > m_msgValues.m_ueIndications.size(),
+                    "Segment out of the UE items");
+
+    KpmIndicationMessage::KpmIndicationMessageValues values;
+    values.m_cellObjectId = m_msgValues.m_cellObjectId;
+    values.m_cellMeasurementItems = Create<MeasurementItemList>();
+    if (firstUe == 0)
+    {
+        // The cell level values are reported once, by the first segment
+        values.m_pmContainerValues = m_msgValues.m_pmContainerValues;
+        if (m_msgValues.m_cellMeasurementItems)
+        {
+            for (const auto& item : m_msgValues.m_cellMeasurementItems->GetItems())
+            {
+                values.m_cellMeasurementItems->AddItem(item);
+            }
+        }
+    }
+    else
+    {
+        for (const auto& [name, value] : m_reportTags)
+        {
+            values.m_cellMeasurementItems->AddItem<long>(name, value);
+        }
+    }
+    values.m_cellMeasurementItems->AddItem<long>("Report.SegmentIndex", segment);
+    values.m_cellMeasurementItems->AddItem<long>("Report.SegmentCount", numSegments);
+
+    auto first = std::next(m_msgValues.m_ueIndications.begin(), firstUe);
+    values.m_ueIndications.insert(first, std::next(first, numUes));
+    return Create<KpmIndicationMessage>(values);
+}
+
 } // namespace ns3
@@ -35,11 +35,62 @@ class IndicationMessageHelper : public Object
 
     Ptr<KpmIndicationMessage> CreateIndicationMessage();
 
+    /**
+     * Encode a segment of the message, carrying only part of the UE items. The PM
+     * container and the cell measurement items are only carried by the first segment.
+     * Every segment carries the report tags, and its index and the number of segments
+     * as the Report.SegmentIndex and Report.SegmentCount items.
+     * @param firstUe index of the first UE item of the segment
+     * @param numUes number of UE items in the segment
+     * @param segment index of the segment, from 1
+     * @param numSegments number of segments of the message
+     * @return the encoded segment
+     */
+    Ptr<KpmIndicationMessage> CreateIndicationMessage(size_t firstUe,
+                                                      size_t numUes,
+                                                      uint32_t segment,
+                                                      uint32_t numSegments);
+
+    /**
+     * @return the number of UE items added to the message
+     */
+    size_t GetNumUeItems() const
+    {
+        return m_msgValues.m_ueIndications.size();
+    }
+
     const bool& IsOffline() const
     {
         return m_offline;
     }
 
+    /**
+     * Restrict the measurements added to the message
+     * @param measurementMask the mask of KpmMeasurementGroup to report
+     */
+    void SetMeasurementMask(uint64_t measurementMask)
+    {
+        m_measurementMask = measurementMask;
+    }
+
+    /**
+     * Tag the message with a property of the whole report, such as the length of the
+     * window its KPIs were measured on. The tag is a cell measurement item carried by
+     * every segment.
+     * @param name the measurement name
+     * @param value the value
+     */
+    void AddReportTag(const std::string& name, long value);
+
+    /**
+     * @param group a KpmMeasurementGroup
+     * @return true if any measurement of the group has to be reported
+     */
+    bool IsRequested(uint64_t group) const
+    {
+        return (m_measurementMask & group) != 0;
+    }
+
   protected:
     void FillBaseCuUpValues(std::string plmId);
 
@@ -48,6 +99,8 @@ class IndicationMessageHelper : public Object
     IndicationMessageType m_type;
     bool m_offline;
     bool m_reducedPmValues;
+    uint64_t m_measurementMask{KPM_MEAS_ALL};
+    std::vector<std::pair<std::string, long>> m_reportTags; //!< Items repeated in segments
     KpmIndicationMessage::KpmIndicationMessageValues m_msgValues;
     Ptr<OCuUpContainerValues> m_cuUpValues;
     Ptr<OCuCpContainerValues> m_cuCpValues;
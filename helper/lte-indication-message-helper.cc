@@ -36,7 +36,7 @@ LteIndicationMessageHelper::AddCuUpUePmItem(std::string ueImsiComplete,
 {
     Ptr<MeasurementItemList> ueVal = Create<MeasurementItemList>(ueImsiComplete);
 
-    if (!m_reducedPmValues)
+    if (!m_reducedPmValues && IsRequested(KPM_MEAS_PDCP))
     {
         // UE-specific PDCP SDU volume from LTE eNB. Unit is Mbits
         ueVal->AddItem<long>("DRB.PdcpSduVolumeDl_Filter.UEID", txBytes);
@@ -57,7 +57,7 @@ LteIndicationMessageHelper::AddCuUpUePmItem(std::string ueImsiComplete,
 void
 LteIndicationMessageHelper::AddCuUpCellPmItem(double cellAverageLatency)
 {
-    if (!m_reducedPmValues)
+    if (!m_reducedPmValues && IsRequested(KPM_MEAS_PDCP))
     {
         Ptr<MeasurementItemList> cellVal = Create<MeasurementItemList>();
         cellVal->AddItem<double>("DRB.PdcpSduDelayDl", cellAverageLatency);
@@ -83,7 +83,7 @@ void
 LteIndicationMessageHelper::AddCuCpUePmItem(std::string ueImsiComplete, long numDrb, long drbRelAct)
 {
     Ptr<MeasurementItemList> ueVal = Create<MeasurementItemList>(ueImsiComplete);
-    if (!m_reducedPmValues)
+    if (!m_reducedPmValues && IsRequested(KPM_MEAS_DRB))
     {
         ueVal->AddItem<long>("DRB.EstabSucc.5QI.UEID", numDrb);
         ueVal->AddItem<long>("DRB.RelActNbr.5QI.UEID", drbRelAct); // not modeled in the simulator
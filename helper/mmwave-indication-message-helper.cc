@@ -32,7 +32,7 @@ MmWaveIndicationMessageHelper::AddCuUpUePmItem(std::string ueImsiComplete,
                                                double pdcpThroughput)
 {
     Ptr<MeasurementItemList> ueVal = Create<MeasurementItemList>(ueImsiComplete);
-    if (!m_reducedPmValues)
+    if (!m_reducedPmValues && IsRequested(KPM_MEAS_PDCP))
     {
         // UE-specific PDCP PDU volume transmitted to NR gNB (Unit is Kbits)
         ueVal->AddItem<long>("QosFlow.PdcpPduVolumeDL_Filter.UEID", txPdcpPduBytesNrRlc);
@@ -94,34 +94,52 @@ MmWaveIndicationMessageHelper::AddDuUePmItem(std::string ueImsiComplete,
     Ptr<MeasurementItemList> ueVal = Create<MeasurementItemList>(ueImsiComplete);
     if (!m_reducedPmValues)
     {
-        ueVal->AddItem<long>("TB.TotNbrDl.1.UEID", macPduUe);
-        ueVal->AddItem<long>("TB.TotNbrDlInitial.UEID", macPduInitialUe);
-        ueVal->AddItem<long>("TB.TotNbrDlInitial.Qpsk.UEID", macQpsk);
-        ueVal->AddItem<long>("TB.TotNbrDlInitial.16Qam.UEID", mac16Qam);
-        ueVal->AddItem<long>("TB.TotNbrDlInitial.64Qam.UEID", mac64Qam);
-        ueVal->AddItem<long>("TB.ErrTotalNbrDl.1.UEID", macRetx);
+        if (IsRequested(KPM_MEAS_TB))
+        {
+            ueVal->AddItem<long>("TB.TotNbrDl.1.UEID", macPduUe);
+            ueVal->AddItem<long>("TB.TotNbrDlInitial.UEID", macPduInitialUe);
+            ueVal->AddItem<long>("TB.TotNbrDlInitial.Qpsk.UEID", macQpsk);
+            ueVal->AddItem<long>("TB.TotNbrDlInitial.16Qam.UEID", mac16Qam);
+            ueVal->AddItem<long>("TB.TotNbrDlInitial.64Qam.UEID", mac64Qam);
+            ueVal->AddItem<long>("TB.ErrTotalNbrDl.1.UEID", macRetx);
+        }
         //ueVal->AddItem<long>("QosFlow.PdcpPduVolumeDL_Filter.UEID", macVolume);
-        ueVal->AddItem<long>("RRU.PrbUsedDl.UEID", (long)std::ceil(macPrb));
-        ueVal->AddItem<long>("CARR.PDSCHMCSDist.Bin1.UEID", macMac04);
-        ueVal->AddItem<long>("CARR.PDSCHMCSDist.Bin2.UEID", macMac59);
-        ueVal->AddItem<long>("CARR.PDSCHMCSDist.Bin3.UEID", macMac1014);
-        ueVal->AddItem<long>("CARR.PDSCHMCSDist.Bin4.UEID", macMac1519);
-        ueVal->AddItem<long>("CARR.PDSCHMCSDist.Bin5.UEID", macMac2024);
-        ueVal->AddItem<long>("CARR.PDSCHMCSDist.Bin6.UEID", macMac2529);
-        ueVal->AddItem<long>("L1M.RS-SINR.Bin34.UEID", macSinrBin1);
-        ueVal->AddItem<long>("L1M.RS-SINR.Bin46.UEID", macSinrBin2);
-        ueVal->AddItem<long>("L1M.RS-SINR.Bin58.UEID", macSinrBin3);
-        ueVal->AddItem<long>("L1M.RS-SINR.Bin70.UEID", macSinrBin4);
-        ueVal->AddItem<long>("L1M.RS-SINR.Bin82.UEID", macSinrBin5);
-        ueVal->AddItem<long>("L1M.RS-SINR.Bin94.UEID", macSinrBin6);
-        ueVal->AddItem<long>("L1M.RS-SINR.Bin127.UEID", macSinrBin7);
-        ueVal->AddItem<long>("DRB.BufferSize.Qos.UEID", rlcBufferOccup);
+        if (IsRequested(KPM_MEAS_PRB))
+        {
+            ueVal->AddItem<long>("RRU.PrbUsedDl.UEID", (long)std::ceil(macPrb));
+        }
+        if (IsRequested(KPM_MEAS_MCS))
+        {
+            ueVal->AddItem<long>("CARR.PDSCHMCSDist.Bin1.UEID", macMac04);
+            ueVal->AddItem<long>("CARR.PDSCHMCSDist.Bin2.UEID", macMac59);
+            ueVal->AddItem<long>("CARR.PDSCHMCSDist.Bin3.UEID", macMac1014);
+            ueVal->AddItem<long>("CARR.PDSCHMCSDist.Bin4.UEID", macMac1519);
+            ueVal->AddItem<long>("CARR.PDSCHMCSDist.Bin5.UEID", macMac2024);
+            ueVal->AddItem<long>("CARR.PDSCHMCSDist.Bin6.UEID", macMac2529);
+        }
+        if (IsRequested(KPM_MEAS_SINR_BINS))
+        {
+            ueVal->AddItem<long>("L1M.RS-SINR.Bin34.UEID", macSinrBin1);
+            ueVal->AddItem<long>("L1M.RS-SINR.Bin46.UEID", macSinrBin2);
+            ueVal->AddItem<long>("L1M.RS-SINR.Bin58.UEID", macSinrBin3);
+            ueVal->AddItem<long>("L1M.RS-SINR.Bin70.UEID", macSinrBin4);
+            ueVal->AddItem<long>("L1M.RS-SINR.Bin82.UEID", macSinrBin5);
+            ueVal->AddItem<long>("L1M.RS-SINR.Bin94.UEID", macSinrBin6);
+            ueVal->AddItem<long>("L1M.RS-SINR.Bin127.UEID", macSinrBin7);
+        }
+        if (IsRequested(KPM_MEAS_BUFFER))
+        {
+            ueVal->AddItem<long>("DRB.BufferSize.Qos.UEID", rlcBufferOccup);
+        }
     }
 
     // This value is not requested anymore, so it has been removed from the delivery, but it will be
     // still logged; ueVal->AddItem<double> ("DRB.UEThpDlPdcpBased.UEID", drbThrDlPdcpBasedUeid);
 
-    ueVal->AddItem<double>("DRB.UEThpDl.UEID", drbThrDlUeid);
+    if (IsRequested(KPM_MEAS_THROUGHPUT))
+    {
+        ueVal->AddItem<double>("DRB.UEThpDl.UEID", drbThrDlUeid);
+    }
 
     m_msgValues.m_ueIndications.insert(ueVal);
 }
@@ -153,38 +171,62 @@ MmWaveIndicationMessageHelper::AddDuCellPmItem(long macPduCellSpecific,
 {
     Ptr<MeasurementItemList> cellVal = Create<MeasurementItemList>();
 
-    if (!m_reducedPmValues)
+    if (!m_reducedPmValues && IsRequested(KPM_MEAS_TB))
     {
         cellVal->AddItem<long>("TB.TotNbrDl.1", macPduCellSpecific);
         cellVal->AddItem<long>("TB.TotNbrDlInitial", macPduInitialCellSpecific);
     }
 
-    cellVal->AddItem<long>("TB.TotNbrDlInitial.Qpsk", macQpskCellSpecific);
-    cellVal->AddItem<long>("TB.TotNbrDlInitial.16Qam", mac16QamCellSpecific);
-    cellVal->AddItem<long>("TB.TotNbrDlInitial.64Qam", mac64QamCellSpecific);
-    cellVal->AddItem<long>("RRU.PrbUsedDl", (long)std::ceil(prbUtilizationDl));
+    if (IsRequested(KPM_MEAS_TB))
+    {
+        cellVal->AddItem<long>("TB.TotNbrDlInitial.Qpsk", macQpskCellSpecific);
+        cellVal->AddItem<long>("TB.TotNbrDlInitial.16Qam", mac16QamCellSpecific);
+        cellVal->AddItem<long>("TB.TotNbrDlInitial.64Qam", mac64QamCellSpecific);
+    }
+    if (IsRequested(KPM_MEAS_PRB))
+    {
+        cellVal->AddItem<long>("RRU.PrbUsedDl", (long)std::ceil(prbUtilizationDl));
+    }
 
     if (!m_reducedPmValues)
     {
-        cellVal->AddItem<long>("TB.ErrTotalNbrDl.1", macRetxCellSpecific);
-        cellVal->AddItem<long>("QosFlow.PdcpPduVolumeDL_Filter", macVolumeCellSpecific);
-        cellVal->AddItem<long>("CARR.PDSCHMCSDist.Bin1", macMac04CellSpecific);
-        cellVal->AddItem<long>("CARR.PDSCHMCSDist.Bin2", macMac59CellSpecific);
-        cellVal->AddItem<long>("CARR.PDSCHMCSDist.Bin3", macMac1014CellSpecific);
-        cellVal->AddItem<long>("CARR.PDSCHMCSDist.Bin4", macMac1519CellSpecific);
-        cellVal->AddItem<long>("CARR.PDSCHMCSDist.Bin5", macMac2024CellSpecific);
-        cellVal->AddItem<long>("CARR.PDSCHMCSDist.Bin6", macMac2529CellSpecific);
-        cellVal->AddItem<long>("L1M.RS-SINR.Bin34", macSinrBin1CellSpecific);
-        cellVal->AddItem<long>("L1M.RS-SINR.Bin46", macSinrBin2CellSpecific);
-        cellVal->AddItem<long>("L1M.RS-SINR.Bin58", macSinrBin3CellSpecific);
-        cellVal->AddItem<long>("L1M.RS-SINR.Bin70", macSinrBin4CellSpecific);
-        cellVal->AddItem<long>("L1M.RS-SINR.Bin82", macSinrBin5CellSpecific);
-        cellVal->AddItem<long>("L1M.RS-SINR.Bin94", macSinrBin6CellSpecific);
-        cellVal->AddItem<long>("L1M.RS-SINR.Bin127", macSinrBin7CellSpecific);
-        cellVal->AddItem<long>("DRB.BufferSize.Qos", rlcBufferOccupCellSpecific);
+        if (IsRequested(KPM_MEAS_TB))
+        {
+            cellVal->AddItem<long>("TB.ErrTotalNbrDl.1", macRetxCellSpecific);
+        }
+        if (IsRequested(KPM_MEAS_PDCP))
+        {
+            cellVal->AddItem<long>("QosFlow.PdcpPduVolumeDL_Filter", macVolumeCellSpecific);
+        }
+        if (IsRequested(KPM_MEAS_MCS))
+        {
+            cellVal->AddItem<long>("CARR.PDSCHMCSDist.Bin1", macMac04CellSpecific);
+            cellVal->AddItem<long>("CARR.PDSCHMCSDist.Bin2", macMac59CellSpecific);
+            cellVal->AddItem<long>("CARR.PDSCHMCSDist.Bin3", macMac1014CellSpecific);
+            cellVal->AddItem<long>("CARR.PDSCHMCSDist.Bin4", macMac1519CellSpecific);
+            cellVal->AddItem<long>("CARR.PDSCHMCSDist.Bin5", macMac2024CellSpecific);
+            cellVal->AddItem<long>("CARR.PDSCHMCSDist.Bin6", macMac2529CellSpecific);
+        }
+        if (IsRequested(KPM_MEAS_SINR_BINS))
+        {
+            cellVal->AddItem<long>("L1M.RS-SINR.Bin34", macSinrBin1CellSpecific);
+            cellVal->AddItem<long>("L1M.RS-SINR.Bin46", macSinrBin2CellSpecific);
+            cellVal->AddItem<long>("L1M.RS-SINR.Bin58", macSinrBin3CellSpecific);
+            cellVal->AddItem<long>("L1M.RS-SINR.Bin70", macSinrBin4CellSpecific);
+            cellVal->AddItem<long>("L1M.RS-SINR.Bin82", macSinrBin5CellSpecific);
+            cellVal->AddItem<long>("L1M.RS-SINR.Bin94", macSinrBin6CellSpecific);
+            cellVal->AddItem<long>("L1M.RS-SINR.Bin127", macSinrBin7CellSpecific);
+        }
+        if (IsRequested(KPM_MEAS_BUFFER))
+        {
+            cellVal->AddItem<long>("DRB.BufferSize.Qos", rlcBufferOccupCellSpecific);
+        }
     }
 
-    cellVal->AddItem<long>("DRB.MeanActiveUeDl", activeUeDl);
+    if (IsRequested(KPM_MEAS_ACTIVE_UE))
+    {
+        cellVal->AddItem<long>("DRB.MeanActiveUeDl", activeUeDl);
+    }
 
     m_msgValues.m_cellMeasurementItems = cellVal;
 }
@@ -203,14 +245,19 @@ MmWaveIndicationMessageHelper::AddCuCpUePmItem(std::string ueImsiComplete,
                                                Ptr<L3RrcMeasurements> l3RrcMeasurementNeigh)
 {
     Ptr<MeasurementItemList> ueVal = Create<MeasurementItemList>(ueImsiComplete);
-    if (!m_reducedPmValues)
+    if (!m_reducedPmValues && IsRequested(KPM_MEAS_DRB))
     {
         ueVal->AddItem<long>("DRB.EstabSucc.5QI.UEID", numDrb);
         ueVal->AddItem<long>("DRB.RelActNbr.5QI.UEID", drbRelAct); // not modeled in the simulator
     }
 
-    ueVal->AddItem<Ptr<L3RrcMeasurements>>("HO.SrcCellQual.RS-SINR.UEID", l3RrcMeasurementServing);
-    ueVal->AddItem<Ptr<L3RrcMeasurements>>("HO.TrgtCellQual.RS-SINR.UEID", l3RrcMeasurementNeigh);
+    if (IsRequested(KPM_MEAS_L3_SINR))
+    {
+        ueVal->AddItem<Ptr<L3RrcMeasurements>>("HO.SrcCellQual.RS-SINR.UEID",
+                                               l3RrcMeasurementServing);
+        ueVal->AddItem<Ptr<L3RrcMeasurements>>("HO.TrgtCellQual.RS-SINR.UEID",
+                                               l3RrcMeasurementNeigh);
+    }
 
     m_msgValues.m_ueIndications.insert(ueVal);
 }
@@ -6,6 +6,7 @@
 
 #include "ns3/attribute.h"
 #include "ns3/bandwidth-part-gnb.h"
+#include "ns3/boolean.h"
 #include "ns3/config.h"
 #include "ns3/double.h"
 #include "ns3/log.h"
@@ -25,6 +26,9 @@
 #include "ns3/type-id.h"
 #include "ns3/uinteger.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <encode_e2apv1.hpp>
 
 namespace ns3
@@ -44,6 +48,47 @@ E2Interface::E2Interface(Ptr<NetDevice> netDev)
     m_netDev = netDev;
     m_rrc = m_netDev->GetObject<NrGnbNetDevice>()->GetRrc();
     m_e2DuCalculator = CreateObject<NoriE2Report>();
+    m_controlDecoder = Create<RicControlDecoder>();
+}
+
+void
+E2Interface::NotifyConstructionCompleted()
+{
+    NS_LOG_FUNCTION(this);
+
+    if (m_wallClockTracking || m_paceWallClock || m_lagBudget.IsStrictlyPositive())
+    {
+        m_pacer = Create<WallClockPacer>();
+    }
+
+    if (m_profiling)
+    {
+        m_profiler = Create<NoriProfiler>();
+        m_e2DuCalculator->SetProfiler(m_profiler);
+        auto rlScheduler = DynamicCast<NrRLMacSchedulerOfdma>(
+            DynamicCast<NrGnbNetDevice>(m_netDev)->GetScheduler(0));
+        if (rlScheduler)
+        {
+            rlScheduler->SetProfiler(m_profiler);
+        }
+    }
+
+    // The RLC of each DRB of this cell is hooked up when the DRB is created
+    bool connected = m_rrc->TraceConnectWithoutContext(
+        "DrbCreated",
+        MakeCallback(&E2Interface::ConnectDrbTxPdu, this));
+    NS_ABORT_MSG_UNLESS(connected, "The gNB RRC has no DrbCreated trace source");
+
+    // The KPI history of a UE released by this cell is dropped, unless it was handed over
+    connected = m_rrc->TraceConnectWithoutContext(
+        "HandoverStart",
+        MakeCallback(&E2Interface::NotifyHandoverStart, this));
+    NS_ABORT_MSG_UNLESS(connected, "The gNB RRC has no HandoverStart trace source");
+    connected = m_rrc->TraceConnectWithoutContext(
+        "NotifyConnectionRelease",
+        MakeCallback(&E2Interface::NotifyConnectionRelease, this));
+    NS_ABORT_MSG_UNLESS(connected, "The gNB RRC has no NotifyConnectionRelease trace source");
+    Object::NotifyConstructionCompleted();
 }
 
 TypeId
@@ -71,7 +116,227 @@ E2Interface::GetTypeId()
                                           "The start time of the E2 report messages",
                                           DoubleValue(0),
                                           MakeDoubleAccessor(&E2Interface::m_startTime),
-                                          MakeDoubleChecker<double>());
+                                          MakeDoubleChecker<double>())
+                            .AddAttribute("PolicyPlugin",
+                                          "Path of an in-process slicing policy plugin. If set, "
+                                          "the KPIs are handed to the plugin every E2 period "
+                                          "instead of going through the RIC",
+                                          StringValue(""),
+                                          MakeStringAccessor(&E2Interface::m_policyPluginPath),
+                                          MakeStringChecker())
+                            .AddAttribute("PolicyPluginConfig",
+                                          "Opaque configuration string passed to the policy plugin",
+                                          StringValue(""),
+                                          MakeStringAccessor(&E2Interface::m_policyPluginConfig),
+                                          MakeStringChecker())
+                            .AddAttribute("Lockstep",
+                                          "Pause the simulation after each report until the RIC "
+                                          "answers with a control message or a no-op ack",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&E2Interface::m_lockstep),
+                                          MakeBooleanChecker())
+                            .AddAttribute("LockstepLookahead",
+                                          "Number of reports that can be outstanding before the "
+                                          "simulation pauses in lockstep mode",
+                                          UintegerValue(1),
+                                          MakeUintegerAccessor(&E2Interface::m_lockstepLookahead),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("LockstepTimeout",
+                                          "Wall-clock time to wait for the RIC in lockstep mode, "
+                                          "after which the oldest report is considered lost",
+                                          TimeValue(Seconds(1)),
+                                          MakeTimeAccessor(&E2Interface::m_lockstepTimeout),
+                                          MakeTimeChecker())
+                            .AddAttribute("EventTriggered",
+                                          "Evaluate the trigger conditions every report period "
+                                          "and send a report only when one of them fires",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&E2Interface::m_eventTriggered),
+                                          MakeBooleanChecker())
+                            .AddAttribute("EventMinInterval",
+                                          "Minimum time between two event-triggered reports",
+                                          TimeValue(Seconds(0)),
+                                          MakeTimeAccessor(&E2Interface::m_eventMinInterval),
+                                          MakeTimeChecker())
+                            .AddAttribute("EventMaxInterval",
+                                          "Maximum time between two event-triggered reports, "
+                                          "after which a report is sent anyway",
+                                          TimeValue(Seconds(1)),
+                                          MakeTimeAccessor(&E2Interface::m_eventMaxInterval),
+                                          MakeTimeChecker())
+                            .AddAttribute("EventPrbThreshold",
+                                          "Cell DL PRB usage, in percentage, whose crossing in "
+                                          "either direction triggers a report",
+                                          DoubleValue(80),
+                                          MakeDoubleAccessor(&E2Interface::m_eventPrbThreshold),
+                                          MakeDoubleChecker<double>(0, 100))
+                            .AddAttribute("EventBufferGrowth",
+                                          "Growth of the buffer of a UE, in bytes, that triggers "
+                                          "a report. 0 disables the condition",
+                                          UintegerValue(10000),
+                                          MakeUintegerAccessor(&E2Interface::m_eventBufferGrowth),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("EventThroughputChange",
+                                          "Change of the DL throughput of a UE, in percentage, "
+                                          "that triggers a report. 0 disables the condition",
+                                          DoubleValue(20),
+                                          MakeDoubleAccessor(&E2Interface::m_eventThroughputChange),
+                                          MakeDoubleChecker<double>(0))
+                            .AddAttribute("DeltaReports",
+                                          "Omit from the per-UE lists the UEs whose values did "
+                                          "not change since they were last sent, except on "
+                                          "keyframes",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&E2Interface::m_deltaReports),
+                                          MakeBooleanChecker())
+                            .AddAttribute("DeltaTolerance",
+                                          "Relative change below which a UE value is considered "
+                                          "unchanged in delta mode",
+                                          DoubleValue(0),
+                                          MakeDoubleAccessor(&E2Interface::m_deltaTolerance),
+                                          MakeDoubleChecker<double>(0))
+                            .AddAttribute("DeltaKeyframeInterval",
+                                          "Number of reports between two full reports carrying "
+                                          "every UE in delta mode",
+                                          UintegerValue(10),
+                                          MakeUintegerAccessor(
+                                              &E2Interface::m_deltaKeyframeInterval),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("AdaptivePeriodicity",
+                                          "Stretch the report period when the outbound queue or "
+                                          "the encode and send path cannot keep up, and bring it "
+                                          "back when the backlog clears",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&E2Interface::m_adaptivePeriodicity),
+                                          MakeBooleanChecker())
+                            .AddAttribute("MaxPeriodicityScale",
+                                          "Maximum ratio between the effective report period and "
+                                          "the one requested in adaptive mode",
+                                          DoubleValue(8),
+                                          MakeDoubleAccessor(&E2Interface::m_maxPeriodicityScale),
+                                          MakeDoubleChecker<double>(1))
+                            .AddAttribute("BacklogHighWatermark",
+                                          "Occupancy of the outbound queue, from 0 to 1, above "
+                                          "which the report period is stretched",
+                                          DoubleValue(0.5),
+                                          MakeDoubleAccessor(&E2Interface::m_backlogHighWatermark),
+                                          MakeDoubleChecker<double>(0, 1))
+                            .AddAttribute("BacklogLowWatermark",
+                                          "Occupancy of the outbound queue, from 0 to 1, below "
+                                          "which the report period is brought back",
+                                          DoubleValue(0.1),
+                                          MakeDoubleAccessor(&E2Interface::m_backlogLowWatermark),
+                                          MakeDoubleChecker<double>(0, 1))
+                            .AddAttribute("ReportTimeBudget",
+                                          "Wall-clock time building, encoding and sending a "
+                                          "report may take before the report period is stretched",
+                                          TimeValue(MilliSeconds(10)),
+                                          MakeTimeAccessor(&E2Interface::m_reportTimeBudget),
+                                          MakeTimeChecker())
+                            .AddAttribute("WallClockTracking",
+                                          "Measure the lag of the simulation behind the wall "
+                                          "clock at every report, and report it in the "
+                                          "WallClockLag trace source and the KPM messages",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&E2Interface::m_wallClockTracking),
+                                          MakeBooleanChecker())
+                            .AddAttribute("PaceWallClock",
+                                          "Hold the simulation back at every report so that it "
+                                          "does not run ahead of the wall clock. Implies "
+                                          "WallClockTracking",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&E2Interface::m_paceWallClock),
+                                          MakeBooleanChecker())
+                            .AddAttribute("LagBudget",
+                                          "Lag behind the wall clock above which the CU "
+                                          "containers are skipped and then the report period is "
+                                          "stretched. 0 disables the load shedding. Implies "
+                                          "WallClockTracking",
+                                          TimeValue(Seconds(0)),
+                                          MakeTimeAccessor(&E2Interface::m_lagBudget),
+                                          MakeTimeChecker())
+                            .AddAttribute("MaxIndicationSize",
+                                          "Maximum size, in bytes, of an encoded KPM indication "
+                                          "message. Larger messages are split in segments "
+                                          "carrying part of the UEs. 0 disables the splitting",
+                                          UintegerValue(0),
+                                          MakeUintegerAccessor(&E2Interface::m_maxIndicationSize),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("StatsDumpInterval",
+                                          "Period of the dump of the indication counters to "
+                                          "the stats file. 0 disables the dump",
+                                          TimeValue(Seconds(0)),
+                                          MakeTimeAccessor(&E2Interface::m_statsDumpInterval),
+                                          MakeTimeChecker())
+                            .AddAttribute("StatsFilePrefix",
+                                          "Prefix of the stats file name, completed with the "
+                                          "cell ID",
+                                          StringValue("E2IndicationStats"),
+                                          MakeStringAccessor(&E2Interface::m_statsFilePrefix),
+                                          MakeStringChecker())
+                            .AddAttribute("LatencyFilePrefix",
+                                          "Prefix of the file, completed with the cell ID, where "
+                                          "the closed-loop latency percentiles are written at the "
+                                          "end of the run",
+                                          StringValue("E2ClosedLoopLatency"),
+                                          MakeStringAccessor(&E2Interface::m_latencyFilePrefix),
+                                          MakeStringChecker())
+                            .AddAttribute("Profiling",
+                                          "Time the stages of NORI on this gNB, from the trace "
+                                          "callbacks to the scheduler allocations",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&E2Interface::m_profiling),
+                                          MakeBooleanChecker())
+                            .AddAttribute("ProfileFilePrefix",
+                                          "Prefix of the file, completed with the cell ID, where "
+                                          "the profile is written at the end of the run",
+                                          StringValue("NoriProfile"),
+                                          MakeStringAccessor(&E2Interface::m_profileFilePrefix),
+                                          MakeStringChecker())
+                            .AddTraceSource("IndicationsBuilt",
+                                            "Number of KPM messages built",
+                                            MakeTraceSourceAccessor(
+                                                &E2Interface::m_indicationsBuilt),
+                                            "ns3::TracedValueCallback::Uint64")
+                            .AddTraceSource("IndicationsEncoded",
+                                            "Number of KPM messages and segments encoded",
+                                            MakeTraceSourceAccessor(
+                                                &E2Interface::m_indicationsEncoded),
+                                            "ns3::TracedValueCallback::Uint64")
+                            .AddTraceSource("IndicationsSent",
+                                            "Number of RIC indications sent",
+                                            MakeTraceSourceAccessor(
+                                                &E2Interface::m_indicationsSent),
+                                            "ns3::TracedValueCallback::Uint64")
+                            .AddTraceSource("IndicationsFailed",
+                                            "Number of RIC indications that could not be sent",
+                                            MakeTraceSourceAccessor(
+                                                &E2Interface::m_indicationsFailed),
+                                            "ns3::TracedValueCallback::Uint64")
+                            .AddTraceSource("BytesSent",
+                                            "KPM header and message bytes of the RIC indications "
+                                            "sent",
+                                            MakeTraceSourceAccessor(&E2Interface::m_bytesSent),
+                                            "ns3::TracedValueCallback::Uint64")
+                            .AddTraceSource("ClosedLoopLatency",
+                                            "Latency of each stage of a closed control loop, from "
+                                            "the KPI collection to the slicing parameters taking "
+                                            "effect in the scheduler",
+                                            MakeTraceSourceAccessor(
+                                                &E2Interface::m_closedLoopLatencyTrace),
+                                            "ns3::E2Interface::ClosedLoopLatencyTracedCallback")
+                            .AddTraceSource("PeriodicityAdapted",
+                                            "The effective period of a report group changed in "
+                                            "adaptive mode",
+                                            MakeTraceSourceAccessor(
+                                                &E2Interface::m_periodicityAdaptedTrace),
+                                            "ns3::E2Interface::PeriodicityAdaptedTracedCallback")
+                            .AddTraceSource("WallClockLag",
+                                            "Lag of the simulation behind the wall clock, measured "
+                                            "at every report",
+                                            MakeTraceSourceAccessor(
+                                                &E2Interface::m_wallClockLagTrace),
+                                            "ns3::E2Interface::WallClockLagTracedCallback");
     return tid;
 }
 
@@ -83,6 +348,7 @@ E2Interface::RegisterNewSinrReadingCallback([[maybe_unused]] std::string path,
                                             uint16_t bwpId)
 {
     NS_LOG_FUNCTION(this);
+    NORI_PROFILE(m_profiler, NoriProfiler::TRACE_SINR);
     double sinrDb = 10 * log10(avgSinr);
     NS_LOG_DEBUG("Registering new SINR reading for cellId: " << cellId << " RNTI: " << rnti
                                                              << " avgSinr: " << sinrDb);
@@ -123,13 +389,26 @@ E2Interface::RegisterNewSinrReadingCallback([[maybe_unused]] std::string path,
 }
 
 void
-E2Interface::BuildAndSendReportMessage(E2Termination::RicSubscriptionRequest_rval_s params)
+E2Interface::BuildAndSendReportMessage(uint32_t periodMs)
 {
-    NS_LOG_FUNCTION(this);
+    NS_LOG_FUNCTION(this << periodMs);
     NS_LOG_DEBUG("Building and sending report message for nodeB: " << m_netDev);
-    auto e2Term = m_netDev->GetObject<E2Termination>();
     // eNB/gNB needs to have an E2 termination
-    NS_ASSERT(e2Term != nullptr);
+    NS_ASSERT(m_e2term != nullptr);
+
+    auto group = m_reportGroups.find(periodMs);
+    if (group == m_reportGroups.end() || group->second.subscriptions.empty())
+    {
+        NS_LOG_DEBUG("No subscription left on period " << periodMs << " ms");
+        m_reportGroups.erase(periodMs);
+        return;
+    }
+
+    group->second.timer =
+        Simulator::Schedule(MilliSeconds(std::lround(periodMs * group->second.periodScale)),
+                            &E2Interface::BuildAndSendReportMessage,
+                            this,
+                            periodMs);
 
     // nodeB PLMN ID
     std::string plmId = "111";
@@ -142,96 +421,556 @@ E2Interface::BuildAndSendReportMessage(E2Termination::RicSubscriptionRequest_rva
     NS_ASSERT(plmId == "111" && m_cellId != 0);
     std::string gnbId = std::to_string(m_cellId);
     NS_LOG_DEBUG("PLMN ID: " << plmId << " gNB cell ID: " << gnbId);
-    bool cuUp = true;
-
-    if (cuUp)
-    {
-        // Create CU-UP
-        auto header = BuildRicIndicationHeader(plmId, gnbId, m_cellId);
-        auto cuUpMsg = BuildRicIndicationMessageCuUp(plmId);
-
-        // Send CU-UP only if offline logging is disabled
-        if (header != nullptr && cuUpMsg != nullptr)
-        {
-            NS_LOG_DEBUG("Send NR CU-UP");
-            auto pdu_cuup_ue = new E2AP_PDU;
-            encoding::generate_e2apv1_indication_request_parameterized(
-                pdu_cuup_ue,
-                params.requestorId,
-                params.instanceId,
-                params.ranFuncionId,
-                params.actionId,
-                1,                           // TODO sequence number
-                (uint8_t*)header->m_buffer,  // buffer containing the encoded header
-                header->m_size,              // size of the encoded header
-                (uint8_t*)cuUpMsg->m_buffer, // buffer containing the encoded message
-                cuUpMsg->m_size);            // size of the encoded message
-            e2Term->SendE2Message(pdu_cuup_ue);
-            delete pdu_cuup_ue;
-        }
-    }
-
-    bool m_sendCuCp = true;
-    if (m_sendCuCp)
-    {
-        // Create and send CU-CP
-        Ptr<KpmIndicationHeader> header = BuildRicIndicationHeader(plmId, gnbId, m_cellId);
-        Ptr<KpmIndicationMessage> cuCpMsg = BuildRicIndicationMessageCuCp(plmId);
-
-        // Send CU-CP only if offline logging is disabled
-        if (header != nullptr && cuCpMsg != nullptr)
-        {
-            NS_LOG_DEBUG("Send NR CU-CP");
-            auto pdu_cucp_ue = new E2AP_PDU;
-            encoding::generate_e2apv1_indication_request_parameterized(
-                pdu_cucp_ue,
-                params.requestorId,
-                params.instanceId,
-                params.ranFuncionId,
-                params.actionId,
-                1,                           // TODO sequence number
-                (uint8_t*)header->m_buffer,  // buffer containing the encoded header
-                header->m_size,              // size of the encoded header
-                (uint8_t*)cuCpMsg->m_buffer, // buffer containing the encoded message
-                cuCpMsg->m_size);            // size of the encoded message
-            m_e2term->SendE2Message(pdu_cucp_ue);
-            delete pdu_cucp_ue;
-        }
-    }
-
-    bool m_sendDu = true;
-    if (m_sendDu)
-    {
-        // Create DU
-        Ptr<KpmIndicationHeader> header = BuildRicIndicationHeader(plmId, gnbId, m_cellId);
-        Ptr<KpmIndicationMessage> duMsg = BuildRicIndicationMessageDu(plmId, m_cellId);
-
-        // Send DU only if offline logging is disabled
-        if (header != nullptr && duMsg != nullptr)
-        {
-            NS_LOG_DEBUG("Send NR DU");
-            auto pdu_du_ue = new E2AP_PDU;
-            encoding::generate_e2apv1_indication_request_parameterized(
-                pdu_du_ue,
-                params.requestorId,
-                params.instanceId,
-                params.ranFuncionId,
-                params.actionId,
-                1,                          // TODO sequence number
-                (uint8_t*)header->m_buffer, // buffer containing the encoded header
-                header->m_size,             // size of the encoded header
-                (uint8_t*)duMsg->m_buffer,  // buffer containing the encoded message
-                duMsg->m_size);             // size of the encoded message
-            m_e2term->SendE2Message(pdu_du_ue);
-            delete pdu_du_ue;
-        }
-    }
-    // Use without context for thread safety; Need to study why using context it makes safe
-    Simulator::ScheduleWithContext(1,
-                                   Seconds(m_e2Periodicity),
-                                   &E2Interface::BuildAndSendReportMessage,
-                                   this,
-                                   params);
+
+    // In event-triggered mode the period is only the evaluation interval
+    if (m_eventTriggered && !CheckEventTriggers(group->second))
+    {
+        return;
+    }
+
+    // Drift of the simulation from the wall clock, before this report adds to it
+    Time lag;
+    if (m_pacer)
+    {
+        if (m_paceWallClock)
+        {
+            m_pacer->WaitForWallClock();
+        }
+        lag = m_pacer->GetLag();
+        m_wallClockLagTrace(m_cellId, lag.GetSeconds() * 1e3);
+        if (m_lagBudget.IsStrictlyPositive())
+        {
+            ShedLoad(periodMs, group->second, lag);
+        }
+    }
+
+    // Start of the control loops of this report
+    m_report++;
+    m_collectSim = Simulator::Now();
+    m_collectWall = std::chrono::steady_clock::now();
+    uint64_t failedBefore = m_indicationsFailed;
+
+    // Each group reads the counters from its own baseline, so that the KPIs cover the
+    // time since its previous report whatever the other groups read meanwhile
+    auto& baseline = group->second.baseline;
+    Time defaultWindow = MilliSeconds(std::lround(periodMs * group->second.periodScale));
+    bool buildCuUp = m_shedLevel < SHED_CU_UP;
+    bool buildCuCp = m_shedLevel < SHED_CU_CP;
+    Time duWindow = StartReportWindow(baseline.lastDuBuild, defaultWindow);
+    if (buildCuUp)
+    {
+        m_reportWindow = StartReportWindow(baseline.lastCuUpBuild, defaultWindow);
+    }
+
+    // The messages are built and encoded once per period, and sent to every
+    // subscription sharing it
+    // Only the measurements requested by at least one subscription are computed
+    uint64_t measurementMask = 0;
+    for (const auto& key : group->second.subscriptions)
+    {
+        measurementMask |= m_subscriptions.at(key).params.measurementMask;
+    }
+
+    // In delta mode, every DeltaKeyframeInterval reports carries all the UEs again so
+    // that the RIC can resynchronize
+    DeltaState* delta = nullptr;
+    if (m_deltaReports)
+    {
+        delta = &group->second.delta;
+        delta->keyframe = delta->reportsSinceKeyframe == 0;
+        delta->reportsSinceKeyframe = (delta->reportsSinceKeyframe + 1) % m_deltaKeyframeInterval;
+        if (delta->keyframe)
+        {
+            // Forget the UEs that left the cell
+            delta->cuUpValues.clear();
+            delta->duValues.clear();
+        }
+    }
+
+    auto header = BuildRicIndicationHeader(plmId, gnbId, m_cellId);
+    // Under load shedding the CU containers are skipped, the DU one carries the
+    // PRB usage the slicing decisions are based on
+    auto cuUpMsg =
+        buildCuUp ? BuildRicIndicationMessageCuUp(plmId, measurementMask, delta, baseline)
+                  : nullptr;
+    auto cuCpMsg = buildCuCp ? BuildRicIndicationMessageCuCp(plmId, measurementMask) : nullptr;
+    auto duMsg = BuildRicIndicationMessageDu(plmId, m_cellId, measurementMask, delta, baseline);
+    m_indicationsBuilt += (cuUpMsg != nullptr) + (cuCpMsg != nullptr) + (duMsg != nullptr);
+    for (const auto& msg : {cuUpMsg, cuCpMsg, duMsg})
+    {
+        if (msg == nullptr)
+        {
+            continue;
+        }
+        Time window = msg == cuUpMsg ? m_reportWindow : duWindow;
+        msg->AddReportTag("Report.WindowLengthMs", window.GetMilliSeconds());
+        if (m_pacer)
+        {
+            msg->AddReportTag("Report.WallClockLagMs", lag.GetMilliSeconds());
+        }
+    }
+
+    // Send only if offline logging is disabled
+    if (header != nullptr && cuUpMsg != nullptr)
+    {
+        NS_LOG_DEBUG("Send NR CU-UP");
+        SendSegments(group->second.subscriptions, header, cuUpMsg);
+    }
+
+    if (header != nullptr && cuCpMsg != nullptr)
+    {
+        NS_LOG_DEBUG("Send NR CU-CP");
+        SendSegments(group->second.subscriptions, header, cuCpMsg);
+    }
+
+    if (header != nullptr && duMsg != nullptr)
+    {
+        NS_LOG_DEBUG("Send NR DU");
+        SendSegments(group->second.subscriptions, header, duMsg);
+    }
+
+    if (m_adaptivePeriodicity)
+    {
+        AdaptPeriodicity(periodMs,
+                         group->second,
+                         m_indicationsFailed != failedBefore,
+                         std::chrono::steady_clock::now() - m_collectWall);
+    }
+
+    if (m_lockstep)
+    {
+        WaitForRic();
+    }
+}
+
+void
+E2Interface::AdaptPeriodicity(uint32_t periodMs,
+                              ReportGroup& group,
+                              bool failed,
+                              std::chrono::steady_clock::duration sendTime)
+{
+    NS_LOG_FUNCTION(this << periodMs << failed);
+
+    double backlog = m_e2term->GetOutboundBacklog();
+    double sendMs = std::chrono::duration<double, std::milli>(sendTime).count();
+    double budgetMs = m_reportTimeBudget.GetSeconds() * 1e3;
+
+    // Back off quickly and recover slowly, so that the period does not oscillate
+    // around the capacity of the RIC
+    double scale = group.periodScale;
+    if (failed || backlog > m_backlogHighWatermark || sendMs > budgetMs)
+    {
+        scale = std::min(scale * 2, m_maxPeriodicityScale);
+    }
+    else if (backlog < m_backlogLowWatermark && sendMs < budgetMs / 2)
+    {
+        scale = std::max(scale / 1.25, 1.0);
+    }
+
+    if (scale != group.periodScale)
+    {
+        NS_LOG_INFO("Cell " << m_cellId << ": backlog " << backlog << ", send time " << sendMs
+                            << " ms, failed " << failed);
+        SetPeriodScale(periodMs, group, scale);
+    }
+}
+
+void
+E2Interface::SetPeriodScale(uint32_t periodMs, ReportGroup& group, double scale)
+{
+    Time period = MilliSeconds(std::lround(periodMs * scale));
+    NS_LOG_INFO("Cell " << m_cellId << ": period " << periodMs << " ms now reported every "
+                        << period.GetMilliSeconds() << " ms");
+    group.periodScale = scale;
+    group.timer.Cancel();
+    group.timer =
+        Simulator::Schedule(period, &E2Interface::BuildAndSendReportMessage, this, periodMs);
+    m_periodicityAdaptedTrace(m_cellId, periodMs, period.GetMilliSeconds());
+}
+
+void
+E2Interface::ShedLoad(uint32_t periodMs, ReportGroup& group, Time lag)
+{
+    NS_LOG_FUNCTION(this << periodMs << lag);
+
+    // One more step each report while over budget, one step back each report
+    // once well within it
+    int level = m_shedLevel;
+    if (lag > m_lagBudget)
+    {
+        if (m_shedLevel < SHED_PERIOD)
+        {
+            level++;
+        }
+        else if (group.periodScale < m_maxPeriodicityScale)
+        {
+            SetPeriodScale(periodMs, group, std::min(group.periodScale * 2, m_maxPeriodicityScale));
+        }
+    }
+    else if (lag < m_lagBudget / 2 && m_shedLevel > SHED_NONE)
+    {
+        if (m_shedLevel == SHED_PERIOD && group.periodScale > 1)
+        {
+            SetPeriodScale(periodMs, group, std::max(group.periodScale / 1.25, 1.0));
+        }
+        else
+        {
+            level--;
+        }
+    }
+
+    if (level != m_shedLevel)
+    {
+        NS_LOG_INFO("Cell " << m_cellId << ": lag " << lag.GetMilliSeconds()
+                            << " ms, load shedding level " << level);
+        m_shedLevel = static_cast<LoadShedding>(level);
+    }
+}
+
+Time
+E2Interface::StartReportWindow(Time& lastBuild, Time defaultWindow)
+{
+    Time now = Simulator::Now();
+    // At least 1 ms, so that the rates stay finite when two groups report at the
+    // same time
+    Time window =
+        lastBuild.IsStrictlyNegative() ? defaultWindow : Max(now - lastBuild, MilliSeconds(1));
+    lastBuild = now;
+    return window;
+}
+
+bool
+E2Interface::CheckEventTriggers(ReportGroup& group)
+{
+    NS_LOG_FUNCTION(this);
+
+    Time now = Simulator::Now();
+    Time sinceLastReport = now - group.lastReport;
+    if (group.hasReported && sinceLastReport < m_eventMinInterval)
+    {
+        return false;
+    }
+
+    bool fire = !group.hasReported || sinceLastReport >= m_eventMaxInterval;
+
+    ObjectMapValue ueManager;
+    m_rrc->GetAttribute("UeMap", ueManager);
+
+    std::map<uint64_t, UeTriggerState> ueState;
+    double cellPrb = 0;
+    for (auto ueObject = ueManager.Begin(); ueObject != ueManager.End(); ueObject++)
+    {
+        auto ue = DynamicCast<NrUeManager>(ueObject->second);
+        uint64_t imsi = ue->GetImsi();
+        uint16_t rnti = ue->GetRnti();
+
+        UeTriggerState state;
+        auto sinr = m_l3sinrMap.find(rnti);
+        if (sinr != m_l3sinrMap.end() && sinr->second.count(m_cellId) > 0)
+        {
+            state.sinrBin = GetSinrBin(sinr->second.at(m_cellId));
+        }
+        state.dlBytes = m_e2PdcpStatsCalculator->GetDlTxData(imsi, 4);
+        if (m_e2RlcStatsCalculator)
+        {
+            // Whatever PDCP handed down and RLC did not send yet is still queued
+            uint64_t rlcBytes = m_e2RlcStatsCalculator->GetDlTxData(imsi, 4);
+            state.bufferBytes = state.dlBytes > rlcBytes ? state.dlBytes - rlcBytes : 0;
+        }
+        cellPrb += ComputeMacPrb(rnti, group.baseline.du);
+
+        auto last = group.ueState.find(imsi);
+        if (last == group.ueState.end())
+        {
+            NS_LOG_DEBUG("UE " << imsi << " not reported yet");
+            fire = true;
+        }
+        else
+        {
+            const auto& previous = last->second;
+            if (state.dlBytes >= previous.dlBytes && sinceLastReport.IsStrictlyPositive())
+            {
+                state.dlThroughput =
+                    (state.dlBytes - previous.dlBytes) * 8 / sinceLastReport.GetSeconds();
+            }
+
+            if (state.sinrBin != previous.sinrBin)
+            {
+                NS_LOG_DEBUG("UE " << imsi << " SINR bin " << previous.sinrBin << " -> "
+                                   << state.sinrBin);
+                fire = true;
+            }
+            if (m_eventBufferGrowth > 0 &&
+                state.bufferBytes > previous.bufferBytes + m_eventBufferGrowth)
+            {
+                NS_LOG_DEBUG("UE " << imsi << " buffer " << previous.bufferBytes << " -> "
+                                   << state.bufferBytes << " bytes");
+                fire = true;
+            }
+            if (m_eventThroughputChange > 0 &&
+                std::abs(state.dlThroughput - previous.dlThroughput) >
+                    m_eventThroughputChange / 100 * std::max(previous.dlThroughput, 1.0))
+            {
+                NS_LOG_DEBUG("UE " << imsi << " throughput " << previous.dlThroughput << " -> "
+                                   << state.dlThroughput << " bit/s");
+                fire = true;
+            }
+        }
+        ueState[imsi] = state;
+    }
+
+    // A UE left the cell
+    fire |= ueState.size() != group.ueState.size();
+
+    // 139 PRBs per cell, as in ComputeMacPrb
+    bool prbAboveThreshold = cellPrb / 139 * 100 > m_eventPrbThreshold;
+    if (prbAboveThreshold != group.prbAboveThreshold)
+    {
+        NS_LOG_DEBUG("Cell PRB usage crossed " << m_eventPrbThreshold << "%");
+        fire = true;
+    }
+
+    if (!fire)
+    {
+        return false;
+    }
+
+    group.hasReported = true;
+    group.lastReport = now;
+    group.prbAboveThreshold = prbAboveThreshold;
+    group.ueState = std::move(ueState);
+    return true;
+}
+
+bool
+E2Interface::HasUeChanged(std::map<uint64_t, std::vector<double>>& reference,
+                          uint64_t imsi,
+                          std::vector<double> values,
+                          bool keyframe) const
+{
+    auto& last = reference[imsi];
+    bool changed = keyframe || last.size() != values.size();
+    for (size_t i = 0; !changed && i < values.size(); i++)
+    {
+        changed = std::abs(values[i] - last[i]) > m_deltaTolerance * std::abs(last[i]);
+    }
+    if (changed)
+    {
+        last = std::move(values);
+    }
+    return changed;
+}
+
+int
+E2Interface::GetSinrBin(double sinrDb)
+{
+    // Same bins as the MAC SINR statistics of NoriE2Report
+    static const double upperEdges[] = {-6, 0, 6, 12, 18, 24};
+    int bin = 0;
+    for (double edge : upperEdges)
+    {
+        if (sinrDb <= edge)
+        {
+            return bin;
+        }
+        bin++;
+    }
+    return bin;
+}
+
+Ptr<KpmIndicationMessage>
+E2Interface::Encode(Ptr<IndicationMessageHelper> msgHelper,
+                    size_t firstUe,
+                    size_t numUes,
+                    uint32_t segment,
+                    uint32_t numSegments)
+{
+    NORI_PROFILE(m_profiler, NoriProfiler::ENCODE);
+    m_indicationsEncoded++;
+    if (segment == 0)
+    {
+        return msgHelper->CreateIndicationMessage();
+    }
+    return msgHelper->CreateIndicationMessage(firstUe, numUes, segment, numSegments);
+}
+
+void
+E2Interface::SendSegments(const std::set<SubscriptionKey>& subscriptions,
+                          Ptr<KpmIndicationHeader> header,
+                          Ptr<IndicationMessageHelper> msgHelper)
+{
+    NS_LOG_FUNCTION(this);
+
+    // The whole message, when it is expected to fit
+    size_t numUes = msgHelper->GetNumUeItems();
+    if (m_maxIndicationSize == 0 || numUes <= 1 || numUes <= m_uesPerSegment)
+    {
+        auto msg = Encode(msgHelper, 0, numUes);
+        if (m_maxIndicationSize > 0 && numUes > 0)
+        {
+            m_uesPerSegment = std::max<size_t>(1, numUes * m_maxIndicationSize / msg->m_size);
+        }
+        if (m_maxIndicationSize == 0 || numUes <= 1 || msg->m_size <= m_maxIndicationSize)
+        {
+            for (const auto& key : subscriptions)
+            {
+                SendIndication(m_subscriptions.at(key), header, msg);
+            }
+            return;
+        }
+    }
+
+    // The number of segments comes from the calibrated m_uesPerSegment and the UE items
+    // are spread evenly over them, so that each segment is encoded once, with its final
+    // index and count
+    size_t numPlanned = (numUes + m_uesPerSegment - 1) / m_uesPerSegment;
+    std::vector<std::pair<size_t, size_t>> segments; // First UE item and number of items
+    for (size_t segment = 0; segment < numPlanned; segment++)
+    {
+        size_t firstUe = numUes * segment / numPlanned;
+        segments.emplace_back(firstUe, numUes * (segment + 1) / numPlanned - firstUe);
+    }
+
+    std::vector<Ptr<KpmIndicationMessage>> msgs;
+    while (true)
+    {
+        uint32_t numSegments = segments.size();
+        std::vector<std::pair<size_t, size_t>> resplit;
+        msgs.clear();
+        size_t uesPerSegment = numUes;
+        for (uint32_t segment = 1; segment <= numSegments; segment++)
+        {
+            auto [firstUe, segmentUes] = segments[segment - 1];
+            auto msg = Encode(msgHelper, firstUe, segmentUes, segment, numSegments);
+            // Size the segments of the next reports after the fullest one
+            uesPerSegment = std::min<size_t>(uesPerSegment,
+                                             segmentUes * m_maxIndicationSize / msg->m_size);
+            if (msg->m_size > m_maxIndicationSize && segmentUes > 1)
+            {
+                // Only a segment that overflows is split again, in as many parts as the
+                // encoded size asks for
+                size_t parts = std::min<size_t>(
+                    segmentUes,
+                    std::max<size_t>(2, (msg->m_size + m_maxIndicationSize - 1) /
+                                            m_maxIndicationSize));
+                for (size_t part = 0; part < parts; part++)
+                {
+                    size_t partFirstUe = firstUe + segmentUes * part / parts;
+                    resplit.emplace_back(partFirstUe,
+                                         firstUe + segmentUes * (part + 1) / parts - partFirstUe);
+                }
+                continue;
+            }
+            if (msg->m_size > m_maxIndicationSize)
+            {
+                NS_LOG_WARN("A single UE item takes " << msg->m_size << " bytes, more than "
+                                                      << m_maxIndicationSize);
+            }
+            resplit.emplace_back(firstUe, segmentUes);
+            msgs.push_back(msg);
+        }
+        m_uesPerSegment = std::max<size_t>(1, uesPerSegment);
+        if (resplit.size() == numSegments)
+        {
+            break;
+        }
+        // Every segment carries the count, which changed, so they are all encoded again
+        NS_LOG_DEBUG("Segments split again: " << numSegments << " -> " << resplit.size());
+        segments = std::move(resplit);
+    }
+
+    // Segments of the same report carry consecutive sequence numbers and the same
+    // header
+    for (uint32_t segment = 1; segment <= msgs.size(); segment++)
+    {
+        auto [firstUe, segmentUes] = segments[segment - 1];
+        const auto& msg = msgs[segment - 1];
+        NS_LOG_DEBUG("Segment " << segment << "/" << msgs.size() << ": UE items " << firstUe
+                                << " to " << firstUe + segmentUes - 1 << ", " << msg->m_size
+                                << " bytes");
+        for (const auto& key : subscriptions)
+        {
+            SendIndication(m_subscriptions.at(key), header, msg);
+        }
+    }
+}
+
+void
+E2Interface::SendIndication(Subscription& subscription,
+                            Ptr<KpmIndicationHeader> header,
+                            Ptr<KpmIndicationMessage> msg)
+{
+    NORI_PROFILE(m_profiler, NoriProfiler::SEND);
+    const auto& params = subscription.params;
+    uint32_t sequenceNumber = subscription.nextSequenceNumber++;
+    E2AP_PDU pdu{};
+    encoding::generate_e2apv1_indication_request_parameterized(
+        &pdu,
+        params.requestorId,
+        params.instanceId,
+        params.ranFuncionId,
+        params.actionId,
+        sequenceNumber,             // lets the RIC detect loss and reordering
+        (uint8_t*)header->m_buffer, // buffer containing the encoded header
+        header->m_size,             // size of the encoded header
+        (uint8_t*)msg->m_buffer,    // buffer containing the encoded message
+        msg->m_size);               // size of the encoded message
+    if (m_e2term->SendRicIndication(&pdu, params, sequenceNumber))
+    {
+        subscription.sent++;
+        subscription.bytesSent += header->m_size + msg->m_size;
+        m_indicationsSent++;
+        m_bytesSent += header->m_size + msg->m_size;
+
+        std::lock_guard<std::mutex> lock(m_loopMutex);
+        m_openLoops[{params.requestorId, params.instanceId, sequenceNumber}] = {
+            sequenceNumber,
+            m_report,
+            m_collectSim,
+            m_collectWall,
+            std::chrono::steady_clock::now(),
+            {}};
+        // Indications never answered by the RIC are forgotten after a while
+        if (sequenceNumber > 1024)
+        {
+            m_openLoops.erase(
+                m_openLoops.lower_bound({params.requestorId, params.instanceId, 0}),
+                m_openLoops.upper_bound(
+                    {params.requestorId, params.instanceId, sequenceNumber - 1024}));
+        }
+    }
+    else
+    {
+        subscription.failed++;
+        m_indicationsFailed++;
+    }
+}
+
+void
+E2Interface::DumpStats()
+{
+    NS_LOG_FUNCTION(this);
+
+    if (!m_statsFile.is_open())
+    {
+        std::string fileName = m_statsFilePrefix + "-" + std::to_string(m_cellId) + ".csv";
+        m_statsFile.open(fileName);
+        NS_ABORT_MSG_UNLESS(m_statsFile.is_open(), "Can't open file " << fileName);
+        m_statsFile << "time,cellId,requestorId,instanceId,actionId,lastSequenceNumber,sent,"
+                       "failed,bytesSent,nodeBuilt,nodeEncoded\n";
+    }
+
+    for (const auto& [key, subscription] : m_subscriptions)
+    {
+        m_statsFile << Simulator::Now().GetSeconds() << "," << m_cellId << ","
+                    << std::get<0>(key) << "," << std::get<1>(key) << "," << +std::get<2>(key)
+                    << "," << subscription.nextSequenceNumber - 1 << "," << subscription.sent
+                    << "," << subscription.failed << "," << subscription.bytesSent << ","
+                    << m_indicationsBuilt << "," << m_indicationsEncoded << "\n";
+    }
+    m_statsFile.flush();
+
+    m_statsDumpEvent = Simulator::Schedule(m_statsDumpInterval, &E2Interface::DumpStats, this);
 }
 
 void
@@ -239,18 +978,82 @@ E2Interface::FunctionServiceSubscriptionCallback(E2AP_PDU_t* sub_req_pdu)
 {
     NS_LOG_FUNCTION(this);
     NS_LOG_DEBUG("KPM Subscription Request callback");
-    E2Termination::RicSubscriptionRequest_rval_s params =
+    E2Termination::RicSubscriptionRequest_s request =
         m_e2term->ProcessRicSubscriptionRequest(sub_req_pdu);
-    NS_LOG_DEBUG("requestorId " << +params.requestorId << ", instanceId " << +params.instanceId
-                                << ", ranFuncionId " << +params.ranFuncionId << ", actionId "
-                                << +params.actionId);
+    NS_LOG_DEBUG("requestorId " << +request.requestorId << ", instanceId " << +request.instanceId
+                                << ", " << request.actions.size() << " actions accepted, "
+                                << request.rejectedActionIds.size() << " rejected");
+
+    // The callback may run in the e2sim thread, so the response is encoded and the
+    // table is touched only by the simulator thread
+    Simulator::ScheduleWithContext(1,
+                                   Seconds(0),
+                                   &E2Interface::HandleSubscriptionRequest,
+                                   this,
+                                   request);
+}
 
-    static bool isFirsReportMessage = true;
-    if (isFirsReportMessage)
+void
+E2Interface::HandleSubscriptionRequest(E2Termination::RicSubscriptionRequest_s request)
+{
+    NS_LOG_FUNCTION(this);
+
+    m_e2term->SendRicSubscriptionResponse(request);
+    for (const auto& params : request.actions)
     {
-        NS_LOG_DEBUG("=====> isFirsReportMessage: " << isFirsReportMessage);
-        BuildAndSendReportMessage(params);
-        isFirsReportMessage = false;
+        NS_LOG_DEBUG("ranFuncionId " << +params.ranFuncionId << ", actionId " << +params.actionId
+                                     << ", reportPeriodMs " << params.reportPeriodMs);
+        AddSubscription(params);
+    }
+}
+
+void
+E2Interface::AddSubscription(E2Termination::RicSubscriptionRequest_rval_s params)
+{
+    NS_LOG_FUNCTION(this);
+
+    uint32_t periodMs = params.reportPeriodMs;
+    if (periodMs == 0)
+    {
+        // No period in the event trigger definition, fall back to the default one
+        periodMs = std::max<uint32_t>(1, std::lround(m_e2Periodicity * 1000));
+    }
+
+    SubscriptionKey key{params.requestorId, params.instanceId, params.actionId};
+    auto existing = m_subscriptions.find(key);
+    if (existing != m_subscriptions.end())
+    {
+        // A new request for the same subscription replaces the previous one
+        m_reportGroups[existing->second.periodMs].subscriptions.erase(key);
+    }
+    m_subscriptions[key] = {params, periodMs};
+
+    if (!m_slicingTraceConnected)
+    {
+        // Hook the scheduler to measure when the controls of the RIC take effect
+        auto rlScheduler = DynamicCast<NrRLMacSchedulerOfdma>(
+            DynamicCast<NrGnbNetDevice>(m_netDev)->GetScheduler(0));
+        if (rlScheduler)
+        {
+            rlScheduler->TraceConnectWithoutContext(
+                "SlicingApplied",
+                MakeCallback(&E2Interface::SlicingApplied, this));
+        }
+        m_slicingTraceConnected = true;
+    }
+
+    if (m_statsDumpInterval.IsStrictlyPositive() && !m_statsDumpEvent.IsPending())
+    {
+        m_statsDumpEvent = Simulator::Schedule(m_statsDumpInterval, &E2Interface::DumpStats, this);
+    }
+
+    auto& group = m_reportGroups[periodMs];
+    group.subscriptions.insert(key);
+    if (!group.timer.IsPending())
+    {
+        // First subscription on this period, start its timer
+        group.timer =
+            Simulator::ScheduleNow(&E2Interface::BuildAndSendReportMessage, this, periodMs);
     }
 }
 
@@ -259,9 +1062,68 @@ E2Interface::ControlMessageReceivedCallback(E2AP_PDU_t* sub_req_pdu)
 {
     NS_LOG_DEBUG("Received RIC Control Message");
 
-    Ptr<RicControlMessage> controlMessage = Create<RicControlMessage>(sub_req_pdu);
+    Ptr<RicControlMessage> controlMessage;
+    {
+        NORI_PROFILE(m_profiler, NoriProfiler::CONTROL_DECODE);
+        controlMessage = Create<RicControlMessage>(sub_req_pdu, *m_controlDecoder);
+    }
     NS_LOG_INFO("After RicControlMessage::RicControlMessage constructor");
     NS_LOG_INFO("Request type " << controlMessage->m_requestType);
+
+    auto received = std::chrono::steady_clock::now();
+    bool answersReport = false;
+    uint64_t report = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_loopMutex);
+        auto loop = FindOpenLoop(*controlMessage);
+        if (loop != m_openLoops.end())
+        {
+            answersReport = true;
+            report = loop->second.report;
+            loop->second.received = received;
+            m_loopLatency[ENCODE_SEND].Add(
+                std::chrono::duration<double, std::milli>(loop->second.sent - loop->second.collect)
+                    .count());
+            m_loopLatency[RIC].Add(
+                std::chrono::duration<double, std::milli>(received - loop->second.sent).count());
+            if (controlMessage->m_requestType ==
+                RicControlMessage::ControlMessageRequestIdType::RAN_SLICING)
+            {
+                // Closed when the scheduler first uses the new parameters
+                m_pendingApply = loop->second;
+                m_applyPending = true;
+            }
+            m_openLoops.erase(loop);
+        }
+    }
+
+    // The quotas are handed to the simulator thread before the report is acknowledged,
+    // so that the slot following a lockstep report already uses them
+    {
+        std::lock_guard<std::mutex> lock(m_lockstepMutex);
+        if (controlMessage->m_requestType ==
+            RicControlMessage::ControlMessageRequestIdType::RAN_SLICING)
+        {
+            m_pendingQuotas.insert(m_pendingQuotas.end(),
+                                   controlMessage->m_prbQuotas.begin(),
+                                   controlMessage->m_prbQuotas.end());
+        }
+
+        // Only a control answering an indication acknowledges its report, once. The
+        // other controls, and the answers to the other indications of the report, are
+        // not counted
+        if (m_lockstep && answersReport)
+        {
+            auto outstanding =
+                std::find(m_outstandingReports.begin(), m_outstandingReports.end(), report);
+            if (outstanding != m_outstandingReports.end())
+            {
+                m_outstandingReports.erase(outstanding);
+                m_lockstepCv.notify_one();
+            }
+        }
+    }
+
     switch (controlMessage->m_requestType)
     {
         /**
@@ -275,76 +1137,294 @@ E2Interface::ControlMessageReceivedCallback(E2AP_PDU_t* sub_req_pdu)
          *
         NS_LOG_INFO("TS, do the handover");
         // do handover
-        Ptr<OctetString> imsiString =
-            Create<OctetString>((void*)controlMessage->m_e2SmRcControlHeaderFormat1->ueId.buf,
-                                controlMessage->m_e2SmRcControlHeaderFormat1->ueId.size);
         char* end;
 
-        uint64_t imsi = std::strtoull(imsiString->DecodeContent().c_str(), &end, 10);
+        uint64_t imsi = std::strtoull(controlMessage->m_ueId.c_str(), &end, 10);
         uint16_t targetCellId = std::stoi(controlMessage->GetSecondaryCellIdHO());
         NS_LOG_INFO("Imsi Decoded: " << imsi);
         NS_LOG_INFO("Target Cell id " << targetCellId);
         m_rrc->TakeUeHoControl(imsi);
         if (!m_forceE2FileLogging)
         {
-            Simulator::ScheduleWithContext(1,
-                                           Seconds(0),
-                                           &LteEnbRrc::PerformHandoverToTargetCell,
-                                           m_rrc,
-                                           imsi,
-                                           targetCellId);
+            Simulator::ScheduleWithContext(1,
+                                           Seconds(0),
+                                           &LteEnbRrc::PerformHandoverToTargetCell,
+                                           m_rrc,
+                                           imsi,
+                                           targetCellId);
+        }
+        else
+        {
+            Simulator::Schedule(Seconds(0),
+                                &LteEnbRrc::PerformHandoverToTargetCell,
+                                m_rrc,
+                                imsi,
+                                targetCellId);
+        }
+        break;
+        */
+    }
+    case RicControlMessage::ControlMessageRequestIdType::QoS: {
+        // use SetUeQoS()
+        NS_FATAL_ERROR("Not implemented yet.");
+        break;
+    }
+    case RicControlMessage::ControlMessageRequestIdType::RAN_SLICING: {
+        auto gnbNetDev = DynamicCast<NrGnbNetDevice>(m_netDev);
+        NS_ASSERT(gnbNetDev);
+
+        auto scheduler = gnbNetDev->GetScheduler(0);
+        auto rlScheduler = DynamicCast<NrRLMacSchedulerOfdma>(scheduler);
+        NS_ABORT_MSG_UNLESS(rlScheduler, "Scheduler is not a RL OFDMA scheduler");
+        if (m_e2term->IsShmTransport())
+        {
+            // The control ring is read by the simulator thread
+            ApplyPendingQuotas();
+        }
+        else
+        {
+            // Unless a lockstep wait applies them first, when the simulator resumes
+            Simulator::ScheduleWithContext(1, Seconds(0), &E2Interface::ApplyPendingQuotas, this);
+        }
+
+        break;
+    }
+    case RicControlMessage::ControlMessageRequestIdType::NOOP_ACK: {
+        NS_LOG_DEBUG("Report acknowledged without action");
+        break;
+    }
+    default: {
+        NS_LOG_ERROR("Unrecognized id type of Ric Control Message");
+        break;
+    }
+    }
+}
+
+std::map<IndicationKey, E2Interface::LoopTimestamps>::iterator
+E2Interface::FindOpenLoop(const RicControlMessage& control)
+{
+    uint16_t requestorId = control.m_ricRequestId.ricRequestorID;
+    uint16_t instanceId = control.m_ricRequestId.ricInstanceID;
+
+    const std::string& callProcessId = control.m_ricCallProcessId;
+    if (!callProcessId.empty() && std::isdigit((unsigned char)callProcessId[0]))
+    {
+        char* end = nullptr;
+        unsigned long long sequenceNumber = std::strtoull(callProcessId.c_str(), &end, 10);
+        if (*end == '\0' && sequenceNumber <= UINT32_MAX)
+        {
+            return m_openLoops.find(
+                {requestorId, instanceId, static_cast<uint32_t>(sequenceNumber)});
+        }
+    }
+
+    // Last open indication of the subscription, the keys are sorted by SN within it
+    auto loop = m_openLoops.upper_bound({requestorId, instanceId, UINT32_MAX});
+    if (loop == m_openLoops.begin())
+    {
+        return m_openLoops.end();
+    }
+    loop--;
+    if (std::get<0>(loop->first) != requestorId || std::get<1>(loop->first) != instanceId)
+    {
+        return m_openLoops.end();
+    }
+    return loop;
+}
+
+void
+E2Interface::SlicingApplied()
+{
+    NS_LOG_FUNCTION(this);
+
+    auto applied = std::chrono::steady_clock::now();
+    LoopTimestamps loop;
+    double latency[NUM_LOOP_STAGES];
+    {
+        std::lock_guard<std::mutex> lock(m_loopMutex);
+        if (!m_applyPending)
+        {
+            // Not a control from the RIC
+            return;
+        }
+        loop = m_pendingApply;
+        m_applyPending = false;
+
+        using Ms = std::chrono::duration<double, std::milli>;
+        latency[ENCODE_SEND] = Ms(loop.sent - loop.collect).count();
+        latency[RIC] = Ms(loop.received - loop.sent).count();
+        latency[APPLY] = Ms(applied - loop.received).count();
+        latency[TOTAL] = Ms(applied - loop.collect).count();
+        latency[TOTAL_SIM] = (Simulator::Now() - loop.collectSim).GetSeconds() * 1e3;
+        m_loopLatency[APPLY].Add(latency[APPLY]);
+        m_loopLatency[TOTAL].Add(latency[TOTAL]);
+        m_loopLatency[TOTAL_SIM].Add(latency[TOTAL_SIM]);
+    }
+
+    NS_LOG_DEBUG("Loop of indication " << loop.sequenceNumber << " closed in " << latency[TOTAL]
+                                       << " ms, " << latency[TOTAL_SIM] << " ms of simulation");
+    m_closedLoopLatencyTrace(m_cellId,
+                             loop.sequenceNumber,
+                             latency[ENCODE_SEND],
+                             latency[RIC],
+                             latency[APPLY],
+                             latency[TOTAL],
+                             latency[TOTAL_SIM]);
+}
+
+void
+E2Interface::PrintClosedLoopLatency(std::ostream& os) const
+{
+    static const char* stageNames[NUM_LOOP_STAGES] =
+        {"encode-send", "ric", "apply", "total", "total-sim"};
+
+    std::lock_guard<std::mutex> lock(m_loopMutex);
+    os << "stage\tcount\tmean_ms\tp50_ms\tp99_ms\tmax_ms\n";
+    for (int stage = 0; stage < NUM_LOOP_STAGES; stage++)
+    {
+        const auto& histogram = m_loopLatency[stage];
+        os << stageNames[stage] << "\t" << histogram.GetCount() << "\t" << histogram.GetMean()
+           << "\t" << histogram.GetPercentile(50) << "\t" << histogram.GetPercentile(99) << "\t"
+           << histogram.GetMax() << "\n";
+    }
+}
+
+void
+E2Interface::PrintProfile(std::ostream& os) const
+{
+    if (m_profiler)
+    {
+        m_profiler->Print(os);
+    }
+}
+
+void
+E2Interface::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+
+    if (m_profiler)
+    {
+        std::string fileName = m_profileFilePrefix + "-" + std::to_string(m_cellId) + ".txt";
+        std::ofstream file(fileName);
+        if (file.is_open())
+        {
+            PrintProfile(file);
+        }
+        else
+        {
+            NS_LOG_ERROR("Can't open file " << fileName);
+        }
+    }
+
+    if (m_loopLatency[ENCODE_SEND].GetCount() > 0)
+    {
+        std::string fileName = m_latencyFilePrefix + "-" + std::to_string(m_cellId) + ".txt";
+        std::ofstream file(fileName);
+        if (file.is_open())
+        {
+            PrintClosedLoopLatency(file);
         }
         else
         {
-            Simulator::Schedule(Seconds(0),
-                                &LteEnbRrc::PerformHandoverToTargetCell,
-                                m_rrc,
-                                imsi,
-                                targetCellId);
+            NS_LOG_ERROR("Can't open file " << fileName);
         }
-        break;
-        */
     }
-    case RicControlMessage::ControlMessageRequestIdType::QoS: {
-        // use SetUeQoS()
-        NS_FATAL_ERROR("Not implemented yet.");
-        break;
+    if (m_statsFile.is_open())
+    {
+        m_statsFile.close();
     }
-    case RicControlMessage::ControlMessageRequestIdType::RAN_SLICING: {
-        auto gnbNetDev = DynamicCast<NrGnbNetDevice>(m_netDev);
-        NS_ASSERT(gnbNetDev);
+    m_statsDumpEvent.Cancel();
+    Object::DoDispose();
+}
 
-        auto scheduler = gnbNetDev->GetScheduler(0);
-        auto rlScheduler = DynamicCast<NrRLMacSchedulerOfdma>(scheduler);
-        NS_ABORT_MSG_UNLESS(rlScheduler, "Scheduler is not a RL OFDMA scheduler");
-        rlScheduler->SetSlicingParameters(controlMessage->m_prbQuotas);
+void
+E2Interface::WaitForRic()
+{
+    NS_LOG_FUNCTION(this);
 
-        break;
+    std::unique_lock<std::mutex> lock(m_lockstepMutex);
+    m_outstandingReports.push_back(m_report);
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::nanoseconds(m_lockstepTimeout.GetNanoSeconds());
+    while (m_outstandingReports.size() >= m_lockstepLookahead)
+    {
+        if (m_e2term->IsShmTransport())
+        {
+            // The control ring is read by this thread, so poll it while waiting
+            lock.unlock();
+            m_e2term->ProcessControlRing();
+            lock.lock();
+            if (m_outstandingReports.size() < m_lockstepLookahead)
+            {
+                break;
+            }
+            m_lockstepCv.wait_for(lock, std::chrono::microseconds(50));
+        }
+        else
+        {
+            m_lockstepCv.wait_until(lock, deadline);
+        }
+
+        if (std::chrono::steady_clock::now() >= deadline &&
+            m_outstandingReports.size() >= m_lockstepLookahead)
+        {
+            NS_LOG_WARN("Cell " << m_cellId << ": no answer from the RIC within "
+                                << m_lockstepTimeout.As(Time::MS) << ", moving on");
+            m_outstandingReports.pop_front();
+            m_lockstepTimeouts++;
+        }
     }
-    default: {
-        NS_LOG_ERROR("Unrecognized id type of Ric Control Message");
-        break;
+    lock.unlock();
+    ApplyPendingQuotas();
+}
+
+void
+E2Interface::ApplyPendingQuotas()
+{
+    std::vector<RicControlMessage::SlicePRBQuota> quotas;
+    {
+        std::lock_guard<std::mutex> lock(m_lockstepMutex);
+        quotas.swap(m_pendingQuotas);
     }
+    if (quotas.empty())
+    {
+        return;
     }
+
+    NS_LOG_FUNCTION(this << quotas.size());
+    auto rlScheduler = DynamicCast<NrRLMacSchedulerOfdma>(
+        DynamicCast<NrGnbNetDevice>(m_netDev)->GetScheduler(0));
+    NS_ABORT_MSG_UNLESS(rlScheduler, "Scheduler is not a RL OFDMA scheduler");
+    rlScheduler->SetSlicingParameters(quotas);
 }
 
 void
-E2Interface::SetE2PdcpStatsCalculator(Ptr<NrBearerStatsCalculator> e2PdcpStatsCalculator)
+E2Interface::SetE2PdcpStatsCalculator(Ptr<NoriBearerStats> e2PdcpStatsCalculator)
 {
     NS_LOG_FUNCTION(this);
     m_e2PdcpStatsCalculator = e2PdcpStatsCalculator;
 }
 
 void
-E2Interface::SetE2RlcStatsCalculator(Ptr<NrBearerStatsCalculator> e2RlcStatsCalculator)
+E2Interface::SetE2RlcStatsCalculator(Ptr<NoriBearerStats> e2RlcStatsCalculator)
 {
     NS_LOG_FUNCTION(this);
     m_e2RlcStatsCalculator = e2RlcStatsCalculator;
 }
 
-Ptr<KpmIndicationMessage>
-E2Interface::BuildRicIndicationMessageCuUp(std::string plmId)
+Ptr<IndicationMessageHelper>
+E2Interface::BuildRicIndicationMessageCuUp(std::string plmId,
+                                           uint64_t measurementMask,
+                                           DeltaState* delta,
+                                           CounterBaseline& baseline)
 {
+    NORI_PROFILE(m_profiler, NoriProfiler::BUILD_CU_UP);
+    if ((measurementMask & KPM_MEAS_CU_UP) == 0)
+    {
+        return nullptr;
+    }
+
     /**
      * Force logging and reduced pmvalues not avaliable
      */
@@ -352,6 +1432,7 @@ E2Interface::BuildRicIndicationMessageCuUp(std::string plmId)
         Create<MmWaveIndicationMessageHelper>(IndicationMessageHelper::IndicationMessageType::CuUp,
                                               false,
                                               false);
+    indicationMessageHelper->SetMeasurementMask(measurementMask);
 
     // get <rnti, NrUeManager> map of connected UEs
     ObjectMapValue ueManager;
@@ -391,29 +1472,27 @@ E2Interface::BuildRicIndicationMessageCuUp(std::string plmId)
         // double rxDlPackets = m_e2PdcpStatsCalculator->GetDlRxPackets(imsi, 4); // LCID 3 is used
         // for data
         // Get the tx packets in DL flow
-        long txDlPackets = m_e2PdcpStatsCalculator->GetDlTxPackets(imsi, 4) -
-                           m_cellTxDlPackets; // LCID 3 is used for data
-        m_cellTxDlPackets += txDlPackets;
+        uint64_t totalTxDlPackets = m_e2PdcpStatsCalculator->GetDlTxPackets(imsi, 4);
+        long txDlPackets = totalTxDlPackets - baseline.dlTxPackets[imsi]; // LCID 3 is used for data
+        baseline.dlTxPackets[imsi] = totalTxDlPackets;
         // Get the tx kbits
         double actualTotalTxBytes = m_e2PdcpStatsCalculator->GetDlTxData(imsi, 4) * (8 / 1e3);
-        if (m_cellTxBytes.find(imsi) == m_cellTxBytes.end())
-        {
-            m_cellTxBytes.insert(std::make_pair(imsi, 0));
-        }
-        double txBytes = (actualTotalTxBytes - m_cellTxBytes[imsi]); // in kbit, not byte
+        double txBytes = (actualTotalTxBytes - baseline.dlTxKbit[imsi]); // in kbit, not byte
 
-        NS_LOG_DEBUG("Actual value of TX bytes: " << (actualTotalTxBytes) << " - " << m_cellTxBytes[imsi]
+        NS_LOG_DEBUG("Actual value of TX bytes: " << (actualTotalTxBytes) << " - "
+                                                  << baseline.dlTxKbit[imsi]
                                                   << ", Result = " << txBytes);
         // Save the current value to validate the tx bits in this frame window
-        m_cellTxBytes[imsi] += txBytes;
+        baseline.dlTxKbit[imsi] = actualTotalTxBytes;
 
         // Get the rx kbit
         double actualTotalRxBytes = m_e2PdcpStatsCalculator->GetDlRxData(imsi, 4) * (8 / 1e3);
-        double rxBytes = (actualTotalRxBytes - m_cellRxBytes); // in kbit, not byte
-        NS_LOG_DEBUG("Actual value of RX bytes: " << (actualTotalRxBytes) << " - " << m_cellRxBytes
+        double rxBytes = (actualTotalRxBytes - baseline.dlRxKbit[imsi]); // in kbit, not byte
+        NS_LOG_DEBUG("Actual value of RX bytes: " << (actualTotalRxBytes) << " - "
+                                                  << baseline.dlRxKbit[imsi]
                                                   << ", Result = " << rxBytes);
         // Save the current value to validate the rx bits in this frame window
-        m_cellRxBytes += rxBytes;
+        baseline.dlRxKbit[imsi] = actualTotalRxBytes;
 
         // Cell volume metrics
         cellDlTxVolume += txBytes;
@@ -428,29 +1507,34 @@ E2Interface::BuildRicIndicationMessageCuUp(std::string plmId)
         auto rnti = ue->GetRnti();
         // All the drbs report in the same callback function, all the PDU information is being
         // summed in the ReportTxPDU.
-        // Tx PDUs in the reporting period, only get in this time window
-        // and then reset it
-        txPdcpPduNrRlc += m_txPDU[rnti];
-        txPdcpPduBytesNrRlc += m_txPDUBytes[rnti];
-        // Reset counting in the frame time
-        m_txPDU[rnti] = 0;
-        m_txPDUBytes[rnti] = 0;
+        // Tx PDUs in the reporting period, since the last report of the group
+        uint32_t ueIndex = GetUeCounterIndex(rnti);
+        if (baseline.ue.size() < m_ueCounters.size())
+        {
+            baseline.ue.resize(m_ueCounters.size());
+        }
+        const auto& counters = m_ueCounters[ueIndex];
+        auto& start = baseline.ue[ueIndex];
+        // Modulo 2^32, a counter that wrapped within the window still counts
+        txPdcpPduNrRlc += static_cast<uint32_t>(counters.txPdus - start.txPdus);
+        txPdcpPduBytesNrRlc += counters.txPduBytes - start.txPduBytes;
+        // Start the next window of the group here
+        start = counters;
 
         NS_LOG_DEBUG("Number of Tx PDCP PDU in NR RLC: " << txPdcpPduNrRlc
                                                          << ", in bytes: " << txPdcpPduBytesNrRlc);
         // Use kbit instead of byte
         txPdcpPduBytesNrRlc *= 8 / 1e3;
 
-        // compute mean latency based on PDCP statistics
-        /** TODO: Actually, it returns the average latency and i don't know how to reset it */
+        // compute mean latency based on PDCP statistics, over the last window of the calculator
         [[maybe_unused]] auto stats = m_e2PdcpStatsCalculator->GetDlDelayStats(imsi, 4);
         double pdcpLatency = m_e2PdcpStatsCalculator->GetDlDelay(imsi, 4) / 1e5; // unit: x 0.1 ms
         perUserAverageLatencySum += pdcpLatency;
 
-        double pdcpThroughput = txBytes / m_e2Periodicity;                    // unit kbps
+        double pdcpThroughput = txBytes / m_reportWindow.GetSeconds(); // unit kbps
         std::cout << "imsi: " << imsi <<" -> " << pdcpThroughput << " kbps" << std::endl;
         
-        [[maybe_unused]] double pdcpThroughputRx = rxBytes / m_e2Periodicity; // unit kbps
+        [[maybe_unused]] double pdcpThroughputRx = rxBytes / m_reportWindow.GetSeconds(); // kbps
 
         if (m_drbThrDlPdcpBasedComputationUeid.find(imsi) !=
             m_drbThrDlPdcpBasedComputationUeid.end())
@@ -479,7 +1563,12 @@ E2Interface::BuildRicIndicationMessageCuUp(std::string plmId)
                          << " pdcpLatency " << pdcpLatency << " pdcpThroughput " << pdcpThroughput
                          << " rlcBitrate " << rlcBitrate);
 
-        if (!indicationMessageHelper->IsOffline())
+        bool reportUe = delta == nullptr ||
+                        HasUeChanged(delta->cuUpValues,
+                                     imsi,
+                                     {txPdcpPduBytesNrRlc, (double)txPdcpPduNrRlc, pdcpThroughput},
+                                     delta->keyframe);
+        if (!indicationMessageHelper->IsOffline() && reportUe)
         {
             indicationMessageHelper->AddCuUpUePmItem(ueImsiComplete,
                                                      txPdcpPduBytesNrRlc,
@@ -502,7 +1591,7 @@ E2Interface::BuildRicIndicationMessageCuUp(std::string plmId)
                      << " in cell ID: " << m_cellId
                      << " with this DL TX cell volume: " << cellDlTxVolume);
 
-    return indicationMessageHelper->CreateIndicationMessage();
+    return indicationMessageHelper;
 }
 
 std::string
@@ -526,41 +1615,95 @@ E2Interface::GetImsiString(uint64_t imsi)
 }
 
 void
-E2Interface::ReportTxPDU(uint16_t rnti, uint8_t lcid, uint32_t packetSize)
+E2Interface::NotifyHandoverStart(uint64_t imsi,
+                                 uint16_t cellId,
+                                 uint16_t rnti,
+                                 uint16_t targetCellId)
 {
-    NS_LOG_DEBUG("Report Tx PDUs for RNTI: " << rnti << " lcid: " << lcid
-                                             << " packetSize: " << packetSize << " bytes");
+    NS_LOG_FUNCTION(this << imsi << cellId << rnti << targetCellId);
+    m_handoverImsis.insert(imsi);
+}
 
-    if (m_txPDU.find(rnti) == m_txPDU.end())
-    {
-        NS_LOG_DEBUG("First PDU for RNTI: " << rnti);
-        m_txPDU.insert(std::make_pair(rnti, 1));
-    }
-    else
+void
+E2Interface::NotifyConnectionRelease(uint64_t imsi, uint16_t cellId, uint16_t rnti)
+{
+    NS_LOG_FUNCTION(this << imsi << cellId << rnti);
+    // The history is shared by the gNBs, the target cell goes on with it
+    if (m_handoverImsis.erase(imsi) == 0 && m_ueKpiHistory)
     {
-        NS_LOG_DEBUG("Increment PDU for RNTI: " << rnti);
-        m_txPDU[rnti] += 1;
+        m_ueKpiHistory->Remove(imsi);
     }
+}
+
+void
+E2Interface::ConnectDrbTxPdu(uint64_t imsi, uint16_t cellId, uint16_t rnti, uint8_t lcid)
+{
+    NS_LOG_FUNCTION(this << imsi << cellId << rnti << +lcid);
 
-    if (m_txPDUBytes.find(rnti) == m_txPDUBytes.end())
+    ObjectMapValue drbMap;
+    m_rrc->GetUeManager(rnti)->GetAttribute("DataRadioBearerMap", drbMap);
+    for (auto dr = drbMap.Begin(); dr != drbMap.End(); dr++)
     {
-        NS_LOG_DEBUG("First PDU bytes for RNTI: " << rnti << " packetSize: " << packetSize);
-        m_txPDUBytes.insert(std::make_pair(rnti, packetSize));
+        UintegerValue drbLcid;
+        dr->second->GetAttribute("LogicalChannelIdentity", drbLcid);
+        if (drbLcid.Get() != lcid)
+        {
+            continue;
+        }
+        PointerValue rlcPtr;
+        dr->second->GetAttribute("NrRlc", rlcPtr);
+        auto rlc = rlcPtr.Get<NrRlc>();
+        NS_ABORT_MSG_IF(rlc == nullptr, "DRB " << +lcid << " of RNTI " << rnti << " has no RLC");
+        // The index of the UE counters is bound, so that each PDU is a single add
+        rlc->TraceConnectWithoutContext(
+            "TxPDU",
+            MakeCallback(&E2Interface::ReportTxPDU, this).Bind(GetUeCounterIndex(rnti)));
+        return;
     }
-    else
+    NS_LOG_WARN("DRB " << +lcid << " of RNTI " << rnti << " not found");
+}
+
+uint32_t
+E2Interface::GetUeCounterIndex(uint16_t rnti)
+{
+    auto it = m_ueCounterIndex.find(rnti);
+    if (it != m_ueCounterIndex.end())
     {
-        NS_LOG_DEBUG("Increment PDU bytes for RNTI: " << rnti << " packetSize: " << packetSize);
-        m_txPDUBytes[rnti] += packetSize;
+        return it->second;
     }
+    uint32_t index = m_ueCounters.size();
+    m_ueCounters.emplace_back();
+    m_ueCounterIndex.emplace(rnti, index);
+    return index;
 }
 
-Ptr<KpmIndicationMessage>
-E2Interface::BuildRicIndicationMessageCuCp(std::string plmId)
+void
+E2Interface::ReportTxPDU(uint32_t ueIndex,
+                         [[maybe_unused]] uint16_t rnti,
+                         [[maybe_unused]] uint8_t lcid,
+                         uint32_t packetSize)
+{
+    NORI_PROFILE(m_profiler, NoriProfiler::TRACE_TX_PDU);
+    auto& counters = m_ueCounters[ueIndex];
+    counters.txPdus++;
+    counters.txPduBytes += packetSize;
+}
+
+Ptr<IndicationMessageHelper>
+E2Interface::BuildRicIndicationMessageCuCp(std::string plmId, uint64_t measurementMask)
 {
+    NORI_PROFILE(m_profiler, NoriProfiler::BUILD_CU_CP);
+    if ((measurementMask & KPM_MEAS_CU_CP) == 0)
+    {
+        return nullptr;
+    }
+
     Ptr<MmWaveIndicationMessageHelper> indicationMessageHelper =
         Create<MmWaveIndicationMessageHelper>(IndicationMessageHelper::IndicationMessageType::CuCp,
                                               false,
                                               false);
+    indicationMessageHelper->SetMeasurementMask(measurementMask);
+    bool reportL3Sinr = indicationMessageHelper->IsRequested(KPM_MEAS_L3_SINR);
     ObjectMapValue ueManager;
     m_rrc->GetAttribute("UeMap", ueManager);
 
@@ -623,43 +1766,49 @@ E2Interface::BuildRicIndicationMessageCuCp(std::string plmId)
         double sinr;
         std::string neighStr;
 
-        // invert key and value in sortFlipMap, then sort by value
-        std::multimap<long double, uint16_t> sortFlipMap = FlipMap(m_l3sinrMap[rnti]);
-        // new sortFlipMap structure sortFlipMap < sinr, cellId >
-        // The assumption is that the first cell in the scenario is always NR
-        uint16_t nNeighbours = E2SM_REPORT_MAX_NEIGH;
-        if (m_l3sinrMap[rnti].size() < nNeighbours)
-        {
-            nNeighbours = m_l3sinrMap[rnti].size() - 1;
-        }
-        int itIndex = 0;
-        // Save only the first E2SM_REPORT_MAX_NEIGH SINR for each UE which represent the best
-        // values among all the SINRs detected by all the cells
-        for (auto it = --sortFlipMap.end(); it != --sortFlipMap.begin() && itIndex < nNeighbours;
-             it--)
+        // The neighbour sorting is the most expensive part of the CU-CP report, skip it
+        // when no subscription asked for the L3 SINR
+        if (reportL3Sinr)
         {
-            uint16_t cellId = it->second;
-            NS_LOG_DEBUG("Sort flipMap cellId: " << cellId << " m_cellId: " << m_cellId);
-            if (cellId != m_cellId)
+            // invert key and value in sortFlipMap, then sort by value
+            std::multimap<long double, uint16_t> sortFlipMap = FlipMap(m_l3sinrMap[rnti]);
+            // new sortFlipMap structure sortFlipMap < sinr, cellId >
+            // The assumption is that the first cell in the scenario is always NR
+            uint16_t nNeighbours = E2SM_REPORT_MAX_NEIGH;
+            if (m_l3sinrMap[rnti].size() < nNeighbours)
+            {
+                nNeighbours = m_l3sinrMap[rnti].size() - 1;
+            }
+            int itIndex = 0;
+            // Save only the first E2SM_REPORT_MAX_NEIGH SINR for each UE which represent the best
+            // values among all the SINRs detected by all the cells
+            for (auto it = --sortFlipMap.end();
+                 it != --sortFlipMap.begin() && itIndex < nNeighbours;
+                 it--)
             {
-                sinr = it->first; // now SINR is a key due to the sort of the map
-                convertedSinr = L3RrcMeasurements::ThreeGppMapSinr(sinr);
-                if (!indicationMessageHelper->IsOffline())
+                uint16_t cellId = it->second;
+                NS_LOG_DEBUG("Sort flipMap cellId: " << cellId << " m_cellId: " << m_cellId);
+                if (cellId != m_cellId)
                 {
-                    l3RrcMeasurementNeigh->AddNeighbourCellMeasurement(cellId, convertedSinr);
+                    sinr = it->first; // now SINR is a key due to the sort of the map
+                    convertedSinr = L3RrcMeasurements::ThreeGppMapSinr(sinr);
+                    if (!indicationMessageHelper->IsOffline())
+                    {
+                        l3RrcMeasurementNeigh->AddNeighbourCellMeasurement(cellId, convertedSinr);
+                    }
+                    NS_LOG_INFO(Simulator::Now().GetSeconds()
+                                << " enbdev " << m_cellId << " UE " << imsi << " L3 neigh "
+                                << cellId << " SINR " << sinr << " sinr encoded " << convertedSinr
+                                << " first insert");
+                    neighStr += "," + std::to_string(cellId) + "," + std::to_string(sinr) + "," +
+                                std::to_string(convertedSinr);
+                    itIndex++;
                 }
-                NS_LOG_INFO(Simulator::Now().GetSeconds()
-                            << " enbdev " << m_cellId << " UE " << imsi << " L3 neigh " << cellId
-                            << " SINR " << sinr << " sinr encoded " << convertedSinr
-                            << " first insert");
-                neighStr += "," + std::to_string(cellId) + "," + std::to_string(sinr) + "," +
-                            std::to_string(convertedSinr);
-                itIndex++;
             }
-        }
-        for (int i = nNeighbours; i < E2SM_REPORT_MAX_NEIGH; i++)
-        {
-            neighStr += ",,,";
+            for (int i = nNeighbours; i < E2SM_REPORT_MAX_NEIGH; i++)
+            {
+                neighStr += ",,,";
+            }
         }
 
         uePmString.insert(std::make_pair(imsi, servingStr + neighStr));
@@ -721,21 +1870,48 @@ E2Interface::BuildRicIndicationMessageCuCp(std::string plmId)
     else
     {
      */
-    return indicationMessageHelper->CreateIndicationMessage();
+    return indicationMessageHelper;
     //}
 }
 
-Ptr<KpmIndicationMessage>
-E2Interface::BuildRicIndicationMessageDu(std::string plmId, uint16_t nrCellId)
+Ptr<IndicationMessageHelper>
+E2Interface::BuildRicIndicationMessageDu(std::string plmId,
+                                         uint16_t nrCellId,
+                                         uint64_t measurementMask,
+                                         DeltaState* delta,
+                                         CounterBaseline& baseline)
 {
+    NORI_PROFILE(m_profiler, NoriProfiler::BUILD_DU);
+    if ((measurementMask & KPM_MEAS_DU) == 0)
+    {
+        return nullptr;
+    }
+
     Ptr<MmWaveIndicationMessageHelper> indicationMessageHelper =
         Create<MmWaveIndicationMessageHelper>(IndicationMessageHelper::IndicationMessageType::Du,
                                               false,
                                               false);
+    indicationMessageHelper->SetMeasurementMask(measurementMask);
+    bool reportTb = indicationMessageHelper->IsRequested(KPM_MEAS_TB);
+    bool reportMcs = indicationMessageHelper->IsRequested(KPM_MEAS_MCS);
+    bool reportSinrBins = indicationMessageHelper->IsRequested(KPM_MEAS_SINR_BINS);
+    // The cell MAC volume is reported as QosFlow.PdcpPduVolumeDL_Filter
+    bool reportVolume = indicationMessageHelper->IsRequested(KPM_MEAS_PDCP);
+    bool reportBuffer = indicationMessageHelper->IsRequested(KPM_MEAS_BUFFER);
+    // The KPI stores and histories keep every measurement, whatever the subscriptions of
+    // this report ask for
+    bool keepKpis = m_ueKpiStore || m_ueKpiHistory || m_cellKpiStore || m_cellKpiHistory;
+    bool computeTb = reportTb || keepKpis;
+    bool computeMcs = reportMcs || keepKpis;
+    bool computeSinrBins = reportSinrBins || keepKpis;
+    bool computeVolume = reportVolume || keepKpis;
 
     ObjectMapValue ueManager;
     m_rrc->GetAttribute("UeMap", ueManager);
 
+    // Counters of the UEs at the previous DU report of the group
+    NoriE2Report::Baseline& base = baseline.du;
+
     uint32_t macPduCellSpecific = 0;
     uint32_t macPduInitialCellSpecific = 0;
     uint32_t macVolumeCellSpecific = 0;
@@ -765,6 +1941,7 @@ E2Interface::BuildRicIndicationMessageDu(std::string plmId, uint16_t nrCellId)
     m_cellId = nrCellId;
 
     std::unordered_map<uint64_t, std::string> uePmStringDu{};
+    int64_t timestamp = m_startTime + Simulator::Now().GetMilliSeconds();
 
     for (auto ueMap = ueManager.Begin(); ueMap != ueManager.End(); ueMap++)
     {
@@ -773,94 +1950,90 @@ E2Interface::BuildRicIndicationMessageDu(std::string plmId, uint16_t nrCellId)
         std::string ueImsiComplete = GetImsiString(imsi);
         uint16_t rnti = ue->GetRnti();
 
-        uint32_t macPduUe = m_e2DuCalculator->GetMacPduUeSpecific(rnti, m_cellId);
+        uint32_t macPduUe =
+            computeTb ? m_e2DuCalculator->GetMacPduUeSpecific(rnti, m_cellId, base) : 0;
         macPduCellSpecific += macPduUe;
 
         uint32_t macPduInitialUe =
-            m_e2DuCalculator->GetMacPduInitialTransmissionUeSpecific(rnti, m_cellId);
+            computeTb
+                ? m_e2DuCalculator->GetMacPduInitialTransmissionUeSpecific(rnti, m_cellId, base)
+                : 0;
         macPduInitialCellSpecific += macPduInitialUe;
 
-        uint32_t macVolume = m_e2DuCalculator->GetMacVolumeUeSpecific(rnti, m_cellId);
+        uint32_t macVolume =
+            computeVolume ? m_e2DuCalculator->GetMacVolumeUeSpecific(rnti, m_cellId, base) : 0;
         macVolumeCellSpecific += macVolume;
 
-        uint32_t macQpsk = m_e2DuCalculator->GetMacPduQpskUeSpecific(rnti, m_cellId);
+        uint32_t macQpsk =
+            computeTb ? m_e2DuCalculator->GetMacPduQpskUeSpecific(rnti, m_cellId, base) : 0;
         macQpskCellSpecific += macQpsk;
 
-        uint32_t mac16Qam = m_e2DuCalculator->GetMacPdu16QamUeSpecific(rnti, m_cellId);
+        uint32_t mac16Qam =
+            computeTb ? m_e2DuCalculator->GetMacPdu16QamUeSpecific(rnti, m_cellId, base) : 0;
         mac16QamCellSpecific += mac16Qam;
 
-        uint32_t mac64Qam = m_e2DuCalculator->GetMacPdu64QamUeSpecific(rnti, m_cellId);
+        uint32_t mac64Qam =
+            computeTb ? m_e2DuCalculator->GetMacPdu64QamUeSpecific(rnti, m_cellId, base) : 0;
         mac64QamCellSpecific += mac64Qam;
 
-        uint32_t macRetx = m_e2DuCalculator->GetMacPduRetransmissionUeSpecific(rnti, m_cellId);
+        uint32_t macRetx =
+            computeTb ? m_e2DuCalculator->GetMacPduRetransmissionUeSpecific(rnti, m_cellId, base)
+                     : 0;
         macRetxCellSpecific += macRetx;
 
-        // Numerator = (Sum of number of symbols across all rows (TTIs) group by cell ID and UE ID
-        // within a given time window)
-        double macNumberOfSymbols =
-            m_e2DuCalculator->GetMacNumberOfSymbolsUeSpecific(rnti, m_cellId);
-
-        auto slotPeriod = DynamicCast<NrGnbNetDevice>(m_netDev)->GetPhy(0)->GetSlotPeriod();
-
-        ObjectMapValue ccMapObject;
-        DynamicCast<NrGnbNetDevice>(m_netDev)->GetAttribute("BandwidthPartMap", ccMapObject);
-
-        // Denominator = (Periodicity of the report time window in ms*number of TTIs per ms*14)
-        Time reportingWindow =
-            Simulator::Now() - m_e2DuCalculator->GetLastResetTime(rnti, m_cellId);
-        double denominatorPrb =
-            std::ceil(reportingWindow.GetNanoSeconds() / slotPeriod.GetNanoSeconds()) * 14;
-
-        NS_LOG_DEBUG("macNumberOfSymbols " << macNumberOfSymbols << " denominatorPrb "
-                                           << denominatorPrb);
-
-        // Average Number of PRBs allocated for the UE = (NR/DR)*139 (where 139 is the total number
-        // of PRBs available per NR cell, given numerology 2 with 60 kHz SCS)
-        double macPrb = 0;
-        if (denominatorPrb != 0)
-        {
-            macPrb = macNumberOfSymbols / denominatorPrb *
-                     139; // TODO fix this for different numerologies
-        }
+        double macPrb = ComputeMacPrb(rnti, base);
         macPrbsCellSpecific += macPrb;
 
-        uint32_t macMac04 = m_e2DuCalculator->GetMacMcs04UeSpecific(rnti, m_cellId);
+        uint32_t macMac04 =
+            computeMcs ? m_e2DuCalculator->GetMacMcs04UeSpecific(rnti, m_cellId, base) : 0;
         macMac04CellSpecific += macMac04;
 
-        uint32_t macMac59 = m_e2DuCalculator->GetMacMcs59UeSpecific(rnti, m_cellId);
+        uint32_t macMac59 =
+            computeMcs ? m_e2DuCalculator->GetMacMcs59UeSpecific(rnti, m_cellId, base) : 0;
         macMac59CellSpecific += macMac59;
 
-        uint32_t macMac1014 = m_e2DuCalculator->GetMacMcs1014UeSpecific(rnti, m_cellId);
+        uint32_t macMac1014 =
+            computeMcs ? m_e2DuCalculator->GetMacMcs1014UeSpecific(rnti, m_cellId, base) : 0;
         macMac1014CellSpecific += macMac1014;
 
-        uint32_t macMac1519 = m_e2DuCalculator->GetMacMcs1519UeSpecific(rnti, m_cellId);
+        uint32_t macMac1519 =
+            computeMcs ? m_e2DuCalculator->GetMacMcs1519UeSpecific(rnti, m_cellId, base) : 0;
         macMac1519CellSpecific += macMac1519;
 
-        uint32_t macMac2024 = m_e2DuCalculator->GetMacMcs2024UeSpecific(rnti, m_cellId);
+        uint32_t macMac2024 =
+            computeMcs ? m_e2DuCalculator->GetMacMcs2024UeSpecific(rnti, m_cellId, base) : 0;
         macMac2024CellSpecific += macMac2024;
 
-        uint32_t macMac2529 = m_e2DuCalculator->GetMacMcs2529UeSpecific(rnti, m_cellId);
+        uint32_t macMac2529 =
+            computeMcs ? m_e2DuCalculator->GetMacMcs2529UeSpecific(rnti, m_cellId, base) : 0;
         macMac2529CellSpecific += macMac2529;
 
-        uint32_t macSinrBin1 = m_e2DuCalculator->GetMacSinrBin1UeSpecific(rnti, m_cellId);
+        uint32_t macSinrBin1 =
+            computeSinrBins ? m_e2DuCalculator->GetMacSinrBin1UeSpecific(rnti, m_cellId, base) : 0;
         macSinrBin1CellSpecific += macSinrBin1;
 
-        uint32_t macSinrBin2 = m_e2DuCalculator->GetMacSinrBin2UeSpecific(rnti, m_cellId);
+        uint32_t macSinrBin2 =
+            computeSinrBins ? m_e2DuCalculator->GetMacSinrBin2UeSpecific(rnti, m_cellId, base) : 0;
         macSinrBin2CellSpecific += macSinrBin2;
 
-        uint32_t macSinrBin3 = m_e2DuCalculator->GetMacSinrBin3UeSpecific(rnti, m_cellId);
+        uint32_t macSinrBin3 =
+            computeSinrBins ? m_e2DuCalculator->GetMacSinrBin3UeSpecific(rnti, m_cellId, base) : 0;
         macSinrBin3CellSpecific += macSinrBin3;
 
-        uint32_t macSinrBin4 = m_e2DuCalculator->GetMacSinrBin4UeSpecific(rnti, m_cellId);
+        uint32_t macSinrBin4 =
+            computeSinrBins ? m_e2DuCalculator->GetMacSinrBin4UeSpecific(rnti, m_cellId, base) : 0;
         macSinrBin4CellSpecific += macSinrBin4;
 
-        uint32_t macSinrBin5 = m_e2DuCalculator->GetMacSinrBin5UeSpecific(rnti, m_cellId);
+        uint32_t macSinrBin5 =
+            computeSinrBins ? m_e2DuCalculator->GetMacSinrBin5UeSpecific(rnti, m_cellId, base) : 0;
         macSinrBin5CellSpecific += macSinrBin5;
 
-        uint32_t macSinrBin6 = m_e2DuCalculator->GetMacSinrBin6UeSpecific(rnti, m_cellId);
+        uint32_t macSinrBin6 =
+            computeSinrBins ? m_e2DuCalculator->GetMacSinrBin6UeSpecific(rnti, m_cellId, base) : 0;
         macSinrBin6CellSpecific += macSinrBin6;
 
-        uint32_t macSinrBin7 = m_e2DuCalculator->GetMacSinrBin7UeSpecific(rnti, m_cellId);
+        uint32_t macSinrBin7 =
+            computeSinrBins ? m_e2DuCalculator->GetMacSinrBin7UeSpecific(rnti, m_cellId, base) : 0;
         macSinrBin7CellSpecific += macSinrBin7;
         /**
          * TODO: Implement the RLC buffer occupancy (GetTxbuffersize())
@@ -869,7 +2042,10 @@ E2Interface::BuildRicIndicationMessageDu(std::string plmId, uint16_t nrCellId)
         // get buffer occupancy info
         uint32_t rlcBufferOccup = 0;
         ObjectMapValue drbMap;
-        ue->GetAttribute("DataRadioBearerMap", drbMap);
+        if (reportBuffer || keepKpis)
+        {
+            ue->GetAttribute("DataRadioBearerMap", drbMap);
+        }
         for (auto dr = drbMap.Begin(); dr != drbMap.End(); dr++)
         {
             PointerValue nrPtr;
@@ -924,30 +2100,64 @@ E2Interface::BuildRicIndicationMessageDu(std::string plmId, uint16_t nrCellId)
         double drbThrDlUeid =
             m_drbThrDlUeid.find(imsi) != m_drbThrDlUeid.end() ? m_drbThrDlUeid.at(imsi) : 0;
 
-        indicationMessageHelper->AddDuUePmItem(ueImsiComplete,
-                                               macPduUe,
-                                               macPduInitialUe,
-                                               macQpsk,
-                                               mac16Qam,
-                                               mac64Qam,
-                                               macRetx,
-                                               macVolume,
-                                               macPrb,
-                                               macMac04,
-                                               macMac59,
-                                               macMac1014,
-                                               macMac1519,
-                                               macMac2024,
-                                               macMac2529,
-                                               macSinrBin1,
-                                               macSinrBin2,
-                                               macSinrBin3,
-                                               macSinrBin4,
-                                               macSinrBin5,
-                                               macSinrBin6,
-                                               macSinrBin7,
-                                               rlcBufferOccup,
-                                               drbThrDlUeid);
+        // In delta mode, a UE left out of the list has the values it was last sent with,
+        // which skips the idle UEs whose counters stay at zero. Only the measurements
+        // sent count, the ones computed for the KPI stores alone are left out.
+        auto sent = [](bool requested, double value) { return requested ? value : 0; };
+        bool reportUe = delta == nullptr ||
+                        HasUeChanged(delta->duValues,
+                                     imsi,
+                                     {sent(reportTb, macPduUe),
+                                      sent(reportTb, macPduInitialUe),
+                                      sent(reportTb, macQpsk),
+                                      sent(reportTb, mac16Qam),
+                                      sent(reportTb, mac64Qam),
+                                      sent(reportTb, macRetx),
+                                      sent(reportVolume, macVolume),
+                                      macPrb,
+                                      sent(reportMcs, macMac04),
+                                      sent(reportMcs, macMac59),
+                                      sent(reportMcs, macMac1014),
+                                      sent(reportMcs, macMac1519),
+                                      sent(reportMcs, macMac2024),
+                                      sent(reportMcs, macMac2529),
+                                      sent(reportSinrBins, macSinrBin1),
+                                      sent(reportSinrBins, macSinrBin2),
+                                      sent(reportSinrBins, macSinrBin3),
+                                      sent(reportSinrBins, macSinrBin4),
+                                      sent(reportSinrBins, macSinrBin5),
+                                      sent(reportSinrBins, macSinrBin6),
+                                      sent(reportSinrBins, macSinrBin7),
+                                      sent(reportBuffer, rlcBufferOccup),
+                                      drbThrDlUeid},
+                                     delta->keyframe);
+        if (reportUe)
+        {
+            indicationMessageHelper->AddDuUePmItem(ueImsiComplete,
+                                                   macPduUe,
+                                                   macPduInitialUe,
+                                                   macQpsk,
+                                                   mac16Qam,
+                                                   mac64Qam,
+                                                   macRetx,
+                                                   macVolume,
+                                                   macPrb,
+                                                   macMac04,
+                                                   macMac59,
+                                                   macMac1014,
+                                                   macMac1519,
+                                                   macMac2024,
+                                                   macMac2529,
+                                                   macSinrBin1,
+                                                   macSinrBin2,
+                                                   macSinrBin3,
+                                                   macSinrBin4,
+                                                   macSinrBin5,
+                                                   macSinrBin6,
+                                                   macSinrBin7,
+                                                   rlcBufferOccup,
+                                                   drbThrDlUeid);
+        }
 
         uePmStringDu.insert(std::make_pair(
             imsi,
@@ -965,9 +2175,50 @@ E2Interface::BuildRicIndicationMessageDu(std::string plmId, uint16_t nrCellId)
                 std::to_string(drbThrDlUeid) + ',' + std::to_string(drbThrDlPdcpBasedUeid)));
 
         // ML Slice Interface
-        MLSliceInterface(macPrb, imsi);
+        auto sliceKpis = MLSliceInterface(macPrb, imsi);
+
+        if (m_ueKpiStore || m_ueKpiHistory)
+        {
+            // Same order as GetUeKpiColumns
+            std::vector<double> ueKpis{(double)imsi,
+                                       (double)macPduUe,
+                                       (double)macPduInitialUe,
+                                       (double)macQpsk,
+                                       (double)mac16Qam,
+                                       (double)mac64Qam,
+                                       (double)macRetx,
+                                       (double)macVolume,
+                                       macPrb,
+                                       (double)macMac04,
+                                       (double)macMac59,
+                                       (double)macMac1014,
+                                       (double)macMac1519,
+                                       (double)macMac2024,
+                                       (double)macMac2529,
+                                       (double)macSinrBin1,
+                                       (double)macSinrBin2,
+                                       (double)macSinrBin3,
+                                       (double)macSinrBin4,
+                                       (double)macSinrBin5,
+                                       (double)macSinrBin6,
+                                       (double)macSinrBin7,
+                                       (double)rlcBufferOccup,
+                                       drbThrDlUeid,
+                                       drbThrDlPdcpBasedUeid,
+                                       sliceKpis[0],
+                                       sliceKpis[1],
+                                       sliceKpis[2]};
+            if (m_ueKpiStore)
+            {
+                m_ueKpiStore->Append(m_cellId, timestamp, ueKpis);
+            }
+            if (m_ueKpiHistory)
+            {
+                m_ueKpiHistory->Add(imsi, timestamp, ueKpis);
+            }
+        }
         // reset UE
-        m_e2DuCalculator->ResetPhyTracesForRntiCellId(rnti, m_cellId);
+        m_e2DuCalculator->ResetPhyTracesForRntiCellId(rnti, m_cellId, base);
     }
 
     m_drbThrDlPdcpBasedComputationUeid.clear();
@@ -1005,6 +2256,47 @@ E2Interface::BuildRicIndicationMessageDu(std::string plmId, uint16_t nrCellId)
                                (long)100); // percentage of used PRBs
     long ulPrbUsage = 0;                   // TODO for future implementation
 
+    if (m_cellKpiStore || m_cellKpiHistory)
+    {
+        // Same order as GetCellKpiColumns
+        std::vector<double> cellKpis{(double)dlAvailablePrbs,
+                                     (double)ulAvailablePrbs,
+                                     (double)qci,
+                                     (double)dlPrbUsage,
+                                     (double)ulPrbUsage,
+                                     (double)macPduCellSpecific,
+                                     (double)macPduInitialCellSpecific,
+                                     (double)macQpskCellSpecific,
+                                     (double)mac16QamCellSpecific,
+                                     (double)mac64QamCellSpecific,
+                                     prbUtilizationDl,
+                                     (double)macRetxCellSpecific,
+                                     (double)macVolumeCellSpecific,
+                                     (double)macMac04CellSpecific,
+                                     (double)macMac59CellSpecific,
+                                     (double)macMac1014CellSpecific,
+                                     (double)macMac1519CellSpecific,
+                                     (double)macMac2024CellSpecific,
+                                     (double)macMac2529CellSpecific,
+                                     (double)macSinrBin1CellSpecific,
+                                     (double)macSinrBin2CellSpecific,
+                                     (double)macSinrBin3CellSpecific,
+                                     (double)macSinrBin4CellSpecific,
+                                     (double)macSinrBin5CellSpecific,
+                                     (double)macSinrBin6CellSpecific,
+                                     (double)macSinrBin7CellSpecific,
+                                     (double)rlcBufferOccupCellSpecific,
+                                     (double)ueManager.GetN()};
+        if (m_cellKpiStore)
+        {
+            m_cellKpiStore->Append(m_cellId, timestamp, cellKpis);
+        }
+        if (m_cellKpiHistory)
+        {
+            m_cellKpiHistory->Add(m_cellId, timestamp, cellKpis);
+        }
+    }
+
     if (!indicationMessageHelper->IsOffline())
     {
         indicationMessageHelper->AddDuCellPmItem(macPduCellSpecific,
@@ -1047,6 +2339,32 @@ E2Interface::BuildRicIndicationMessageDu(std::string plmId, uint16_t nrCellId)
         epcDuVal->m_ulPrbUsage = ulPrbUsage;
 
         servedPlmnPerCell->m_perQciReportItems.insert(epcDuVal);
+
+        // Per-slice PRB usage, available only when the slicing scheduler is installed
+        auto rlScheduler = DynamicCast<NrRLMacSchedulerOfdma>(
+            DynamicCast<NrGnbNetDevice>(m_netDev)->GetScheduler(0));
+        if (rlScheduler)
+        {
+            // Read even when not requested, so that the next window starts here
+            auto slicePrbUsage = rlScheduler->GetSlicePrbUsage(baseline.slicePrb);
+            if (!indicationMessageHelper->IsRequested(KPM_MEAS_PRB))
+            {
+                slicePrbUsage.clear();
+            }
+            for (const auto& sliceUsage : slicePrbUsage)
+            {
+                Ptr<FiveGcDuPmContainer> fiveGcDuVal = Create<FiveGcDuPmContainer>();
+                fiveGcDuVal->m_sst = std::string(1, static_cast<char>(sliceUsage.sliceId));
+                fiveGcDuVal->m_fiveQi = sliceUsage.fiveQi;
+                fiveGcDuVal->m_dlPrbUsage = std::lround(sliceUsage.dlPrbUsage);
+                fiveGcDuVal->m_ulPrbUsage = std::lround(sliceUsage.ulPrbUsage);
+                NS_LOG_DEBUG("Slice " << sliceUsage.sliceId << " 5QI " << sliceUsage.fiveQi
+                                      << " dlPrbUsage " << fiveGcDuVal->m_dlPrbUsage
+                                      << " ulPrbUsage " << fiveGcDuVal->m_ulPrbUsage);
+                servedPlmnPerCell->m_perSliceReportItems.insert(fiveGcDuVal);
+            }
+        }
+
         cellResRep->m_servedPlmnPerCellItems.insert(servedPlmnPerCell);
 
         indicationMessageHelper->AddDuCellResRepPmItem(cellResRep);
@@ -1056,7 +2374,8 @@ E2Interface::BuildRicIndicationMessageDu(std::string plmId, uint16_t nrCellId)
     bool generateData = false;
     m_duFileName = "metrics_du.csv";
 
-    if (generateData)
+    // The KPI stores replace the CSV rows
+    if (generateData && !m_cellKpiStore && !m_ueKpiStore)
     {
         std::ofstream csv{};
         csv.open(m_duFileName.c_str(), std::ios_base::app);
@@ -1090,8 +2409,6 @@ E2Interface::BuildRicIndicationMessageDu(std::string plmId, uint16_t nrCellId)
                    "drbThrDlPdcpBasedUeid\n";
         }
 
-        uint64_t timestamp = m_startTime + (uint64_t)Simulator::Now().GetMilliSeconds();
-
         std::string to_print_cell =
             std::to_string(timestamp) + "," + plmId + "," + std::to_string(nrCellId) + "," +
             std::to_string(dlAvailablePrbs) + "," + std::to_string(ulAvailablePrbs) + "," +
@@ -1131,7 +2448,283 @@ E2Interface::BuildRicIndicationMessageDu(std::string plmId, uint16_t nrCellId)
         }
         csv.close();
     }
-    return indicationMessageHelper->CreateIndicationMessage();
+    return indicationMessageHelper;
+}
+
+double
+E2Interface::ComputeMacPrb(uint16_t rnti, const NoriE2Report::Baseline& baseline)
+{
+    // Numerator = (Sum of number of symbols across all rows (TTIs) group by cell ID and UE ID
+    // within a given time window)
+    double macNumberOfSymbols =
+        m_e2DuCalculator->GetMacNumberOfSymbolsUeSpecific(rnti, m_cellId, baseline);
+
+    auto slotPeriod = DynamicCast<NrGnbNetDevice>(m_netDev)->GetPhy(0)->GetSlotPeriod();
+
+    // Denominator = (Periodicity of the report time window in ms*number of TTIs per ms*14)
+    Time reportingWindow =
+        Simulator::Now() - m_e2DuCalculator->GetLastResetTime(rnti, m_cellId, baseline);
+    double denominatorPrb =
+        std::ceil(reportingWindow.GetNanoSeconds() / slotPeriod.GetNanoSeconds()) * 14;
+
+    NS_LOG_DEBUG("macNumberOfSymbols " << macNumberOfSymbols << " denominatorPrb "
+                                       << denominatorPrb);
+
+    // Average Number of PRBs allocated for the UE = (NR/DR)*139 (where 139 is the total number
+    // of PRBs available per NR cell, given numerology 2 with 60 kHz SCS)
+    double macPrb = 0;
+    if (denominatorPrb != 0)
+    {
+        macPrb = macNumberOfSymbols / denominatorPrb *
+                 139; // TODO fix this for different numerologies
+    }
+    return macPrb;
+}
+
+void
+E2Interface::StartPolicyPlugin()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_IF(m_policyPluginPath.empty(), "Set the PolicyPlugin attribute first");
+
+    auto gnbNode = DynamicCast<NrGnbNetDevice>(m_netDev);
+    NS_ASSERT(gnbNode);
+    m_cellId = gnbNode->GetCellId();
+    m_policyPlugin = Create<PolicyPlugin>(m_policyPluginPath, m_cellId, m_policyPluginConfig);
+
+    Simulator::Schedule(Seconds(m_e2Periodicity), &E2Interface::RunPolicyPlugin, this);
+}
+
+void
+E2Interface::RunPolicyPlugin()
+{
+    NS_LOG_FUNCTION(this);
+
+    nori_kpi_snapshot snapshot = CollectKpiSnapshot();
+    auto quotas = m_policyPlugin->Decide(snapshot);
+    if (!quotas.empty())
+    {
+        auto scheduler = DynamicCast<NrGnbNetDevice>(m_netDev)->GetScheduler(0);
+        auto rlScheduler = DynamicCast<NrRLMacSchedulerOfdma>(scheduler);
+        NS_ABORT_MSG_UNLESS(rlScheduler, "Scheduler is not a RL OFDMA scheduler");
+        rlScheduler->SetSlicingParameters(quotas);
+    }
+
+    Simulator::Schedule(Seconds(m_e2Periodicity), &E2Interface::RunPolicyPlugin, this);
+}
+
+void
+E2Interface::StartKpiStream()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_UNLESS(m_e2term && m_e2term->IsShmTransport(),
+                        "Raw KPI streaming needs an E2 termination using shared memory");
+
+    m_cellId = DynamicCast<NrGnbNetDevice>(m_netDev)->GetCellId();
+    Simulator::Schedule(Seconds(m_e2Periodicity), &E2Interface::SendKpiSnapshot, this);
+}
+
+void
+E2Interface::StartRecording()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_UNLESS(m_e2term && m_e2term->IsRecording(),
+                        "Recording needs an E2 termination with a record log");
+
+    m_cellId = DynamicCast<NrGnbNetDevice>(m_netDev)->GetCellId();
+
+    // Stands for the subscription of a RIC to every KPM measurement, on the E2 period
+    E2Termination::RicSubscriptionRequest_rval_s params{};
+    params.ranFuncionId = 200;
+    params.actionId = 1;
+    params.reportPeriodMs = 0;
+    params.measurementMask = KPM_MEAS_ALL;
+    AddSubscription(params);
+}
+
+void
+E2Interface::SetKpiStores(Ptr<KpiStoreWriter> cellStore, Ptr<KpiStoreWriter> ueStore)
+{
+    NS_LOG_FUNCTION(this << cellStore << ueStore);
+    NS_ABORT_MSG_IF(cellStore && cellStore->GetColumns().size() != GetCellKpiColumns().size(),
+                    "The cell KPI store does not have the columns of GetCellKpiColumns");
+    NS_ABORT_MSG_IF(ueStore && ueStore->GetColumns().size() != GetUeKpiColumns().size(),
+                    "The UE KPI store does not have the columns of GetUeKpiColumns");
+    m_cellKpiStore = cellStore;
+    m_ueKpiStore = ueStore;
+}
+
+void
+E2Interface::SetKpiHistories(Ptr<KpiHistory> cellHistory, Ptr<KpiHistory> ueHistory)
+{
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_IF(cellHistory && cellHistory->GetKpis().size() != GetCellKpiColumns().size(),
+                    "The cell KPI history does not have the KPIs of GetCellKpiColumns");
+    NS_ABORT_MSG_IF(ueHistory && ueHistory->GetKpis().size() != GetUeKpiColumns().size(),
+                    "The UE KPI history does not have the KPIs of GetUeKpiColumns");
+    m_cellKpiHistory = cellHistory;
+    m_ueKpiHistory = ueHistory;
+}
+
+Ptr<KpiHistory>
+E2Interface::GetCellKpiHistory() const
+{
+    return m_cellKpiHistory;
+}
+
+Ptr<KpiHistory>
+E2Interface::GetUeKpiHistory() const
+{
+    return m_ueKpiHistory;
+}
+
+std::vector<KpiStoreWriter::Column>
+E2Interface::GetCellKpiColumns()
+{
+    const auto INT = KpiStoreWriter::INT;
+    return {{"dlAvailablePrbs", INT},
+            {"ulAvailablePrbs", INT},
+            {"qci", INT},
+            {"dlPrbUsage", INT},
+            {"ulPrbUsage", INT},
+            {"macPduCellSpecific", INT},
+            {"macPduInitialCellSpecific", INT},
+            {"macQpskCellSpecific", INT},
+            {"mac16QamCellSpecific", INT},
+            {"mac64QamCellSpecific", INT},
+            {"prbUtilizationDl", KpiStoreWriter::DOUBLE},
+            {"macRetxCellSpecific", INT},
+            {"macVolumeCellSpecific", INT},
+            {"macMac04CellSpecific", INT},
+            {"macMac59CellSpecific", INT},
+            {"macMac1014CellSpecific", INT},
+            {"macMac1519CellSpecific", INT},
+            {"macMac2024CellSpecific", INT},
+            {"macMac2529CellSpecific", INT},
+            {"macSinrBin1CellSpecific", INT},
+            {"macSinrBin2CellSpecific", INT},
+            {"macSinrBin3CellSpecific", INT},
+            {"macSinrBin4CellSpecific", INT},
+            {"macSinrBin5CellSpecific", INT},
+            {"macSinrBin6CellSpecific", INT},
+            {"macSinrBin7CellSpecific", INT},
+            {"rlcBufferOccupCellSpecific", INT},
+            {"numActiveUes", INT}};
+}
+
+std::vector<KpiStoreWriter::Column>
+E2Interface::GetUeKpiColumns()
+{
+    const auto INT = KpiStoreWriter::INT;
+    const auto DOUBLE = KpiStoreWriter::DOUBLE;
+    return {{"imsi", INT},
+            {"macPduUe", INT},
+            {"macPduInitialUe", INT},
+            {"macQpsk", INT},
+            {"mac16Qam", INT},
+            {"mac64Qam", INT},
+            {"macRetx", INT},
+            {"macVolume", INT},
+            {"macPrb", DOUBLE},
+            {"macMac04", INT},
+            {"macMac59", INT},
+            {"macMac1014", INT},
+            {"macMac1519", INT},
+            {"macMac2024", INT},
+            {"macMac2529", INT},
+            {"macSinrBin1", INT},
+            {"macSinrBin2", INT},
+            {"macSinrBin3", INT},
+            {"macSinrBin4", INT},
+            {"macSinrBin5", INT},
+            {"macSinrBin6", INT},
+            {"macSinrBin7", INT},
+            {"rlcBufferOccup", INT},
+            {"drbThrDlUeid", DOUBLE},
+            {"drbThrDlPdcpBasedUeid", DOUBLE},
+            {"dlThroughput", DOUBLE},
+            {"ulThroughput", DOUBLE},
+            {"spectralEfficiency", DOUBLE}};
+}
+
+void
+E2Interface::SendKpiSnapshot()
+{
+    NS_LOG_FUNCTION(this);
+
+    m_e2term->SendKpiSnapshot(CollectKpiSnapshot());
+    Simulator::Schedule(Seconds(m_e2Periodicity), &E2Interface::SendKpiSnapshot, this);
+}
+
+nori_kpi_snapshot
+E2Interface::CollectKpiSnapshot()
+{
+    NS_LOG_FUNCTION(this);
+    NORI_PROFILE(m_profiler, NoriProfiler::SNAPSHOT);
+
+    auto rlScheduler = DynamicCast<NrRLMacSchedulerOfdma>(
+        DynamicCast<NrGnbNetDevice>(m_netDev)->GetScheduler(0));
+
+    ObjectMapValue ueManager;
+    m_rrc->GetAttribute("UeMap", ueManager);
+
+    m_ueKpis.clear();
+    m_ueKpis.reserve(ueManager.GetN());
+    for (auto ueObject = ueManager.Begin(); ueObject != ueManager.End(); ueObject++)
+    {
+        auto ue = DynamicCast<NrUeManager>(ueObject->second);
+        nori_ue_kpi kpi{};
+        kpi.imsi = ue->GetImsi();
+        kpi.rnti = ue->GetRnti();
+        kpi.sliceId = rlScheduler ? rlScheduler->GetSliceIndex(kpi.rnti) : 0;
+
+        uint64_t dlData = m_e2PdcpStatsCalculator->GetDlTxData(kpi.imsi, 4);
+        uint64_t ulData = m_e2PdcpStatsCalculator->GetUlTxData(kpi.imsi, 4);
+        // The counters restart from zero when the bearer stats are reset, take the whole
+        // count as the delta instead of wrapping around
+        uint64_t& lastDlData = m_snapshotDlData[kpi.imsi];
+        uint64_t& lastUlData = m_snapshotUlData[kpi.imsi];
+        uint64_t dlDelta = dlData >= lastDlData ? dlData - lastDlData : dlData;
+        uint64_t ulDelta = ulData >= lastUlData ? ulData - lastUlData : ulData;
+        kpi.dlThroughputKbps = dlDelta * 8 / 1e3 / m_e2Periodicity;
+        kpi.ulThroughputKbps = ulDelta * 8 / 1e3 / m_e2Periodicity;
+        lastDlData = dlData;
+        lastUlData = ulData;
+
+        // Own window, so that the KPM reports keep theirs
+        kpi.prbUsedDl = ComputeMacPrb(kpi.rnti, m_snapshotPhyBaseline);
+        kpi.sinrDb = m_l3sinrMap[kpi.rnti][m_cellId];
+        kpi.macPdu =
+            m_e2DuCalculator->GetMacPduUeSpecific(kpi.rnti, m_cellId, m_snapshotPhyBaseline);
+        kpi.macRetx = m_e2DuCalculator->GetMacPduRetransmissionUeSpecific(kpi.rnti,
+                                                                           m_cellId,
+                                                                           m_snapshotPhyBaseline);
+        m_ueKpis.push_back(kpi);
+
+        m_e2DuCalculator->ResetPhyTracesForRntiCellId(kpi.rnti, m_cellId, m_snapshotPhyBaseline);
+    }
+
+    m_sliceKpis.clear();
+    if (rlScheduler)
+    {
+        for (const auto& sliceUsage : rlScheduler->GetSlicePrbUsage(m_snapshotSlicePrbBaseline))
+        {
+            m_sliceKpis.push_back({sliceUsage.sliceId,
+                                   sliceUsage.fiveQi,
+                                   sliceUsage.dlPrbUsage,
+                                   sliceUsage.ulPrbUsage});
+        }
+    }
+
+    nori_kpi_snapshot snapshot{};
+    snapshot.timestampMs = m_startTime + (uint64_t)Simulator::Now().GetMilliSeconds();
+    snapshot.cellId = m_cellId;
+    snapshot.periodS = m_e2Periodicity;
+    snapshot.numUes = m_ueKpis.size();
+    snapshot.ues = m_ueKpis.data();
+    snapshot.numSlices = m_sliceKpis.size();
+    snapshot.slices = m_sliceKpis.data();
+    return snapshot;
 }
 
 std::multimap<long double, uint16_t>
@@ -1176,26 +2769,11 @@ E2Interface ::BuildRicIndicationHeader(std::string plmId,
      */
 }
 
-void
+std::array<double, 3>
 E2Interface::MLSliceInterface(double macPrb, uint64_t imsi)
 {
     NS_LOG_FUNCTION(this);
 
-    std::ofstream csv;
-    std::string fileName = "ml_slice_interface.csv";
-    csv.open(fileName, std::ios_base::app);
-    if (!csv.is_open())
-    {
-        NS_FATAL_ERROR("Can't open file " << fileName);
-    }
-
-    // Check if the file is empty to write the header
-    csv.seekp(0, std::ios::end);
-    if (csv.tellp() == 0)
-    {
-        csv << "timestamp,imsi,dlThroughput,ulThroughput,spectralEfficiency\n";
-    }
-
     double currentTime = Simulator::Now().GetMilliSeconds();
     double deltatime = currentTime - m_previousTime[imsi];
 
@@ -1214,11 +2792,32 @@ E2Interface::MLSliceInterface(double macPrb, uint64_t imsi)
             spectralEfficiency = dlThroughput / (macPrb * 720000.0);
         }
     }
+    if (m_ueKpiStore)
+    {
+        return {dlThroughput, ulThroughput, spectralEfficiency};
+    }
+
+    std::ofstream csv;
+    std::string fileName = "ml_slice_interface.csv";
+    csv.open(fileName, std::ios_base::app);
+    if (!csv.is_open())
+    {
+        NS_FATAL_ERROR("Can't open file " << fileName);
+    }
+
+    // Check if the file is empty to write the header
+    csv.seekp(0, std::ios::end);
+    if (csv.tellp() == 0)
+    {
+        csv << "timestamp,imsi,dlThroughput,ulThroughput,spectralEfficiency\n";
+    }
+
     uint64_t timestamp = m_startTime + (uint64_t)Simulator::Now().GetMilliSeconds();
     csv << timestamp << "," << imsi << "," << dlThroughput << "," << ulThroughput << ","
         << spectralEfficiency << "\n";
 
     csv.close();
+    return {dlThroughput, ulThroughput, spectralEfficiency};
 }
 
 Ptr<NoriE2Report>
@@ -2,11 +2,33 @@
 
 #include "E2-report.h"
 #include "encode_e2apv1.hpp"
+#include "kpi-history.h"
+#include "kpi-store.h"
+#include "latency-histogram.h"
+#include "nori-bearer-stats.h"
+#include "nori-profiler.h"
+#include "nr-rl-mac-scheduler-ofdma.h"
 #include "oran-interface.h"
+#include "policy-plugin.h"
+#include "wall-clock-pacer.h"
 
-#include "ns3/nr-bearer-stats-calculator.h"
+#include "ns3/event-id.h"
+#include "ns3/indication-message-helper.h"
 #include "ns3/nr-gnb-net-device.h"
 #include "ns3/nr-phy-rx-trace.h"
+#include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 namespace ns3
 {
@@ -14,6 +36,12 @@ class NoriE2Report;
 
 typedef std::pair<uint64_t, uint16_t> ImsiCellIdPair_t;
 
+/// (requestorId, instanceId, actionId) identifying a subscription on an E2 node
+typedef std::tuple<uint16_t, uint16_t, uint8_t> SubscriptionKey;
+
+/// (requestorId, instanceId, SN) identifying a RIC indication sent by an E2 node
+typedef std::tuple<uint16_t, uint16_t, uint32_t> IndicationKey;
+
 class E2Interface : public Object
 {
   public:
@@ -71,30 +99,21 @@ class E2Interface : public Object
     void RegisterNewSinrReading(uint16_t imsi, uint16_t cellId, double avgSinr);
 
     /**
-     * @brief Build and send report message
-     * @param params subscription request parameters
-     * @param nodeBNetdev the net device of the nodeB
-     *
+     * @brief Build the report messages once, send them to every subscription on the
+     * given period, and reschedule
+     * @param periodMs the report period, in ms
      */
-    void BuildAndSendReportMessage(E2Termination::RicSubscriptionRequest_rval_s params);
-
-    /**
-     * @brief Report the number of TX PDU calls
-     * @param rnti the current Radio network temporary identifier
-     * @param lcid the current cell identifier
-     * @param packetSize the size of the packet in bytes
-     */
-    void ReportTxPDU(uint16_t rnti, uint8_t lcid, uint32_t packetSize);
+    void BuildAndSendReportMessage(uint32_t periodMs);
 
     /**
      * @brief Set E2 PDCP stats variable report
      */
-    void SetE2PdcpStatsCalculator(Ptr<NrBearerStatsCalculator> e2PdcpStatsCalculator);
+    void SetE2PdcpStatsCalculator(Ptr<NoriBearerStats> e2PdcpStatsCalculator);
 
     /**
      * @brief Set E2 RLC stats variable report
      */
-    void SetE2RlcStatsCalculator(Ptr<NrBearerStatsCalculator> e2RlcStatsCalculator);
+    void SetE2RlcStatsCalculator(Ptr<NoriBearerStats> e2RlcStatsCalculator);
 
     /**
      * @brief Control Message Received Callback: A handler that deals with the control message
@@ -105,10 +124,143 @@ class E2Interface : public Object
 
     Ptr<NoriE2Report> GetE2DuCalculator();
 
-    
-    void MLSliceInterface(double macPrb, uint64_t imsi);
+    /**
+     * @brief Load the policy plugin set through the PolicyPlugin attribute and start
+     * the in-process control loop. Every E2 period the KPI snapshot of the cell is
+     * handed to the plugin, and the returned slice quotas are applied to the scheduler.
+     */
+    void StartPolicyPlugin();
+
+    /**
+     * @brief Stream the raw KPI snapshot of the cell to a local agent every E2 period,
+     * through the shared memory rings of the E2 termination, instead of building
+     * KPM indications.
+     */
+    void StartKpiStream();
+
+    /**
+     * @brief Run the report pipeline without a RIC: subscribe to every KPM
+     * measurement on the E2 period, and let the E2 termination record the encoded
+     * indications to its log.
+     */
+    void StartRecording();
+
+    /**
+     * @brief Write the DU KPIs to columnar stores, every time they are built, instead
+     * of the ml_slice_interface.csv rows
+     * @param cellStore the store of the cell KPIs, see GetCellKpiColumns, or nullptr
+     * @param ueStore the store of the UE KPIs, see GetUeKpiColumns, or nullptr
+     */
+    void SetKpiStores(Ptr<KpiStoreWriter> cellStore, Ptr<KpiStoreWriter> ueStore);
+
+    /**
+     * @brief Keep the last DU KPIs of the cell and of each UE, every time they are
+     * built, in bounded histories that can be queried by time range
+     * @param cellHistory the history of the cells, keyed by cell ID, with the KPIs of
+     * GetCellKpiColumns, or nullptr
+     * @param ueHistory the history of the UEs, keyed by IMSI, with the KPIs of
+     * GetUeKpiColumns, or nullptr
+     */
+    void SetKpiHistories(Ptr<KpiHistory> cellHistory, Ptr<KpiHistory> ueHistory);
+
+    /**
+     * @return the history of the cell KPIs, null if disabled
+     */
+    Ptr<KpiHistory> GetCellKpiHistory() const;
+
+    /**
+     * @return the history of the UE KPIs, null if disabled
+     */
+    Ptr<KpiHistory> GetUeKpiHistory() const;
+
+    /**
+     * @brief Get the columns of the cell KPIs, those of metrics_du.csv
+     * @return the columns
+     */
+    static std::vector<KpiStoreWriter::Column> GetCellKpiColumns();
+
+    /**
+     * @brief Get the columns of the UE KPIs, those of metrics_du.csv and
+     * ml_slice_interface.csv
+     * @return the columns
+     */
+    static std::vector<KpiStoreWriter::Column> GetUeKpiColumns();
+
+    /**
+     * @brief Print the time spent in each stage of NORI for this gNB, if the
+     * Profiling attribute is set
+     * @param os the output stream
+     */
+    void PrintProfile(std::ostream& os) const;
+
+    /**
+     * @brief Print the percentiles of the closed-loop latency stages
+     * @param os the output stream
+     */
+    void PrintClosedLoopLatency(std::ostream& os) const;
+
+    /**
+     * TracedCallback signature for a closed control loop, from the KPI collection to
+     * the slicing parameters taking effect in the scheduler
+     * @param cellId the NR cell ID
+     * @param sequenceNumber the RIC indication SN the control answered
+     * @param encodeSendMs wall-clock time from the collection to the indication being sent
+     * @param ricMs wall-clock time from the indication being sent to the control arriving
+     * @param applyMs wall-clock time from the control arriving to its first use
+     * @param totalMs wall-clock time from the collection to the first use of the control
+     * @param totalSimMs simulation time from the collection to the first use of the control
+     */
+    typedef void (*ClosedLoopLatencyTracedCallback)(uint16_t cellId,
+                                                    uint32_t sequenceNumber,
+                                                    double encodeSendMs,
+                                                    double ricMs,
+                                                    double applyMs,
+                                                    double totalMs,
+                                                    double totalSimMs);
+
+    /**
+     * TracedCallback signature for a change of the effective report period in the
+     * adaptive mode
+     * @param cellId the NR cell ID
+     * @param periodMs the period requested by the subscriptions, in ms
+     * @param effectivePeriodMs the period actually used, in ms
+     */
+    typedef void (*PeriodicityAdaptedTracedCallback)(uint16_t cellId,
+                                                     uint32_t periodMs,
+                                                     uint32_t effectivePeriodMs);
+
+    /**
+     * TracedCallback signature for the lag of the simulation behind the wall clock
+     * @param cellId the NR cell ID
+     * @param lagMs the lag, in ms, negative if the simulation runs ahead
+     */
+    typedef void (*WallClockLagTracedCallback)(uint16_t cellId, double lagMs);
+
+    /**
+     * @brief Compute the slicing KPIs of a UE since the last call, and append them to
+     * ml_slice_interface.csv unless a UE KPI store is set
+     * @param macPrb the average PRBs allocated to the UE
+     * @param imsi the IMSI of the UE
+     * @return the DL throughput, UL throughput and spectral efficiency
+     */
+    std::array<double, 3> MLSliceInterface(double macPrb, uint64_t imsi);
+
+  protected:
+    void NotifyConstructionCompleted() override;
+    void DoDispose() override;
 
   private:
+    /**
+     * UE values last sent by a report group in delta mode
+     */
+    struct DeltaState
+    {
+        bool keyframe{true};                                //<! Whether to send every UE
+        uint32_t reportsSinceKeyframe{0};                   //<! Reports since the last keyframe
+        std::map<uint64_t, std::vector<double>> cuUpValues; //<! CU-UP UE values, by IMSI
+        std::map<uint64_t, std::vector<double>> duValues;   //<! DU UE values, by IMSI
+    };
+
     /**
      * @brief Build RIC Indication Header
      * @param plmId PLMN ID
@@ -121,6 +273,48 @@ class E2Interface : public Object
                                                       std::string gnbId,
                                                       uint16_t CellId) const;
 
+    /**
+     * @brief Answer a RIC Subscription Request and add a subscription for each of
+     * the actions it sets up
+     * @param request the decoded request
+     */
+    void HandleSubscriptionRequest(E2Termination::RicSubscriptionRequest_s request);
+
+    /**
+     * @brief Add a subscription to the table, or update it, and start the timer of
+     * its period if needed
+     * @param params subscription request parameters
+     */
+    void AddSubscription(E2Termination::RicSubscriptionRequest_rval_s params);
+
+    /**
+     * @brief Encode a message and send it to a set of subscriptions, split in segments
+     * of at most MaxIndicationSize bytes sharing the same header. Only the first segment
+     * carries the cell PM container and measurements, every segment carries its index
+     * and the number of segments.
+     * @param subscriptions the subscriptions to send the message to
+     * @param header the indication header
+     * @param msgHelper the helper holding the values of the message
+     */
+    void SendSegments(const std::set<SubscriptionKey>& subscriptions,
+                      Ptr<KpmIndicationHeader> header,
+                      Ptr<IndicationMessageHelper> msgHelper);
+
+    /**
+     * @brief Encode the whole message, or a segment of it
+     * @param msgHelper the helper holding the values of the message
+     * @param firstUe index of the first UE item
+     * @param numUes number of UE items
+     * @param segment index of the segment, from 1, 0 for the whole message
+     * @param numSegments number of segments of the message
+     * @return the encoded message
+     */
+    Ptr<KpmIndicationMessage> Encode(Ptr<IndicationMessageHelper> msgHelper,
+                                     size_t firstUe,
+                                     size_t numUes,
+                                     uint32_t segment = 0,
+                                     uint32_t numSegments = 1);
+
     /**
      * @brief Get the IMSI string
      * @param imsi the IMSI
@@ -130,26 +324,59 @@ class E2Interface : public Object
     /**
      * @brief Build RIC Indication Message for CU-UP
      * @param plmId PLMN ID
-     * @return the RIC Indication Message
+     * @param measurementMask the KpmMeasurementGroup to report
+     * @param delta the delta mode state of the report group, nullptr to report every UE
+     * @param baseline the counters at the last report of the group, moved forward
+     * @return the helper holding the values of the message, to be encoded by
+     * SendSegments, or nullptr if no CU-UP measurement is requested
      */
 
-    Ptr<KpmIndicationMessage> BuildRicIndicationMessageCuUp(std::string plmId);
+    Ptr<IndicationMessageHelper> BuildRicIndicationMessageCuUp(std::string plmId,
+                                                               uint64_t measurementMask,
+                                                               DeltaState* delta,
+                                                               CounterBaseline& baseline);
 
     /**
      * @brief Build RIC Indication Message for CU-CP
      * @param plmId PLMN ID
-     * @return the RIC Indication Message
+     * @param measurementMask the KpmMeasurementGroup to report
+     * @return the helper holding the values of the message, to be encoded by
+     * SendSegments, or nullptr if no CU-CP measurement is requested
      *
      */
-    Ptr<KpmIndicationMessage> BuildRicIndicationMessageCuCp(std::string plmId);
+    Ptr<IndicationMessageHelper> BuildRicIndicationMessageCuCp(std::string plmId,
+                                                               uint64_t measurementMask);
 
     /**
      * @brief Build RIC Indication Message for DU
      * @param plmId PLMN ID
      * @param nrCellId NR cell ID
-     * @return the RIC Indication Message
+     * @param measurementMask the KpmMeasurementGroup to report
+     * @param delta the delta mode state of the report group, nullptr to report every UE
+     * @param baseline the counters at the last report of the group, moved forward
+     * @return the helper holding the values of the message, to be encoded by
+     * SendSegments, or nullptr if no DU measurement is requested
      */
-    Ptr<KpmIndicationMessage> BuildRicIndicationMessageDu(std::string plmId, uint16_t nrCellId);
+    Ptr<IndicationMessageHelper> BuildRicIndicationMessageDu(std::string plmId,
+                                                             uint16_t nrCellId,
+                                                             uint64_t measurementMask,
+                                                             DeltaState* delta,
+                                                             CounterBaseline& baseline);
+
+    /**
+     * @brief Whether the values of a UE must be sent in delta mode, i.e. on a keyframe
+     * or when they differ from the last ones sent by more than DeltaTolerance. The
+     * reference is updated when they are.
+     * @param reference the values last sent, by IMSI
+     * @param imsi the UE IMSI
+     * @param values the current values of the UE
+     * @param keyframe whether the report is a keyframe
+     * @return true if the UE item must be added to the report
+     */
+    bool HasUeChanged(std::map<uint64_t, std::vector<double>>& reference,
+                      uint64_t imsi,
+                      std::vector<double> values,
+                      bool keyframe) const;
 
     /**
      * @brief Function to help us to flip the map
@@ -158,23 +385,296 @@ class E2Interface : public Object
      */
     std::multimap<long double, uint16_t> FlipMap(const std::map<uint16_t, long double>& src);
 
+    /**
+     * @brief Average number of DL PRBs used by a UE since its last reset
+     * @param rnti the UE RNTI
+     * @param baseline the DU counters at the last reset
+     * @return the average number of PRBs
+     */
+    double ComputeMacPrb(uint16_t rnti, const NoriE2Report::Baseline& baseline);
+
+    /**
+     * @brief Collect the KPIs of the last period in m_ueKpis and m_sliceKpis, and
+     * reset the window counters
+     * @return the snapshot, pointing to m_ueKpis and m_sliceKpis
+     */
+    nori_kpi_snapshot CollectKpiSnapshot();
+
+    /**
+     * @brief Run one iteration of the in-process control loop and reschedule it
+     */
+    void RunPolicyPlugin();
+
+    /**
+     * @brief Send one raw KPI snapshot and reschedule
+     */
+    void SendKpiSnapshot();
+
+    /**
+     * @brief Count a report as outstanding and, in lockstep mode, block the simulation
+     * until fewer than LockstepLookahead reports are waiting for an answer from the RIC,
+     * or until the timeout expires
+     */
+    void WaitForRic();
+
+    /**
+     * @brief Apply the slice quotas received from the RIC to the scheduler. Called by
+     * the simulator thread only, the controls may arrive on the e2sim one
+     */
+    void ApplyPendingQuotas();
+
+    /**
+     * @brief Remember that a UE is leaving this cell with a handover
+     * @param imsi the IMSI of the UE
+     * @param cellId the cell identifier
+     * @param rnti the RNTI of the UE
+     * @param targetCellId the cell the UE is handed over to
+     */
+    void NotifyHandoverStart(uint64_t imsi, uint16_t cellId, uint16_t rnti, uint16_t targetCellId);
+
+    /**
+     * @brief Drop the KPI history of a UE released by this cell, unless it was handed
+     * over to another cell
+     * @param imsi the IMSI of the UE
+     * @param cellId the cell identifier
+     * @param rnti the RNTI of the UE
+     */
+    void NotifyConnectionRelease(uint64_t imsi, uint16_t cellId, uint16_t rnti);
+
+    /**
+     * @brief Connect the TxPDU trace of the RLC of a new DRB of this cell
+     * @param imsi the IMSI of the UE
+     * @param cellId the cell identifier
+     * @param rnti the RNTI of the UE
+     * @param lcid the logical channel of the DRB
+     */
+    void ConnectDrbTxPdu(uint64_t imsi, uint16_t cellId, uint16_t rnti, uint8_t lcid);
+
+    /**
+     * @brief Report the number of TX PDU calls
+     * @param ueIndex the index of the UE in m_ueCounters
+     * @param rnti the current Radio network temporary identifier
+     * @param lcid the current cell identifier
+     * @param packetSize the size of the packet in bytes
+     */
+    void ReportTxPDU(uint32_t ueIndex, uint16_t rnti, uint8_t lcid, uint32_t packetSize);
+
+    /**
+     * @brief Get the counters of a UE, allocating them on first use
+     * @param rnti the RNTI of the UE
+     * @return the index of the UE in m_ueCounters
+     */
+    uint32_t GetUeCounterIndex(uint16_t rnti);
+
+    /**
+     * Counters of a UE updated by the traces, since the UE attached
+     */
+    struct UeCounters
+    {
+        uint32_t txPdus{0};     //<! TX PDUs of all the DRBs
+        uint64_t txPduBytes{0}; //<! TX PDU bytes of all the DRBs
+    };
+
+    /**
+     * State of a UE at the last event-triggered report
+     */
+    struct UeTriggerState
+    {
+        int sinrBin{-1};         //<! SINR bin of the serving cell, -1 if unknown
+        uint64_t dlBytes{0};     //<! PDCP DL bytes transmitted so far
+        double dlThroughput{0};  //<! PDCP DL throughput over the last window, bit/s
+        uint64_t bufferBytes{0}; //<! Bytes queued between PDCP and RLC
+    };
+
+    /**
+     * A subscription of the table
+     */
+    struct Subscription
+    {
+        E2Termination::RicSubscriptionRequest_rval_s params; //<! Request parameters
+        uint32_t periodMs;                                   //<! Report period, in ms
+        uint32_t nextSequenceNumber{1};                      //<! RIC indication SN to use next
+        uint64_t sent{0};                                    //<! Indications sent
+        uint64_t failed{0};                                  //<! Indications that failed
+        uint64_t bytesSent{0};                               //<! KPM bytes sent
+    };
+
+    /**
+     * Counters of the cell at the last report of a group. The counters only grow, so
+     * that each group reports over its own period whatever the others read.
+     */
+    struct CounterBaseline
+    {
+        NoriE2Report::Baseline du;                        //<! DU counters
+        NrRLMacSchedulerOfdma::SlicePrbBaseline slicePrb; //<! Slice PRB counters
+        std::map<uint64_t, uint64_t> dlTxPackets;         //<! PDCP DL packets sent, by IMSI
+        std::map<uint64_t, double> dlTxKbit;              //<! PDCP DL kbit sent, by IMSI
+        std::map<uint64_t, double> dlRxKbit;              //<! PDCP DL kbit received, by IMSI
+        std::vector<UeCounters> ue;                       //<! UE counters, as m_ueCounters
+        Time lastDuBuild{Seconds(-1)};                    //<! Last read of the DU counters
+        Time lastCuUpBuild{Seconds(-1)};                  //<! Last read of the CU-UP counters
+    };
+
+    /**
+     * Subscriptions sharing a report period, and hence a timer and the encoding
+     */
+    struct ReportGroup
+    {
+        std::set<SubscriptionKey> subscriptions;    //<! Subscriptions on the period
+        EventId timer;                              //<! Next report
+        bool hasReported{false};                    //<! Whether a report was ever sent
+        Time lastReport;                            //<! Time of the last report
+        bool prbAboveThreshold{false};              //<! Cell PRB usage side at the last report
+        std::map<uint64_t, UeTriggerState> ueState; //<! UE state at the last report, by IMSI
+        DeltaState delta;                           //<! Delta mode state
+        double periodScale{1};                      //<! Stretch of the period under backpressure
+        CounterBaseline baseline;                   //<! Counters at the last report
+    };
+
+    /**
+     * @brief Stretch the period of a report group when the outbound queue or the
+     * encode and send path cannot keep up, and bring it back when they recover
+     * @param periodMs the period requested by the subscriptions of the group
+     * @param group the report group
+     * @param failed whether an indication of the report could not be sent
+     * @param sendTime wall-clock time spent building, encoding and sending the report
+     */
+    void AdaptPeriodicity(uint32_t periodMs,
+                          ReportGroup& group,
+                          bool failed,
+                          std::chrono::steady_clock::duration sendTime);
+
+    /**
+     * @brief Change the effective period of a report group and reschedule its next
+     * report
+     * @param periodMs the period requested by the subscriptions of the group
+     * @param group the report group
+     * @param scale the ratio between the effective period and periodMs
+     */
+    void SetPeriodScale(uint32_t periodMs, ReportGroup& group, double scale);
+
+    /**
+     * Steps taken, in order, to keep the lag behind the wall clock within budget
+     */
+    enum LoadShedding
+    {
+        SHED_NONE = 0,   //!< All the containers are reported
+        SHED_CU_CP = 1,  //!< The CU-CP container is skipped
+        SHED_CU_UP = 2,  //!< The CU-UP container is skipped too
+        SHED_PERIOD = 3, //!< The report period is stretched too
+    };
+
+    /**
+     * @brief Move the load shedding one step up when the lag exceeds the budget, and
+     * one step down once the lag is below half of it
+     * @param periodMs the period requested by the subscriptions of the group
+     * @param group the report group
+     * @param lag the lag of the simulation behind the wall clock
+     */
+    void ShedLoad(uint32_t periodMs, ReportGroup& group, Time lag);
+
+    /**
+     * @brief Get the window covered by counters read for a report, and start the next
+     * one
+     * @param lastBuild time the counters were last read, negative if never, updated
+     * @param defaultWindow the window of the first report
+     * @return the window
+     */
+    Time StartReportWindow(Time& lastBuild, Time defaultWindow);
+
+    /**
+     * @brief Evaluate the trigger conditions of the event-triggered mode on the
+     * current state of the cell, and remember that state if a report is due
+     * @param group the report group being evaluated
+     * @return whether a report must be sent
+     */
+    bool CheckEventTriggers(ReportGroup& group);
+
+    /**
+     * @brief Map a SINR to the bins of the DU report
+     * @param sinrDb the SINR, in dB
+     * @return the bin index, from 0 to 6
+     */
+    static int GetSinrBin(double sinrDb);
+
+    /**
+     * @brief Encode a RIC indication for a subscription, with the next sequence number
+     * of the subscription, and send it
+     * @param subscription the subscription
+     * @param header the indication header
+     * @param msg the indication message
+     */
+    void SendIndication(Subscription& subscription,
+                        Ptr<KpmIndicationHeader> header,
+                        Ptr<KpmIndicationMessage> msg);
+
+    /**
+     * @brief Append the indication counters to the stats file and reschedule
+     */
+    void DumpStats();
+
+    /**
+     * @brief Called by the scheduler on the first DL allocation made with the slicing
+     * parameters of the last control, to close the latency measurement of the loop
+     */
+    void SlicingApplied();
+
+    /**
+     * Stages of the closed control loop
+     */
+    enum LoopStage
+    {
+        ENCODE_SEND = 0, //!< KPI collection to indication sent, wall clock
+        RIC = 1,         //!< Indication sent to control received, wall clock
+        APPLY = 2,       //!< Control received to first use in the scheduler, wall clock
+        TOTAL = 3,       //!< KPI collection to first use in the scheduler, wall clock
+        TOTAL_SIM = 4,   //!< KPI collection to first use in the scheduler, simulation time
+        NUM_LOOP_STAGES = 5,
+    };
+
+    /**
+     * Timestamps of a control loop, started by an indication
+     */
+    struct LoopTimestamps
+    {
+        uint32_t sequenceNumber{0};                     //<! RIC indication SN
+        uint64_t report{0};                             //<! Report the indication belongs to
+        Time collectSim;                                //<! KPI collection, simulation time
+        std::chrono::steady_clock::time_point collect;  //<! KPI collection
+        std::chrono::steady_clock::time_point sent;     //<! Indication sent
+        std::chrono::steady_clock::time_point received; //<! Control received
+    };
+
+    /**
+     * @brief Find the open loop answered by a RIC control, m_loopMutex held.
+     *
+     * The RIC request ID of the control names the subscription. The RIC is expected to
+     * echo the SN of the indication it answers as RIC call process ID, otherwise the
+     * last indication of the subscription still open is assumed.
+     *
+     * @param control the RIC control
+     * @return the loop, m_openLoops.end() if none matches
+     */
+    std::map<IndicationKey, LoopTimestamps>::iterator FindOpenLoop(
+        const RicControlMessage& control);
+
+    std::map<SubscriptionKey, Subscription> m_subscriptions; //<! Subscriptions of this node
+    std::map<uint32_t, ReportGroup> m_reportGroups;          //<! Subscriptions by period, ms
+
     double m_e2Periodicity;                                          //<! E2 periodicity
     Ptr<NrGnbRrc> m_rrc;                                             //<! RRC object
     std::map<uint64_t, std::map<uint16_t, long double>> m_l3sinrMap; //<! L3 SINR map
 
+    std::vector<UeCounters> m_ueCounters;                    //<! Trace counters of the UEs
+    std::unordered_map<uint16_t, uint32_t> m_ueCounterIndex; //<! m_ueCounters index by RNTI
+
     Ptr<E2Termination> m_e2term;                          //<! E2 termination object
     Ptr<NetDevice> m_netDev;                              //<! Net device of the nodeB
-    std::map<uint32_t, uint32_t> m_txPDU;                 //<! Number of TX PDU calls
-    std::map<uint32_t, uint64_t> m_txPDUBytes;            //<! Number of TX PDU in bytes
-    Ptr<NrBearerStatsCalculator> m_e2PdcpStatsCalculator; //<! E2 PDCP stats calculator
-    Ptr<NrBearerStatsCalculator> m_e2RlcStatsCalculator;  //<! E2 RLC stats calculator
+    Ptr<NoriBearerStats> m_e2PdcpStatsCalculator;         //<! E2 PDCP stats calculator
+    Ptr<NoriBearerStats> m_e2RlcStatsCalculator;          //<! E2 RLC stats calculator
     Ptr<NoriE2Report> m_e2DuCalculator;                   //<! E2 DU calculator
+    Ptr<RicControlDecoder> m_controlDecoder;              //<! Decode context of the controls
     uint16_t m_cellId{0};                                 //<! Cell ID
-    double m_cellTxDlPackets = 0;                         //<! Number of DL packets
-    //double m_cellTxBytes = 0;                             //<! Number of DL bytes
-    std::map <uint64_t, double> m_cellTxBytes;                             //<! Number of DL bytes
-    
-    double m_cellRxBytes = 0;                             //<! Number of UL bytes
     uint64_t m_startTime = 0;                             //<! Start time
     std::map<uint64_t, uint32_t>
         m_drbThrDlPdcpBasedComputationUeid;      //<! DRB throughput DL PDCP in UE IMSI
@@ -184,5 +684,89 @@ class E2Interface : public Object
     std::map<uint64_t, double> m_previousDlTxData;
     std::map<uint64_t, double> m_previousUlTxData;
     std::map<uint64_t, double> m_previousTime;
+    Ptr<KpiStoreWriter> m_cellKpiStore; //<! Store of the cell KPIs, null if disabled
+    Ptr<KpiStoreWriter> m_ueKpiStore;   //<! Store of the UE KPIs, null if disabled
+    Ptr<KpiHistory> m_cellKpiHistory;   //<! History of the cell KPIs, null if disabled
+    Ptr<KpiHistory> m_ueKpiHistory;     //<! History of the UE KPIs, null if disabled
+    std::set<uint64_t> m_handoverImsis; //<! UEs handed over by this cell, not released yet
+
+    std::string m_policyPluginPath;                //<! Path of the policy plugin library
+    std::string m_policyPluginConfig;              //<! Configuration passed to the plugin
+    Ptr<PolicyPlugin> m_policyPlugin;              //<! Loaded policy plugin
+    std::vector<nori_ue_kpi> m_ueKpis;             //<! Per-UE KPIs of the last snapshot
+    std::vector<nori_slice_kpi> m_sliceKpis;       //<! Per-slice KPIs of the last snapshot
+    std::map<uint64_t, uint64_t> m_snapshotDlData; //<! PDCP DL bytes at the last snapshot
+    std::map<uint64_t, uint64_t> m_snapshotUlData; //<! PDCP UL bytes at the last snapshot
+
+    //! Slice PRB counters at the last KPI snapshot
+    NrRLMacSchedulerOfdma::SlicePrbBaseline m_snapshotSlicePrbBaseline;
+    NoriE2Report::Baseline m_snapshotPhyBaseline; //<! DU counters at the last KPI snapshot
+
+    bool m_lockstep;                           //<! Whether to wait for the RIC after each report
+    uint32_t m_lockstepLookahead;              //<! Reports allowed to be outstanding
+    Time m_lockstepTimeout;                    //<! Wall-clock time to wait for an answer
+    std::deque<uint64_t> m_outstandingReports; //<! Reports not answered by the RIC, oldest first
+    uint32_t m_lockstepTimeouts{0};            //<! Reports whose answer never came
+    std::mutex m_lockstepMutex;                //<! Protects the outstanding reports and quotas
+    std::condition_variable m_lockstepCv;      //<! Signalled when the RIC answers
+
+    //! Slice quotas received from the RIC, not applied to the scheduler yet
+    std::vector<RicControlMessage::SlicePRBQuota> m_pendingQuotas;
+
+    bool m_eventTriggered;          //<! Whether to report only when a trigger fires
+    Time m_eventMinInterval;        //<! Minimum time between two event-triggered reports
+    Time m_eventMaxInterval;        //<! Maximum time between two event-triggered reports
+    double m_eventPrbThreshold;     //<! Cell PRB usage threshold, percentage
+    uint32_t m_eventBufferGrowth;   //<! UE buffer growth triggering a report, bytes
+    double m_eventThroughputChange; //<! UE throughput change triggering a report, percentage
+
+    bool m_deltaReports;              //<! Whether to omit the UEs that did not change
+    double m_deltaTolerance;          //<! Relative change below which a UE value is unchanged
+    uint32_t m_deltaKeyframeInterval; //<! Reports between two full reports
+
+    bool m_adaptivePeriodicity;     //<! Whether to stretch the period under backpressure
+    double m_maxPeriodicityScale;   //<! Maximum stretch of the period
+    double m_backlogHighWatermark;  //<! Outbound queue occupancy considered overloaded
+    double m_backlogLowWatermark;   //<! Outbound queue occupancy considered cleared
+    Time m_reportTimeBudget;        //<! Wall-clock time a report may take to be sent
+    Time m_reportWindow;            //<! Window of the CU-UP KPIs being built
+    TracedCallback<uint16_t, uint32_t, uint32_t> m_periodicityAdaptedTrace; //<! Period change
+
+    bool m_wallClockTracking;                             //<! Whether to measure the lag
+    bool m_paceWallClock;                                 //<! Whether to hold the simulation back
+    Time m_lagBudget;                                     //<! Lag triggering load shedding
+    Ptr<WallClockPacer> m_pacer;                          //<! Lag measurement, null if disabled
+    LoadShedding m_shedLevel{SHED_NONE};                  //<! Current load shedding step
+    TracedCallback<uint16_t, double> m_wallClockLagTrace; //<! Lag at every report
+
+    uint32_t m_maxIndicationSize; //<! Maximum size of an encoded message, 0 for no limit
+    size_t m_uesPerSegment{32};   //<! UE items expected to fit in a segment
+
+    TracedValue<uint64_t> m_indicationsBuilt{0};   //<! KPM messages built
+    TracedValue<uint64_t> m_indicationsEncoded{0}; //<! KPM messages and segments encoded
+    TracedValue<uint64_t> m_indicationsSent{0};    //<! RIC indications sent
+    TracedValue<uint64_t> m_indicationsFailed{0};  //<! RIC indications that failed
+    TracedValue<uint64_t> m_bytesSent{0};          //<! KPM header and message bytes sent
+    Time m_statsDumpInterval;                      //<! Period of the stats dump, 0 to disable
+    std::string m_statsFilePrefix;                 //<! Prefix of the stats file name
+    EventId m_statsDumpEvent;                      //<! Next stats dump
+    std::ofstream m_statsFile;                     //<! Stats file
+
+    uint64_t m_report{0};                                        //<! Number of the current report
+    Time m_collectSim;                                           //<! Start of the current report
+    std::chrono::steady_clock::time_point m_collectWall;         //<! Start of the current report
+    std::map<IndicationKey, LoopTimestamps> m_openLoops;         //<! Indications not answered
+    LoopTimestamps m_pendingApply;                               //<! Control not applied yet
+    bool m_applyPending{false};                                  //<! Whether m_pendingApply is set
+    std::array<LatencyHistogram, NUM_LOOP_STAGES> m_loopLatency; //<! Latency per stage, ms
+    mutable std::mutex m_loopMutex;                              //<! Protects the loop state
+    bool m_slicingTraceConnected{false};                         //<! SlicingApplied connected
+    std::string m_latencyFilePrefix;                             //<! Prefix of the latency file
+    TracedCallback<uint16_t, uint32_t, double, double, double, double, double>
+        m_closedLoopLatencyTrace; //<! Closed control loop latency
+
+    bool m_profiling;                //<! Whether to time the stages of NORI
+    std::string m_profileFilePrefix; //<! Prefix of the profile file
+    Ptr<NoriProfiler> m_profiler;    //<! Profiler of the gNB, null if disabled
 };
 } // namespace ns3
@@ -24,10 +24,17 @@ NoriE2Report::GetTypeId()
     return tid;
 }
 
+void
+NoriE2Report::SetProfiler(Ptr<NoriProfiler> profiler)
+{
+    m_profiler = profiler;
+}
+
 void
 NoriE2Report::UpdateTraces(/*Ptr<NoriE2Report> phyStats, */ std::string path,
                            RxPacketTraceParams params)
 {
+    NORI_PROFILE(m_profiler, NoriProfiler::TRACE_PHY);
     RntiCellIdPair_t pair{params.m_rnti, params.m_cellId};
 
     NS_LOG_LOGIC("Update trace rnti " << params.m_rnti << " cellId " << params.m_cellId);
@@ -159,237 +166,257 @@ NoriE2Report::IncreaseMapValue(std::map<RntiCellIdPair_t, uint32_t> map,
     return map;
 }
 
-uint32_t
-NoriE2Report::GetMapValue(std::map<RntiCellIdPair_t, uint32_t> map, RntiCellIdPair_t key)
+const std::map<RntiCellIdPair_t, uint32_t>&
+NoriE2Report::GetCounterMap(Counter counter) const
 {
-    uint32_t ret = 0;
-    auto pair = map.find(key);
-    if (pair != map.end())
+    switch (counter)
     {
-        ret = pair->second;
+    case MAC_PDU:
+        return m_macPduUeSpecific;
+    case MAC_PDU_INITIAL:
+        return m_macPduInitialTransmissionUeSpecific;
+    case MAC_PDU_RETX:
+        return m_macPduRetransmissionUeSpecific;
+    case MAC_VOLUME:
+        return m_macVolumeUeSpecific;
+    case MAC_PDU_QPSK:
+        return m_macPduQpskUeSpecific;
+    case MAC_PDU_16QAM:
+        return m_macPdu16QamUeSpecific;
+    case MAC_PDU_64QAM:
+        return m_macPdu64QamUeSpecific;
+    case MAC_MCS_0_4:
+        return m_macMcs04UeSpecific;
+    case MAC_MCS_5_9:
+        return m_macMcs59UeSpecific;
+    case MAC_MCS_10_14:
+        return m_macMcs1014UeSpecific;
+    case MAC_MCS_15_19:
+        return m_macMcs1519UeSpecific;
+    case MAC_MCS_20_24:
+        return m_macMcs2024UeSpecific;
+    case MAC_MCS_25_29:
+        return m_macMcs2529UeSpecific;
+    case MAC_SINR_BIN_1:
+        return m_macSinrBin1UeSpecific;
+    case MAC_SINR_BIN_2:
+        return m_macSinrBin2UeSpecific;
+    case MAC_SINR_BIN_3:
+        return m_macSinrBin3UeSpecific;
+    case MAC_SINR_BIN_4:
+        return m_macSinrBin4UeSpecific;
+    case MAC_SINR_BIN_5:
+        return m_macSinrBin5UeSpecific;
+    case MAC_SINR_BIN_6:
+        return m_macSinrBin6UeSpecific;
+    case MAC_SINR_BIN_7:
+        return m_macSinrBin7UeSpecific;
+    default:
+        return m_macNumberOfSymbols;
     }
-    return ret;
 }
 
-std::map<RntiCellIdPair_t, uint32_t>
-NoriE2Report::ResetMapValue(std::map<RntiCellIdPair_t, uint32_t> map, RntiCellIdPair_t key)
+uint32_t
+NoriE2Report::GetCounter(Counter counter,
+                         uint16_t rnti,
+                         uint16_t cellId,
+                         const Baseline& baseline) const
 {
-    auto pair = map.find(key);
-    if (pair != map.end())
+    RntiCellIdPair_t pair{rnti, cellId};
+    const auto& map = GetCounterMap(counter);
+    auto value = map.find(pair);
+    if (value == map.end())
     {
-        map.erase(pair);
+        return 0;
     }
-    m_lastReset[key] = Simulator::Now();
-    return map;
+    auto start = baseline.values.find(pair);
+    // Modulo 2^32, a counter that wrapped since the start of the window still counts
+    return value->second - (start == baseline.values.end() ? 0 : start->second[counter]);
 }
 
 void
-NoriE2Report::ResetPhyTracesForRntiCellId(uint16_t rnti, uint16_t cellId)
+NoriE2Report::ResetPhyTracesForRntiCellId(uint16_t rnti,
+                                          uint16_t cellId,
+                                          Baseline& baseline) const
 {
     NS_LOG_LOGIC("Reset rnti " << rnti << " cellId " << cellId);
     RntiCellIdPair_t pair{rnti, cellId};
 
-    m_macPduUeSpecific = ResetMapValue(m_macPduUeSpecific, pair);
-
-    m_macPduInitialTransmissionUeSpecific =
-        ResetMapValue(m_macPduInitialTransmissionUeSpecific, pair);
-
-    m_macPduRetransmissionUeSpecific = ResetMapValue(m_macPduRetransmissionUeSpecific, pair);
-
-    m_macVolumeUeSpecific = ResetMapValue(m_macVolumeUeSpecific, pair);
-
-    m_macPduQpskUeSpecific = ResetMapValue(m_macPduQpskUeSpecific, pair);
-
-    m_macPdu16QamUeSpecific = ResetMapValue(m_macPdu16QamUeSpecific, pair);
-
-    m_macPdu64QamUeSpecific = ResetMapValue(m_macPdu64QamUeSpecific, pair);
-
-    m_macMcs04UeSpecific = ResetMapValue(m_macMcs04UeSpecific, pair);
-
-    m_macMcs59UeSpecific = ResetMapValue(m_macMcs59UeSpecific, pair);
-
-    m_macMcs1014UeSpecific = ResetMapValue(m_macMcs1014UeSpecific, pair);
-
-    m_macMcs1519UeSpecific = ResetMapValue(m_macMcs1519UeSpecific, pair);
-
-    m_macMcs2024UeSpecific = ResetMapValue(m_macMcs2024UeSpecific, pair);
-
-    m_macMcs2529UeSpecific = ResetMapValue(m_macMcs2529UeSpecific, pair);
-
-    m_macSinrBin1UeSpecific = ResetMapValue(m_macSinrBin1UeSpecific, pair);
-
-    m_macSinrBin2UeSpecific = ResetMapValue(m_macSinrBin2UeSpecific, pair);
-
-    m_macSinrBin3UeSpecific = ResetMapValue(m_macSinrBin3UeSpecific, pair);
-
-    m_macSinrBin4UeSpecific = ResetMapValue(m_macSinrBin4UeSpecific, pair);
-
-    m_macSinrBin5UeSpecific = ResetMapValue(m_macSinrBin5UeSpecific, pair);
-
-    m_macSinrBin6UeSpecific = ResetMapValue(m_macSinrBin6UeSpecific, pair);
-
-    m_macSinrBin7UeSpecific = ResetMapValue(m_macSinrBin7UeSpecific, pair);
-
-    m_macNumberOfSymbols = ResetMapValue(m_macNumberOfSymbols, pair);
+    auto& values = baseline.values[pair];
+    for (uint8_t counter = 0; counter < NUM_COUNTERS; counter++)
+    {
+        const auto& map = GetCounterMap(static_cast<Counter>(counter));
+        auto value = map.find(pair);
+        values[counter] = value == map.end() ? 0 : value->second;
+    }
+    baseline.resetTime[pair] = Simulator::Now();
 }
 
 Time
-NoriE2Report::GetLastResetTime(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetLastResetTime(uint16_t rnti, uint16_t cellId, const Baseline& baseline) const
 {
-    Time ret = Seconds(0);
-    RntiCellIdPair_t key{rnti, cellId};
-    if (m_lastReset.find(key) != m_lastReset.end())
-    {
-        ret = m_lastReset.at(key);
-    }
-    return ret;
+    auto time = baseline.resetTime.find({rnti, cellId});
+    return time == baseline.resetTime.end() ? Seconds(0) : time->second;
 }
 
 uint32_t
-NoriE2Report::GetMacPduUeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacPduUeSpecific(uint16_t rnti, uint16_t cellId, const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macPduUeSpecific, pair);
+    return GetCounter(MAC_PDU, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacPduInitialTransmissionUeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacPduInitialTransmissionUeSpecific(uint16_t rnti,
+                                                     uint16_t cellId,
+                                                     const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macPduInitialTransmissionUeSpecific, pair);
+    return GetCounter(MAC_PDU_INITIAL, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacPduRetransmissionUeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacPduRetransmissionUeSpecific(uint16_t rnti,
+                                                uint16_t cellId,
+                                                const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macPduRetransmissionUeSpecific, pair);
+    return GetCounter(MAC_PDU_RETX, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacVolumeUeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacVolumeUeSpecific(uint16_t rnti, uint16_t cellId, const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macVolumeUeSpecific, pair);
+    return GetCounter(MAC_VOLUME, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacPduQpskUeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacPduQpskUeSpecific(uint16_t rnti,
+                                      uint16_t cellId,
+                                      const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macPduQpskUeSpecific, pair);
+    return GetCounter(MAC_PDU_QPSK, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacPdu16QamUeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacPdu16QamUeSpecific(uint16_t rnti,
+                                       uint16_t cellId,
+                                       const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macPdu16QamUeSpecific, pair);
+    return GetCounter(MAC_PDU_16QAM, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacPdu64QamUeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacPdu64QamUeSpecific(uint16_t rnti,
+                                       uint16_t cellId,
+                                       const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macPdu64QamUeSpecific, pair);
+    return GetCounter(MAC_PDU_64QAM, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacNumberOfSymbolsUeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacNumberOfSymbolsUeSpecific(uint16_t rnti,
+                                              uint16_t cellId,
+                                              const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macNumberOfSymbols, pair);
+    return GetCounter(MAC_SYMBOLS, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacMcs04UeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacMcs04UeSpecific(uint16_t rnti, uint16_t cellId, const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macMcs04UeSpecific, pair);
+    return GetCounter(MAC_MCS_0_4, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacMcs59UeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacMcs59UeSpecific(uint16_t rnti, uint16_t cellId, const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macMcs59UeSpecific, pair);
+    return GetCounter(MAC_MCS_5_9, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacMcs1014UeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacMcs1014UeSpecific(uint16_t rnti,
+                                      uint16_t cellId,
+                                      const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macMcs1014UeSpecific, pair);
+    return GetCounter(MAC_MCS_10_14, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacMcs1519UeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacMcs1519UeSpecific(uint16_t rnti,
+                                      uint16_t cellId,
+                                      const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macMcs1519UeSpecific, pair);
+    return GetCounter(MAC_MCS_15_19, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacMcs2024UeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacMcs2024UeSpecific(uint16_t rnti,
+                                      uint16_t cellId,
+                                      const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macMcs2024UeSpecific, pair);
+    return GetCounter(MAC_MCS_20_24, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacMcs2529UeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacMcs2529UeSpecific(uint16_t rnti,
+                                      uint16_t cellId,
+                                      const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macMcs2529UeSpecific, pair);
+    return GetCounter(MAC_MCS_25_29, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacSinrBin1UeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacSinrBin1UeSpecific(uint16_t rnti,
+                                       uint16_t cellId,
+                                       const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macSinrBin1UeSpecific, pair);
+    return GetCounter(MAC_SINR_BIN_1, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacSinrBin2UeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacSinrBin2UeSpecific(uint16_t rnti,
+                                       uint16_t cellId,
+                                       const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macSinrBin2UeSpecific, pair);
+    return GetCounter(MAC_SINR_BIN_2, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacSinrBin3UeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacSinrBin3UeSpecific(uint16_t rnti,
+                                       uint16_t cellId,
+                                       const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macSinrBin3UeSpecific, pair);
+    return GetCounter(MAC_SINR_BIN_3, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacSinrBin4UeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacSinrBin4UeSpecific(uint16_t rnti,
+                                       uint16_t cellId,
+                                       const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macSinrBin4UeSpecific, pair);
+    return GetCounter(MAC_SINR_BIN_4, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacSinrBin5UeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacSinrBin5UeSpecific(uint16_t rnti,
+                                       uint16_t cellId,
+                                       const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macSinrBin5UeSpecific, pair);
+    return GetCounter(MAC_SINR_BIN_5, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacSinrBin6UeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacSinrBin6UeSpecific(uint16_t rnti,
+                                       uint16_t cellId,
+                                       const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macSinrBin6UeSpecific, pair);
+    return GetCounter(MAC_SINR_BIN_6, rnti, cellId, baseline);
 }
 
 uint32_t
-NoriE2Report::GetMacSinrBin7UeSpecific(uint16_t rnti, uint16_t cellId)
+NoriE2Report::GetMacSinrBin7UeSpecific(uint16_t rnti,
+                                       uint16_t cellId,
+                                       const Baseline& baseline) const
 {
-    RntiCellIdPair_t pair{rnti, cellId};
-    return GetMapValue(m_macSinrBin7UeSpecific, pair);
+    return GetCounter(MAC_SINR_BIN_7, rnti, cellId, baseline);
 }
 
 void
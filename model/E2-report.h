@@ -3,6 +3,10 @@
 #include "ns3/nr-bearer-stats-calculator.h"
 #include "ns3/nr-bearer-stats-connector.h"
 #include "ns3/nr-phy-mac-common.h"
+#include "ns3/nori-profiler.h"
+
+#include <array>
+#include <map>
 
 namespace ns3
 {
@@ -13,6 +17,46 @@ class NrBearerStatsCalculator;
 class NoriE2Report : public Object
 {
   public:
+    /**
+     * Counters of a UE, in the order of the values of a Baseline
+     */
+    enum Counter : uint8_t
+    {
+        MAC_PDU,         //!< MAC PDUs
+        MAC_PDU_INITIAL, //!< MAC PDUs, initial transmissions
+        MAC_PDU_RETX,    //!< MAC PDUs, retransmissions
+        MAC_VOLUME,      //!< MAC bytes
+        MAC_PDU_QPSK,    //!< MAC PDUs with QPSK
+        MAC_PDU_16QAM,   //!< MAC PDUs with 16QAM
+        MAC_PDU_64QAM,   //!< MAC PDUs with 64QAM
+        MAC_MCS_0_4,     //!< TX with MCS 0-4
+        MAC_MCS_5_9,     //!< TX with MCS 5-9
+        MAC_MCS_10_14,   //!< TX with MCS 10-14
+        MAC_MCS_15_19,   //!< TX with MCS 15-19
+        MAC_MCS_20_24,   //!< TX with MCS 20-24
+        MAC_MCS_25_29,   //!< TX with MCS 25-29
+        MAC_SINR_BIN_1,  //!< TX with SINR < -6 dB
+        MAC_SINR_BIN_2,  //!< TX with SINR -6 dB to 0 dB
+        MAC_SINR_BIN_3,  //!< TX with SINR 0 dB to 6 dB
+        MAC_SINR_BIN_4,  //!< TX with SINR 6 dB to 12 dB
+        MAC_SINR_BIN_5,  //!< TX with SINR 12 dB to 18 dB
+        MAC_SINR_BIN_6,  //!< TX with SINR 18 dB to 24 dB
+        MAC_SINR_BIN_7,  //!< TX with SINR > 24 dB
+        MAC_SYMBOLS,     //!< Symbols
+        NUM_COUNTERS,    //!< Number of counters
+    };
+
+    /**
+     * Counters of the UEs when a consumer last read them. The counters only grow, so
+     * that each consumer, e.g. a report group or the KPI snapshot, gets the counts of
+     * its own window. The differences are modulo 2^32, so that a counter may wrap
+     */
+    struct Baseline
+    {
+        std::map<RntiCellIdPair_t, std::array<uint32_t, NUM_COUNTERS>> values; //!< Counters
+        std::map<RntiCellIdPair_t, Time> resetTime; //!< Start of the window of each UE
+    };
+
     /**
      * Constructor
      */
@@ -34,183 +78,248 @@ class NoriE2Report : public Object
      * Gets the number of MAC PDUs, UE specific
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return the number of MAC PDUs, UE specific
      */
-    uint32_t GetMacPduUeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacPduUeSpecific(uint16_t rnti, uint16_t cellId, const Baseline& baseline) const;
 
     /**
      * Gets the number of MAC PDUs (initial tx), UE specific
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return the number of MAC PDUs (initial tx), UE specific
      */
-    uint32_t GetMacPduInitialTransmissionUeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacPduInitialTransmissionUeSpecific(uint16_t rnti,
+                                                    uint16_t cellId,
+                                                    const Baseline& baseline) const;
 
     /**
      * Gets the number of MAC PDUs (retx), UE specific
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return the number of MAC PDUs (retx), UE specific
      */
-    uint32_t GetMacPduRetransmissionUeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacPduRetransmissionUeSpecific(uint16_t rnti,
+                                               uint16_t cellId,
+                                               const Baseline& baseline) const;
 
     /**
      * Gets MAC volume (amount of TXed bytes), UE specific
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return amount of TXed bytes
      */
-    uint32_t GetMacVolumeUeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacVolumeUeSpecific(uint16_t rnti, uint16_t cellId, const Baseline& baseline) const;
 
     /**
      * Gets the number of MAC PDUs with QPSK, UE specific
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of MAC PDUs with QPSK
      */
-    uint32_t GetMacPduQpskUeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacPduQpskUeSpecific(uint16_t rnti,
+                                     uint16_t cellId,
+                                     const Baseline& baseline) const;
 
     /**
      * Gets the number of MAC PDUs with 16QAM, UE specific
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of MAC PDUs with 16QAM
      */
-    uint32_t GetMacPdu16QamUeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacPdu16QamUeSpecific(uint16_t rnti,
+                                      uint16_t cellId,
+                                      const Baseline& baseline) const;
 
     /**
      * Gets the number of MAC PDUs with 64QAM, UE specific
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of MAC PDUs with 64QAM
      */
-    uint32_t GetMacPdu64QamUeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacPdu64QamUeSpecific(uint16_t rnti,
+                                      uint16_t cellId,
+                                      const Baseline& baseline) const;
 
     /**
      * Gets the number of symbols, UE specific
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of symbols
      */
-    uint32_t GetMacNumberOfSymbolsUeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacNumberOfSymbolsUeSpecific(uint16_t rnti,
+                                             uint16_t cellId,
+                                             const Baseline& baseline) const;
 
     /**
      * Gets the number of TX with MCS 0-4
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of TX with MCS 0-4
      */
-    uint32_t GetMacMcs04UeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacMcs04UeSpecific(uint16_t rnti, uint16_t cellId, const Baseline& baseline) const;
 
     /**
      * Gets the number of TX with MCS 5-9
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of TX with MCS 5-9
      */
-    uint32_t GetMacMcs59UeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacMcs59UeSpecific(uint16_t rnti, uint16_t cellId, const Baseline& baseline) const;
 
     /**
      * Gets the number of TX with MCS 10-14
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of TX with MCS 10-14
      */
-    uint32_t GetMacMcs1014UeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacMcs1014UeSpecific(uint16_t rnti,
+                                     uint16_t cellId,
+                                     const Baseline& baseline) const;
 
     /**
      * Gets the number of TX with MCS 15-19
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of TX with MCS 15-19
      */
-    uint32_t GetMacMcs1519UeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacMcs1519UeSpecific(uint16_t rnti,
+                                     uint16_t cellId,
+                                     const Baseline& baseline) const;
 
     /**
      * Gets the number of TX with MCS 20-24
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of TX with MCS 20-24
      */
-    uint32_t GetMacMcs2024UeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacMcs2024UeSpecific(uint16_t rnti,
+                                     uint16_t cellId,
+                                     const Baseline& baseline) const;
 
     /**
      * Gets the number of TX with MCS 25-29
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of TX with MCS 25-29
      */
-    uint32_t GetMacMcs2529UeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacMcs2529UeSpecific(uint16_t rnti,
+                                     uint16_t cellId,
+                                     const Baseline& baseline) const;
 
     /**
      * Gets the number of TX with SINR < 6 dB
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of TX with SINR < 6 dB
      */
-    uint32_t GetMacSinrBin1UeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacSinrBin1UeSpecific(uint16_t rnti,
+                                      uint16_t cellId,
+                                      const Baseline& baseline) const;
 
     /**
      * Gets the number of TX with SINR 0-6 dB
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of TX with SINR 0-6 dB
      */
-    uint32_t GetMacSinrBin2UeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacSinrBin2UeSpecific(uint16_t rnti,
+                                      uint16_t cellId,
+                                      const Baseline& baseline) const;
 
     /**
      * Gets the number of TX with SINR 6-12 dB
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of TX with SINR 6-12 dB
      */
-    uint32_t GetMacSinrBin3UeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacSinrBin3UeSpecific(uint16_t rnti,
+                                      uint16_t cellId,
+                                      const Baseline& baseline) const;
 
     /**
      * Gets the number of TX with SINR 12-18 dB
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of TX with SINR 12-18 dB
      */
-    uint32_t GetMacSinrBin4UeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacSinrBin4UeSpecific(uint16_t rnti,
+                                      uint16_t cellId,
+                                      const Baseline& baseline) const;
 
     /**
      * Gets the number of TX with SINR 12-18 dB
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of TX with SINR 12-18 dB
      */
-    uint32_t GetMacSinrBin5UeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacSinrBin5UeSpecific(uint16_t rnti,
+                                      uint16_t cellId,
+                                      const Baseline& baseline) const;
 
     /**
      * Gets the number of TX with SINR 18-24 dB
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of TX with SINR 18-24 dB
      */
-    uint32_t GetMacSinrBin6UeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacSinrBin6UeSpecific(uint16_t rnti,
+                                      uint16_t cellId,
+                                      const Baseline& baseline) const;
 
     /**
      * Gets the number of TX with SINR > 24 dB
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
      * @return number of TX with SINR > 24 dB
      */
-    uint32_t GetMacSinrBin7UeSpecific(uint16_t rnti, uint16_t cellId);
+    uint32_t GetMacSinrBin7UeSpecific(uint16_t rnti,
+                                      uint16_t cellId,
+                                      const Baseline& baseline) const;
 
     /**
-     * Reset the counters for a specific UE
+     * Start a new window of a consumer for a specific UE, the counters themselves are
+     * left untouched
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window, updated
      */
-    void ResetPhyTracesForRntiCellId(uint16_t rnti, uint16_t cellId);
+    void ResetPhyTracesForRntiCellId(uint16_t rnti, uint16_t cellId, Baseline& baseline) const;
 
     /**
      * Get last reset time
      * @param rnti
      * @param cellId
+     * @param baseline the counters at the start of the window
+     * @return the start of the window, 0 if the UE was never reset
      */
-    Time GetLastResetTime(uint16_t rnti, uint16_t cellId);
+    Time GetLastResetTime(uint16_t rnti, uint16_t cellId, const Baseline& baseline) const;
+
+    /**
+     * @brief Time the trace updates in a profiler
+     * @param profiler the profiler of the gNB, nullptr to stop profiling
+     */
+    void SetProfiler(Ptr<NoriProfiler> profiler);
 
     /**
      * @brief Update PHY traces
@@ -271,7 +380,7 @@ class NoriE2Report : public Object
 
     std::map<RntiCellIdPair_t, uint32_t> m_macNumberOfSymbols; //!< UE specific number of symbols
 
-    std::map<RntiCellIdPair_t, Time> m_lastReset; //! last time UE was reset
+    Ptr<NoriProfiler> m_profiler; //!< Profiler of the gNB, may be null
 
     /**
      * Update the value of an entry in a map
@@ -293,19 +402,24 @@ class NoriE2Report : public Object
                                                           uint32_t value);
 
     /**
-     * Get an entry in a map
-     * @param map
-     * @param key
+     * Get a counter map
+     * @param counter the counter
+     * @return the map of the counter
      */
-    uint32_t GetMapValue(std::map<RntiCellIdPair_t, uint32_t> map, RntiCellIdPair_t key);
+    const std::map<RntiCellIdPair_t, uint32_t>& GetCounterMap(Counter counter) const;
 
     /**
-     * Erase an entry in a map
-     * @param map
-     * @param key
+     * Get a counter of a UE since the start of a window
+     * @param counter the counter
+     * @param rnti
+     * @param cellId
+     * @param baseline the counters at the start of the window
+     * @return the counts in the window
      */
-    std::map<RntiCellIdPair_t, uint32_t> ResetMapValue(std::map<RntiCellIdPair_t, uint32_t> map,
-                                                       RntiCellIdPair_t key);
+    uint32_t GetCounter(Counter counter,
+                        uint16_t rnti,
+                        uint16_t cellId,
+                        const Baseline& baseline) const;
 };
 
 } // namespace ns3
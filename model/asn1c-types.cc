@@ -800,7 +800,7 @@ MeasurementItem::MeasurementItem(std::string name)
     m_measurementItem->pmType = *m_pmType;
 
     m_measName = (MeasurementTypeName_t*)calloc(1, sizeof(MeasurementTypeName_t));
-    m_measName->buf = (uint8_t*)calloc(1, sizeof(OCTET_STRING));
+    m_measName->buf = (uint8_t*)calloc(1, name.length());
     m_measName->size = name.length();
     memcpy(m_measName->buf, name.c_str(), m_measName->size);
 
@@ -843,6 +843,8 @@ MeasurementItem::CreateMeasurementValue(MeasurementValue_PR measurementValue_PR)
 MeasurementItem::~MeasurementItem()
 {
     NS_LOG_FUNCTION(this);
+    // The KPM messages only borrow the item, which may be encoded more than once
+    ASN_STRUCT_FREE(asn_DEF_PM_Info_Item, m_measurementItem);
     if (m_pmVal != NULL)
         ASN_STRUCT_FREE(asn_DEF_MeasurementValue, m_pmVal);
 
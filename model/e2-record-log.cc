@@ -0,0 +1,187 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "e2-record-log.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("E2RecordLog");
+
+/**
+ * @param size a size in bytes
+ * @return the size rounded up to a multiple of 8 bytes
+ */
+static size_t
+Align8(size_t size)
+{
+    return (size + 7) & ~size_t(7);
+}
+
+E2RecordLog::E2RecordLog(const std::string& fileName, size_t bufferSize)
+    : m_fileName(fileName),
+      m_buffer(std::max(bufferSize, sizeof(FrameHeader)))
+{
+    NS_LOG_FUNCTION(this << fileName << bufferSize);
+    m_fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    NS_ABORT_MSG_IF(m_fd < 0, "Can't open file " << fileName << ": " << strerror(errno));
+
+    FileHeader header{MAGIC, VERSION, 0};
+    memcpy(m_buffer.data(), &header, sizeof(header));
+    m_used = sizeof(header);
+}
+
+E2RecordLog::~E2RecordLog()
+{
+    NS_LOG_FUNCTION(this);
+    Flush();
+    close(m_fd);
+    NS_LOG_INFO("Recorded " << m_frames << " frames, " << m_bytes << " bytes in " << m_fileName);
+}
+
+void
+E2RecordLog::Append(FrameHeader frame, const void* pdu, uint32_t size)
+{
+    frame.size = size;
+    size_t frameSize = sizeof(frame) + Align8(size);
+    if (m_used + frameSize > m_buffer.size())
+    {
+        Flush();
+    }
+    m_frames++;
+    m_bytes += frameSize;
+
+    if (frameSize > m_buffer.size())
+    {
+        // Larger than the whole buffer, written directly
+        static const uint8_t padding[8] = {};
+        Write(reinterpret_cast<const uint8_t*>(&frame), sizeof(frame));
+        Write(static_cast<const uint8_t*>(pdu), size);
+        Write(padding, Align8(size) - size);
+        return;
+    }
+
+    uint8_t* dst = m_buffer.data() + m_used;
+    memcpy(dst, &frame, sizeof(frame));
+    memcpy(dst + sizeof(frame), pdu, size);
+    memset(dst + sizeof(frame) + size, 0, Align8(size) - size);
+    m_used += frameSize;
+}
+
+void
+E2RecordLog::Flush()
+{
+    Write(m_buffer.data(), m_used);
+    m_used = 0;
+}
+
+void
+E2RecordLog::Write(const uint8_t* data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = write(m_fd, data, size);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        NS_ABORT_MSG_IF(written < 0, "Can't write to " << m_fileName << ": " << strerror(errno));
+        data += written;
+        size -= written;
+    }
+}
+
+const std::string&
+E2RecordLog::GetFileName() const
+{
+    return m_fileName;
+}
+
+uint64_t
+E2RecordLog::GetFrames() const
+{
+    return m_frames;
+}
+
+uint64_t
+E2RecordLog::GetBytes() const
+{
+    return m_bytes;
+}
+
+E2RecordReader::E2RecordReader(const std::string& fileName)
+    : m_fileName(fileName)
+{
+    NS_LOG_FUNCTION(this << fileName);
+    int fd = open(fileName.c_str(), O_RDONLY);
+    NS_ABORT_MSG_IF(fd < 0, "Can't open file " << fileName << ": " << strerror(errno));
+    struct stat st;
+    NS_ABORT_MSG_IF(fstat(fd, &st) < 0, "Can't stat " << fileName << ": " << strerror(errno));
+    m_size = st.st_size;
+    NS_ABORT_MSG_IF(m_size < sizeof(E2RecordLog::FileHeader), fileName << " is not an E2 log");
+
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    NS_ABORT_MSG_IF(data == MAP_FAILED, "Can't map " << fileName << ": " << strerror(errno));
+    // The frames are read once, in order
+    madvise(data, m_size, MADV_SEQUENTIAL);
+    m_data = static_cast<const uint8_t*>(data);
+
+    const auto* header = reinterpret_cast<const E2RecordLog::FileHeader*>(m_data);
+    NS_ABORT_MSG_IF(header->magic != E2RecordLog::MAGIC, fileName << " is not an E2 log");
+    NS_ABORT_MSG_IF(header->version != E2RecordLog::VERSION,
+                    "Unsupported version " << header->version << " of " << fileName);
+    Rewind();
+}
+
+E2RecordReader::~E2RecordReader()
+{
+    NS_LOG_FUNCTION(this);
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+}
+
+bool
+E2RecordReader::Next(const E2RecordLog::FrameHeader*& frame, const uint8_t*& pdu)
+{
+    if (m_offset + sizeof(E2RecordLog::FrameHeader) > m_size)
+    {
+        return false;
+    }
+    const auto* header = reinterpret_cast<const E2RecordLog::FrameHeader*>(m_data + m_offset);
+    size_t frameSize = sizeof(*header) + Align8(header->size);
+    if (m_offset + frameSize > m_size)
+    {
+        NS_LOG_WARN(m_fileName << " ends with a truncated frame");
+        return false;
+    }
+    frame = header;
+    pdu = m_data + m_offset + sizeof(*header);
+    m_offset += frameSize;
+    return true;
+}
+
+void
+E2RecordReader::Rewind()
+{
+    m_offset = sizeof(E2RecordLog::FileHeader);
+}
+
+size_t
+E2RecordReader::GetSize() const
+{
+    return m_size;
+}
+
+} // namespace ns3
@@ -0,0 +1,158 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include "ns3/simple-ref-count.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Append-only binary log of the encoded E2AP indications, for offline runs.
+ *
+ * The file starts with a FileHeader, followed by the frames. Each frame is a
+ * 32-byte FrameHeader followed by the APER encoded E2AP PDU, padded to a multiple
+ * of 8 bytes so that every header of a mapped log is aligned. All the fields are
+ * in the byte order of the host that wrote the log.
+ *
+ * The frames are accumulated in a memory buffer and written to the file only when
+ * it is full, so recording costs a copy per indication and a system call per
+ * buffer. A log can be shared by several E2 nodes of the same simulation.
+ */
+class E2RecordLog : public SimpleRefCount<E2RecordLog>
+{
+  public:
+    static const uint32_t MAGIC = 0x4c32454e; //!< "NE2L"
+    static const uint32_t VERSION = 1;        //!< Layout version
+
+    /**
+     * Layout of the start of the file
+     */
+    struct FileHeader
+    {
+        uint32_t magic;    //!< MAGIC
+        uint32_t version;  //!< VERSION
+        uint64_t reserved; //!< Reserved, 0
+    };
+
+    /**
+     * Header of each frame
+     */
+    struct FrameHeader
+    {
+        uint32_t size;           //!< PDU size, in bytes, without padding
+        uint16_t cellId;         //!< gNB cell that sent the indication
+        uint16_t ranFunctionId;  //!< RAN function of the subscription
+        int64_t simTimeNs;       //!< Simulation time of the indication, ns
+        uint16_t requestorId;    //!< RIC requestor ID of the subscription
+        uint16_t instanceId;     //!< RIC instance ID of the subscription
+        uint32_t sequenceNumber; //!< RIC indication sequence number
+        uint8_t actionId;        //!< RIC action ID of the subscription
+        uint8_t reserved[7];     //!< Reserved, 0
+    };
+
+    static_assert(sizeof(FileHeader) == 16, "FileHeader must stay 16 bytes");
+    static_assert(sizeof(FrameHeader) == 32, "FrameHeader must stay 32 bytes");
+
+    /**
+     * @brief Create the log, truncating the file if it exists
+     * @param fileName the file name
+     * @param bufferSize size of the write buffer, in bytes
+     */
+    E2RecordLog(const std::string& fileName, size_t bufferSize = 4 << 20);
+
+    ~E2RecordLog();
+
+    /**
+     * @brief Append a frame
+     * @param frame the frame header, whose size is set from the PDU size
+     * @param pdu the encoded PDU
+     * @param size the PDU size, in bytes
+     */
+    void Append(FrameHeader frame, const void* pdu, uint32_t size);
+
+    /**
+     * @brief Write the buffered frames to the file
+     */
+    void Flush();
+
+    /**
+     * @brief Get the name of the file
+     */
+    const std::string& GetFileName() const;
+
+    /**
+     * @return the number of frames appended
+     */
+    uint64_t GetFrames() const;
+
+    /**
+     * @return the number of bytes appended, headers included
+     */
+    uint64_t GetBytes() const;
+
+  private:
+    /**
+     * @brief Write a memory block to the file, handling partial writes
+     * @param data the block
+     * @param size its size
+     */
+    void Write(const uint8_t* data, size_t size);
+
+    std::string m_fileName;        //!< Log file name
+    int m_fd{-1};                  //!< Log file descriptor
+    std::vector<uint8_t> m_buffer; //!< Frames not yet written
+    size_t m_used{0};              //!< Bytes used in m_buffer
+    uint64_t m_frames{0};          //!< Frames appended
+    uint64_t m_bytes{0};           //!< Bytes appended
+};
+
+/**
+ * @brief Read-only view of an E2RecordLog, mapped in memory.
+ *
+ * The frames are returned in place, without copies, in the order they were
+ * recorded. A log truncated by a crash is read up to its last complete frame.
+ */
+class E2RecordReader : public SimpleRefCount<E2RecordReader>
+{
+  public:
+    /**
+     * @brief Map a log
+     * @param fileName the file name
+     */
+    E2RecordReader(const std::string& fileName);
+
+    ~E2RecordReader();
+
+    /**
+     * @brief Get the next frame
+     * @param frame the frame header
+     * @param pdu the encoded PDU, of frame->size bytes
+     * @return false at the end of the log
+     */
+    bool Next(const E2RecordLog::FrameHeader*& frame, const uint8_t*& pdu);
+
+    /**
+     * @brief Go back to the first frame
+     */
+    void Rewind();
+
+    /**
+     * @return the size of the log, in bytes
+     */
+    size_t GetSize() const;
+
+  private:
+    std::string m_fileName; //!< Log file name
+    const uint8_t* m_data;  //!< Start of the mapping
+    size_t m_size{0};       //!< Size of the mapping
+    size_t m_offset{0};     //!< Offset of the next frame
+};
+
+} // namespace ns3
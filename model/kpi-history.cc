@@ -0,0 +1,465 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "kpi-history.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("KpiHistory");
+
+KpiHistory::KpiHistory(const std::vector<std::string>& kpis, uint32_t depth)
+    : m_kpis(kpis),
+      m_depth(depth)
+{
+    NS_LOG_FUNCTION(this << kpis.size() << depth);
+    NS_ABORT_MSG_IF(depth == 0, "A KPI history needs a depth of at least one snapshot");
+}
+
+void
+KpiHistory::Add(uint64_t key, int64_t timestamp, const std::vector<double>& values)
+{
+    NS_ABORT_MSG_IF(values.size() != m_kpis.size(),
+                    "Snapshot of " << values.size() << " values in a history of "
+                                   << m_kpis.size() << " KPIs");
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Ring& ring = m_rings[key];
+    if (ring.timestamps.empty())
+    {
+        ring.timestamps.resize(m_depth);
+        ring.values.resize(size_t(m_depth) * m_kpis.size());
+    }
+
+    uint32_t slot;
+    if (ring.count < m_depth)
+    {
+        slot = (ring.head + ring.count++) % m_depth;
+    }
+    else
+    {
+        slot = ring.head;
+        ring.head = (ring.head + 1) % m_depth;
+    }
+    ring.timestamps[slot] = timestamp;
+    std::copy(values.begin(), values.end(), ring.values.begin() + size_t(slot) * m_kpis.size());
+}
+
+void
+KpiHistory::Remove(uint64_t key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_rings.erase(key);
+}
+
+const std::vector<std::string>&
+KpiHistory::GetKpis() const
+{
+    return m_kpis;
+}
+
+int
+KpiHistory::FindKpi(const std::string& name) const
+{
+    auto it = std::find(m_kpis.begin(), m_kpis.end(), name);
+    return (it == m_kpis.end()) ? -1 : it - m_kpis.begin();
+}
+
+uint32_t
+KpiHistory::GetDepth() const
+{
+    return m_depth;
+}
+
+std::vector<uint64_t>
+KpiHistory::GetKeys() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<uint64_t> keys;
+    keys.reserve(m_rings.size());
+    for (const auto& [key, ring] : m_rings)
+    {
+        keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+std::vector<KpiHistory::Sample>
+KpiHistory::Collect(const Ring& ring, size_t kpi, uint32_t begin, uint32_t end) const
+{
+    std::vector<Sample> samples;
+    samples.reserve(end - begin);
+    for (uint32_t i = begin; i < end; i++)
+    {
+        uint32_t slot = (ring.head + i) % m_depth;
+        samples.push_back({ring.timestamps[slot], ring.values[size_t(slot) * m_kpis.size() + kpi]});
+    }
+    return samples;
+}
+
+std::vector<KpiHistory::Sample>
+KpiHistory::GetRange(uint64_t key, size_t kpi, int64_t from, int64_t to) const
+{
+    NS_ABORT_MSG_IF(kpi >= m_kpis.size(), "No KPI " << kpi << " in the history");
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_rings.find(key);
+    if (it == m_rings.end() || from > to)
+    {
+        return {};
+    }
+    const Ring& ring = it->second;
+
+    // Positions of the first snapshot not before from, and of the first one after to
+    auto search = [&ring, this](int64_t timestamp, bool after) {
+        uint32_t low = 0;
+        uint32_t high = ring.count;
+        while (low < high)
+        {
+            uint32_t middle = (low + high) / 2;
+            int64_t value = ring.timestamps[(ring.head + middle) % m_depth];
+            if (after ? value <= timestamp : value < timestamp)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        return low;
+    };
+    return Collect(ring, kpi, search(from, false), search(to, true));
+}
+
+std::vector<KpiHistory::Sample>
+KpiHistory::GetLast(uint64_t key, size_t kpi, uint32_t n) const
+{
+    NS_ABORT_MSG_IF(kpi >= m_kpis.size(), "No KPI " << kpi << " in the history");
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_rings.find(key);
+    if (it == m_rings.end())
+    {
+        return {};
+    }
+    const Ring& ring = it->second;
+    return Collect(ring, kpi, ring.count - std::min(n, ring.count), ring.count);
+}
+
+KpiHistory::Summary
+KpiHistory::Summarize(const std::vector<Sample>& samples, double percentile)
+{
+    Summary summary;
+    if (samples.empty())
+    {
+        return summary;
+    }
+
+    std::vector<double> values;
+    values.reserve(samples.size());
+    double sum = 0;
+    for (const auto& sample : samples)
+    {
+        values.push_back(sample.value);
+        sum += sample.value;
+    }
+    summary.count = values.size();
+    summary.mean = sum / values.size();
+    auto [min, max] = std::minmax_element(values.begin(), values.end());
+    summary.min = *min;
+    summary.max = *max;
+    summary.first = samples.front().timestamp;
+    summary.last = samples.back().timestamp;
+
+    // Nearest rank, selected in linear time
+    double rank = std::ceil(std::clamp(percentile, 0.0, 100.0) / 100 * values.size());
+    size_t index = std::max(rank, 1.0) - 1;
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    summary.percentile = values[index];
+    return summary;
+}
+
+KpiHistoryServer::KpiHistoryServer(const std::string& path,
+                                   Ptr<KpiHistory> cellHistory,
+                                   Ptr<KpiHistory> ueHistory)
+    : m_path(path),
+      m_cellHistory(cellHistory),
+      m_ueHistory(ueHistory)
+{
+    NS_LOG_FUNCTION(this << path);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    NS_ABORT_MSG_IF(path.size() >= sizeof(address.sun_path), "Socket path too long: " << path);
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    m_listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    NS_ABORT_MSG_IF(m_listenFd < 0, "Can't create a socket: " << strerror(errno));
+    unlink(path.c_str());
+    NS_ABORT_MSG_IF(bind(m_listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0,
+                    "Can't bind " << path << ": " << strerror(errno));
+    NS_ABORT_MSG_IF(listen(m_listenFd, 8) < 0,
+                    "Can't listen on " << path << ": " << strerror(errno));
+    m_thread = std::thread(&KpiHistoryServer::ServeLoop, this);
+}
+
+KpiHistoryServer::~KpiHistoryServer()
+{
+    NS_LOG_FUNCTION(this);
+    Stop();
+}
+
+void
+KpiHistoryServer::Stop()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+    m_stop = true;
+    m_thread.join();
+    close(m_listenFd);
+    m_listenFd = -1;
+    unlink(m_path.c_str());
+}
+
+void
+KpiHistoryServer::ServeLoop()
+{
+    // A client that keeps this much unread, or sends a line this long, is dropped
+    const size_t maxBuffered = 1 << 20;
+
+    // The listening socket first, then the clients
+    std::vector<pollfd> fds{{m_listenFd, POLLIN, 0}};
+    std::vector<std::string> pending{""};
+    std::vector<std::string> unsent{""};
+
+    while (!m_stop)
+    {
+        // Wake up regularly to notice Stop
+        if (poll(fds.data(), fds.size(), 100) <= 0)
+        {
+            continue;
+        }
+        if (fds[0].revents & POLLIN)
+        {
+            // Non-blocking, so that a client not reading its answers can't block Stop
+            int fd = accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd >= 0)
+            {
+                fds.push_back({fd, POLLIN, 0});
+                pending.emplace_back();
+                unsent.emplace_back();
+            }
+        }
+
+        for (size_t i = fds.size() - 1; i > 0; i--)
+        {
+            if (fds[i].revents == 0)
+            {
+                continue;
+            }
+
+            bool drop = (fds[i].revents & (POLLERR | POLLNVAL)) != 0;
+            if (!drop && (fds[i].revents & (POLLIN | POLLHUP)))
+            {
+                char buffer[4096];
+                ssize_t received = recv(fds[i].fd, buffer, sizeof(buffer), 0);
+                if (received > 0)
+                {
+                    pending[i].append(buffer, received);
+                    size_t end;
+                    while ((end = pending[i].find('\n')) != std::string::npos)
+                    {
+                        unsent[i] += Handle(pending[i].substr(0, end)) + "\n";
+                        pending[i].erase(0, end + 1);
+                    }
+                }
+                else if (received == 0 || (errno != EINTR && errno != EAGAIN))
+                {
+                    drop = true;
+                }
+            }
+
+            while (!drop && !unsent[i].empty())
+            {
+                ssize_t sent = send(fds[i].fd, unsent[i].data(), unsent[i].size(), MSG_NOSIGNAL);
+                if (sent > 0)
+                {
+                    unsent[i].erase(0, sent);
+                }
+                else if (sent < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                else
+                {
+                    // The rest goes when the socket is writable again
+                    drop = sent == 0 || errno != EAGAIN;
+                    break;
+                }
+            }
+
+            if (!drop && (pending[i].size() > maxBuffered || unsent[i].size() > maxBuffered))
+            {
+                NS_LOG_WARN("Dropping a KPI history client that does not read its answers");
+                drop = true;
+            }
+            if (drop)
+            {
+                close(fds[i].fd);
+                fds.erase(fds.begin() + i);
+                pending.erase(pending.begin() + i);
+                unsent.erase(unsent.begin() + i);
+                continue;
+            }
+            fds[i].events = unsent[i].empty() ? POLLIN : POLLIN | POLLOUT;
+        }
+    }
+
+    for (size_t i = 1; i < fds.size(); i++)
+    {
+        close(fds[i].fd);
+    }
+}
+
+/**
+ * @brief Parse an unsigned decimal token
+ * @param tokens the stream to read the token from
+ * @param max the largest value accepted
+ * @param value the value, set on success
+ * @return whether the token is a decimal number not above max
+ */
+static bool
+ParseUnsigned(std::istream& tokens, uint64_t max, uint64_t& value)
+{
+    std::string token;
+    if (!(tokens >> token) || !std::all_of(token.begin(), token.end(), [](char c) {
+            return std::isdigit(static_cast<unsigned char>(c));
+        }))
+    {
+        return false;
+    }
+    errno = 0;
+    unsigned long long parsed = std::strtoull(token.c_str(), nullptr, 10);
+    if (errno == ERANGE || parsed > max)
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+std::string
+KpiHistoryServer::Handle(const std::string& request) const
+{
+    std::istringstream tokens(request);
+    std::string command;
+    std::string table;
+    tokens >> command >> table;
+
+    // Handled on the server thread, where copying the Ptr would race with the
+    // simulation on the reference count, which is not atomic. The server holds its
+    // references until the thread is joined
+    const KpiHistory* history = (table == "cell") ? PeekPointer(m_cellHistory)
+                                : (table == "ue") ? PeekPointer(m_ueHistory)
+                                                  : nullptr;
+    if (history == nullptr)
+    {
+        return "error no history " + table;
+    }
+
+    std::ostringstream answer;
+    answer.precision(10);
+    if (command == "kpis")
+    {
+        for (const auto& kpi : history->GetKpis())
+        {
+            answer << (answer.tellp() > 0 ? " " : "") << kpi;
+        }
+        return answer.str();
+    }
+    if (command == "keys")
+    {
+        for (uint64_t key : history->GetKeys())
+        {
+            answer << (answer.tellp() > 0 ? " " : "") << key;
+        }
+        return answer.str();
+    }
+
+    bool range = command == "range" || command == "aggrange";
+    bool last = command == "last" || command == "agglast";
+    if (!range && !last)
+    {
+        return "error unknown command " + command;
+    }
+
+    uint64_t key;
+    std::string kpiName;
+    if (!ParseUnsigned(tokens, UINT64_MAX, key) || !(tokens >> kpiName))
+    {
+        return "error expected " + command + " " + table + " KEY KPI";
+    }
+    int kpi = history->FindKpi(kpiName);
+    if (kpi < 0)
+    {
+        return "error no KPI " + kpiName;
+    }
+
+    std::vector<KpiHistory::Sample> samples;
+    if (range)
+    {
+        int64_t from;
+        int64_t to;
+        if (!(tokens >> from >> to))
+        {
+            return "error expected FROM TO";
+        }
+        samples = history->GetRange(key, kpi, from, to);
+    }
+    else
+    {
+        uint64_t n;
+        if (!ParseUnsigned(tokens, UINT32_MAX, n))
+        {
+            return "error expected N, from 0 to " + std::to_string(UINT32_MAX);
+        }
+        samples = history->GetLast(key, kpi, n);
+    }
+
+    if (command == "range" || command == "last")
+    {
+        for (size_t i = 0; i < samples.size(); i++)
+        {
+            answer << (i ? " " : "") << samples[i].timestamp << ":" << samples[i].value;
+        }
+        return answer.str();
+    }
+
+    double percentile;
+    if (!(tokens >> percentile))
+    {
+        percentile = 95;
+    }
+    auto summary = KpiHistory::Summarize(samples, percentile);
+    answer << summary.count << " " << summary.mean << " " << summary.min << " " << summary.max
+           << " " << summary.percentile << " " << summary.first << " " << summary.last;
+    return answer.str();
+}
+
+} // namespace ns3
@@ -0,0 +1,222 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Bounded history of KPI snapshots, one ring per UE or per cell.
+ *
+ * Each key (an IMSI, or a cell ID) has a ring of the last Depth snapshots it was
+ * given, a snapshot being a timestamp and one value per KPI. The snapshots of a
+ * key are expected in time order, so that a time range is located by a binary
+ * search and a query costs the size of its window only. The memory of a key is
+ * allocated on its first snapshot and never grows afterwards.
+ *
+ * The history may be queried from another thread than the one adding snapshots,
+ * e.g. by a KpiHistoryServer, every call takes a mutex.
+ */
+class KpiHistory : public SimpleRefCount<KpiHistory>
+{
+  public:
+    /**
+     * A value of a KPI at a given time
+     */
+    struct Sample
+    {
+        int64_t timestamp; //!< Timestamp of the snapshot
+        double value;      //!< Value of the KPI
+    };
+
+    /**
+     * Aggregates of the samples of a window
+     */
+    struct Summary
+    {
+        uint32_t count{0};    //!< Number of samples
+        double mean{0};       //!< Mean
+        double min{0};        //!< Smallest sample
+        double max{0};        //!< Largest sample
+        double percentile{0}; //!< Percentile asked for, nearest rank
+        int64_t first{0};     //!< Timestamp of the first sample
+        int64_t last{0};      //!< Timestamp of the last sample
+    };
+
+    /**
+     * @brief Constructor
+     * @param kpis the names of the KPIs of a snapshot
+     * @param depth the snapshots kept per key
+     */
+    KpiHistory(const std::vector<std::string>& kpis, uint32_t depth);
+
+    /**
+     * @brief Add a snapshot, overwriting the oldest one of its key when the ring is full
+     * @param key the IMSI of the UE, or the cell ID
+     * @param timestamp the timestamp of the snapshot
+     * @param values one value per KPI
+     */
+    void Add(uint64_t key, int64_t timestamp, const std::vector<double>& values);
+
+    /**
+     * @brief Forget a key
+     * @param key the IMSI of the UE, or the cell ID
+     */
+    void Remove(uint64_t key);
+
+    /**
+     * @brief Get the names of the KPIs of a snapshot
+     */
+    const std::vector<std::string>& GetKpis() const;
+
+    /**
+     * @brief Find a KPI by name
+     * @param name the KPI name
+     * @return the index of the KPI, -1 if not found
+     */
+    int FindKpi(const std::string& name) const;
+
+    /**
+     * @return the snapshots kept per key
+     */
+    uint32_t GetDepth() const;
+
+    /**
+     * @return the keys with at least one snapshot
+     */
+    std::vector<uint64_t> GetKeys() const;
+
+    /**
+     * @brief Get the samples of a KPI in a time range
+     * @param key the IMSI of the UE, or the cell ID
+     * @param kpi the index of the KPI
+     * @param from the first timestamp, included
+     * @param to the last timestamp, included
+     * @return the samples, oldest first
+     */
+    std::vector<Sample> GetRange(uint64_t key, size_t kpi, int64_t from, int64_t to) const;
+
+    /**
+     * @brief Get the last samples of a KPI
+     * @param key the IMSI of the UE, or the cell ID
+     * @param kpi the index of the KPI
+     * @param n the number of samples
+     * @return at most n samples, oldest first
+     */
+    std::vector<Sample> GetLast(uint64_t key, size_t kpi, uint32_t n) const;
+
+    /**
+     * @brief Aggregate samples
+     * @param samples the samples
+     * @param percentile the percentile to compute, in [0, 100]
+     * @return the aggregates, count 0 if there is no sample
+     */
+    static Summary Summarize(const std::vector<Sample>& samples, double percentile = 95);
+
+  private:
+    /**
+     * Snapshots of a key
+     */
+    struct Ring
+    {
+        std::vector<int64_t> timestamps; //!< Timestamp of each slot
+        std::vector<double> values;      //!< Values of each slot, slot after slot
+        uint32_t head{0};                //!< Slot of the oldest snapshot
+        uint32_t count{0};               //!< Snapshots held
+    };
+
+    /**
+     * @brief Collect the samples of a KPI between two positions of a ring, with
+     * m_mutex held
+     * @param ring the ring
+     * @param kpi the index of the KPI
+     * @param begin the first position, 0 being the oldest snapshot
+     * @param end the position after the last one
+     * @return the samples
+     */
+    std::vector<Sample> Collect(const Ring& ring, size_t kpi, uint32_t begin, uint32_t end) const;
+
+    std::vector<std::string> m_kpis;            //!< Names of the KPIs
+    uint32_t m_depth;                           //!< Snapshots kept per key
+    mutable std::mutex m_mutex;                 //!< Protects m_rings
+    std::unordered_map<uint64_t, Ring> m_rings; //!< Rings by key
+};
+
+/**
+ * @brief Serve the queries of local scripts or xApps on KPI histories through a
+ * Unix stream socket.
+ *
+ * The requests and the answers are lines of text, tokens separated by spaces;
+ * TABLE is "cell" or "ue" and KEY a cell ID or an IMSI:
+ * - "kpis TABLE" answers the KPI names;
+ * - "keys TABLE" answers the keys with a history;
+ * - "range TABLE KEY KPI FROM TO" answers the samples in the time range, as
+ *   "timestamp:value" tokens;
+ * - "last TABLE KEY KPI N" answers the last N samples, as "timestamp:value";
+ * - "aggrange TABLE KEY KPI FROM TO [P]" and "agglast TABLE KEY KPI N [P]" answer
+ *   "count mean min max percentile first last" for the same windows, P being the
+ *   percentile, 95 by default.
+ *
+ * An invalid request is answered with "error" followed by the reason. The
+ * server runs in its own thread, so the queries do not wait for the simulation.
+ * The clients are never waited for: one that leaves more than 1 MiB of answers
+ * unread, or sends a longer line, is disconnected.
+ */
+class KpiHistoryServer : public SimpleRefCount<KpiHistoryServer>
+{
+  public:
+    /**
+     * @brief Listen on a socket, replacing the file if it exists
+     * @param path the path of the socket
+     * @param cellHistory the history of the cells, or nullptr
+     * @param ueHistory the history of the UEs, or nullptr
+     */
+    KpiHistoryServer(const std::string& path,
+                     Ptr<KpiHistory> cellHistory,
+                     Ptr<KpiHistory> ueHistory);
+
+    /**
+     * @brief Stop the server, if not done yet
+     */
+    ~KpiHistoryServer();
+
+    /**
+     * @brief Stop serving, close the connections and remove the socket file
+     */
+    void Stop();
+
+    /**
+     * @brief Answer a request
+     * @param request the request line, without the line feed
+     * @return the answer line, without the line feed
+     */
+    std::string Handle(const std::string& request) const;
+
+  private:
+    /**
+     * @brief Body of the server thread
+     */
+    void ServeLoop();
+
+    std::string m_path;              //!< Path of the socket
+    Ptr<KpiHistory> m_cellHistory;   //!< History of the cells
+    Ptr<KpiHistory> m_ueHistory;     //!< History of the UEs
+    int m_listenFd{-1};              //!< Listening socket
+    std::atomic<bool> m_stop{false}; //!< Whether the server must exit
+    std::thread m_thread;            //!< Server thread
+};
+
+} // namespace ns3
@@ -0,0 +1,540 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "kpi-store.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("KpiStore");
+
+/**
+ * @param size a size in bytes
+ * @return the size rounded up to a multiple of 8 bytes
+ */
+static size_t
+Align8(size_t size)
+{
+    return (size + 7) & ~size_t(7);
+}
+
+/**
+ * @brief Append an unsigned LEB128 varint
+ * @param out the buffer
+ * @param value the value
+ */
+static void
+PutVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+/**
+ * @brief Read an unsigned LEB128 varint
+ * @param data the current position, moved past the varint
+ * @param end the end of the data
+ * @return the value
+ */
+static uint64_t
+GetVarint(const uint8_t*& data, const uint8_t* end)
+{
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+        NS_ABORT_MSG_IF(data == end, "Truncated varint in a KPI store");
+        uint8_t byte = *data++;
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            return value;
+        }
+    }
+    NS_ABORT_MSG("Invalid varint in a KPI store");
+    return 0;
+}
+
+/**
+ * @brief Append a varint carrying a tag bit in its lowest bit
+ * @param out the buffer
+ * @param value the value
+ * @param tag the tag
+ */
+static void
+PutTaggedVarint(std::vector<uint8_t>& out, uint64_t value, bool tag)
+{
+    uint8_t first = (value & 0x3f) << 1 | (tag ? 1 : 0);
+    value >>= 6;
+    if (value == 0)
+    {
+        out.push_back(first);
+        return;
+    }
+    out.push_back(first | 0x80);
+    PutVarint(out, value);
+}
+
+/**
+ * @brief Read a varint written by PutTaggedVarint
+ * @param data the current position, moved past the varint
+ * @param end the end of the data
+ * @param tag the tag
+ * @return the value
+ */
+static uint64_t
+GetTaggedVarint(const uint8_t*& data, const uint8_t* end, bool& tag)
+{
+    NS_ABORT_MSG_IF(data == end, "Truncated varint in a KPI store");
+    uint8_t first = *data++;
+    tag = first & 1;
+    uint64_t value = (first >> 1) & 0x3f;
+    if (first & 0x80)
+    {
+        value |= GetVarint(data, end) << 6;
+    }
+    return value;
+}
+
+/**
+ * @param value a signed value
+ * @return the value with its sign in the lowest bit, so that small magnitudes
+ * make small varints
+ */
+static uint64_t
+ZigZag(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+/**
+ * @param value a value built by ZigZag
+ * @return the signed value
+ */
+static int64_t
+UnZigZag(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/**
+ * @param value a double
+ * @return its bits
+ */
+static uint64_t
+DoubleBits(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+KpiStoreWriter::KpiStoreWriter(const std::string& fileName,
+                               const std::vector<Column>& columns,
+                               uint32_t rowsPerBlock)
+    : m_fileName(fileName),
+      m_columns(columns),
+      m_rowsPerBlock(std::max(rowsPerBlock, 1u))
+{
+    NS_LOG_FUNCTION(this << fileName << columns.size() << rowsPerBlock);
+    m_fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    NS_ABORT_MSG_IF(m_fd < 0, "Can't open file " << fileName << ": " << strerror(errno));
+
+    FileHeader header{MAGIC, VERSION, static_cast<uint32_t>(columns.size()), m_rowsPerBlock};
+    m_encoded.resize(sizeof(header));
+    memcpy(m_encoded.data(), &header, sizeof(header));
+    for (const auto& column : columns)
+    {
+        NS_ABORT_MSG_IF(column.name.size() > 255, "Column name too long: " << column.name);
+        m_encoded.push_back(column.type);
+        m_encoded.push_back(static_cast<uint8_t>(column.name.size()));
+        m_encoded.insert(m_encoded.end(), column.name.begin(), column.name.end());
+    }
+    m_encoded.resize(Align8(m_encoded.size()), 0);
+    Write(m_encoded.data(), m_encoded.size());
+}
+
+KpiStoreWriter::~KpiStoreWriter()
+{
+    NS_LOG_FUNCTION(this);
+    Close();
+}
+
+void
+KpiStoreWriter::Append(uint16_t cellId, int64_t timestamp, const std::vector<double>& values)
+{
+    NS_ABORT_MSG_IF(m_fd < 0, "Append to the closed KPI store " << m_fileName);
+    NS_ABORT_MSG_IF(values.size() != m_columns.size(),
+                    "Row of " << values.size() << " values in a store of " << m_columns.size()
+                              << " columns");
+    PendingBlock& block = m_pending[cellId];
+    if (block.timestamps.empty())
+    {
+        block.timestamps.reserve(m_rowsPerBlock);
+        block.values.reserve(size_t(m_rowsPerBlock) * m_columns.size());
+    }
+    block.timestamps.push_back(timestamp);
+    block.values.insert(block.values.end(), values.begin(), values.end());
+    m_rows++;
+
+    if (block.timestamps.size() == m_rowsPerBlock)
+    {
+        WriteBlock(cellId, block);
+    }
+}
+
+void
+KpiStoreWriter::Flush()
+{
+    for (auto& [cellId, block] : m_pending)
+    {
+        if (!block.timestamps.empty())
+        {
+            WriteBlock(cellId, block);
+        }
+    }
+}
+
+void
+KpiStoreWriter::Close()
+{
+    if (m_fd < 0)
+    {
+        return;
+    }
+    Flush();
+    m_pending.clear();
+
+    Footer footer{m_offset, static_cast<uint32_t>(m_index.size()), MAGIC};
+    Write(reinterpret_cast<const uint8_t*>(m_index.data()), m_index.size() * sizeof(BlockHeader));
+    Write(reinterpret_cast<const uint8_t*>(&footer), sizeof(footer));
+    close(m_fd);
+    m_fd = -1;
+    NS_LOG_INFO("Stored " << m_rows << " rows in " << m_index.size() << " blocks, " << m_offset
+                          << " bytes in " << m_fileName);
+}
+
+void
+KpiStoreWriter::WriteBlock(uint16_t cellId, PendingBlock& block)
+{
+    uint32_t rows = block.timestamps.size();
+    size_t nColumns = m_columns.size();
+    size_t dataStart = sizeof(BlockHeader) + (nColumns + 1) * sizeof(uint32_t);
+
+    m_encoded.assign(dataStart, 0);
+    std::vector<uint32_t> ends;
+    ends.reserve(nColumns + 1);
+
+    int64_t previous = 0;
+    for (int64_t timestamp : block.timestamps)
+    {
+        PutVarint(m_encoded, ZigZag(timestamp - previous));
+        previous = timestamp;
+    }
+    ends.push_back(m_encoded.size() - dataStart);
+
+    for (size_t column = 0; column < nColumns; column++)
+    {
+        // An INT value that llround can't represent makes the block keep the column
+        // as doubles
+        bool integer = m_columns[column].type == INT;
+        for (uint32_t row = 0; integer && row < rows; row++)
+        {
+            double value = block.values[row * nColumns + column];
+            integer = std::isfinite(value) && std::fabs(value) < 0x1p63;
+        }
+
+        uint64_t previousBits = 0;
+        int64_t previousValue = 0;
+        for (uint32_t row = 0; row < rows; row++)
+        {
+            double value = block.values[row * nColumns + column];
+            if (integer)
+            {
+                int64_t integer = std::llround(value);
+                PutVarint(m_encoded, ZigZag(integer - previousValue));
+                previousValue = integer;
+            }
+            else
+            {
+                // Close values share their sign, exponent and first mantissa bits, so
+                // their XOR has high zero bytes. Integral values and values with few
+                // decimals have a short mantissa instead, so the XOR has low zero
+                // bytes, moved to the top by a byte swap
+                uint64_t bits = DoubleBits(value);
+                uint64_t diff = bits ^ previousBits;
+                bool swap = diff != 0 && __builtin_ctzll(diff) > __builtin_clzll(diff);
+                PutTaggedVarint(m_encoded, swap ? __builtin_bswap64(diff) : diff, swap);
+                previousBits = bits;
+            }
+        }
+        uint32_t end = m_encoded.size() - dataStart;
+        ends.push_back((integer || m_columns[column].type == DOUBLE) ? end : end | DOUBLE_ENCODED);
+    }
+    m_encoded.resize(Align8(m_encoded.size()), 0);
+
+    BlockHeader header{};
+    header.magic = BLOCK_MAGIC;
+    header.rows = rows;
+    header.cellId = cellId;
+    header.size = m_encoded.size();
+    header.firstTimestamp = block.timestamps.front();
+    header.lastTimestamp = block.timestamps.back();
+    header.offset = m_offset;
+    memcpy(m_encoded.data(), &header, sizeof(header));
+    memcpy(m_encoded.data() + sizeof(header), ends.data(), ends.size() * sizeof(uint32_t));
+
+    Write(m_encoded.data(), m_encoded.size());
+    m_index.push_back(header);
+    block.timestamps.clear();
+    block.values.clear();
+}
+
+void
+KpiStoreWriter::Write(const uint8_t* data, size_t size)
+{
+    m_offset += size;
+    while (size > 0)
+    {
+        ssize_t written = write(m_fd, data, size);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        NS_ABORT_MSG_IF(written < 0, "Can't write to " << m_fileName << ": " << strerror(errno));
+        data += written;
+        size -= written;
+    }
+}
+
+const std::vector<KpiStoreWriter::Column>&
+KpiStoreWriter::GetColumns() const
+{
+    return m_columns;
+}
+
+uint64_t
+KpiStoreWriter::GetRows() const
+{
+    return m_rows;
+}
+
+uint64_t
+KpiStoreWriter::GetBytes() const
+{
+    return m_offset;
+}
+
+KpiStoreReader::KpiStoreReader(const std::string& fileName)
+    : m_fileName(fileName)
+{
+    NS_LOG_FUNCTION(this << fileName);
+    int fd = open(fileName.c_str(), O_RDONLY);
+    NS_ABORT_MSG_IF(fd < 0, "Can't open file " << fileName << ": " << strerror(errno));
+    struct stat st;
+    NS_ABORT_MSG_IF(fstat(fd, &st) < 0, "Can't stat " << fileName << ": " << strerror(errno));
+    m_size = st.st_size;
+    NS_ABORT_MSG_IF(m_size < sizeof(KpiStoreWriter::FileHeader),
+                    fileName << " is not a KPI store");
+
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    NS_ABORT_MSG_IF(data == MAP_FAILED, "Can't map " << fileName << ": " << strerror(errno));
+    m_data = static_cast<const uint8_t*>(data);
+
+    const auto* header = reinterpret_cast<const KpiStoreWriter::FileHeader*>(m_data);
+    NS_ABORT_MSG_IF(header->magic != KpiStoreWriter::MAGIC, fileName << " is not a KPI store");
+    NS_ABORT_MSG_IF(header->version != KpiStoreWriter::VERSION,
+                    "Unsupported version " << header->version << " of " << fileName);
+
+    size_t offset = sizeof(*header);
+    for (uint32_t i = 0; i < header->nColumns; i++)
+    {
+        NS_ABORT_MSG_IF(offset + 2 > m_size, fileName << " has a truncated schema");
+        auto type = static_cast<KpiStoreWriter::ColumnType>(m_data[offset]);
+        size_t length = m_data[offset + 1];
+        NS_ABORT_MSG_IF(offset + 2 + length > m_size, fileName << " has a truncated schema");
+        m_columns.push_back(
+            {std::string(reinterpret_cast<const char*>(m_data + offset + 2), length), type});
+        offset += 2 + length;
+    }
+    offset = Align8(offset);
+
+    const auto* footer = reinterpret_cast<const KpiStoreWriter::Footer*>(
+        m_data + m_size - sizeof(KpiStoreWriter::Footer));
+    if (m_size >= offset + sizeof(*footer) && footer->magic == KpiStoreWriter::MAGIC &&
+        footer->indexOffset + footer->nBlocks * sizeof(KpiStoreWriter::BlockHeader) +
+                sizeof(*footer) ==
+            m_size)
+    {
+        const auto* index =
+            reinterpret_cast<const KpiStoreWriter::BlockHeader*>(m_data + footer->indexOffset);
+        m_blocks.assign(index, index + footer->nBlocks);
+    }
+    else
+    {
+        NS_LOG_WARN(fileName << " has no index, the blocks are scanned");
+        ScanBlocks(offset);
+    }
+}
+
+KpiStoreReader::~KpiStoreReader()
+{
+    NS_LOG_FUNCTION(this);
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+}
+
+void
+KpiStoreReader::ScanBlocks(size_t offset)
+{
+    size_t minSize =
+        sizeof(KpiStoreWriter::BlockHeader) + (m_columns.size() + 1) * sizeof(uint32_t);
+    while (offset + sizeof(KpiStoreWriter::BlockHeader) <= m_size)
+    {
+        const auto* header = reinterpret_cast<const KpiStoreWriter::BlockHeader*>(m_data + offset);
+        if (header->magic != KpiStoreWriter::BLOCK_MAGIC || header->offset != offset ||
+            header->size < minSize || offset + header->size > m_size)
+        {
+            break;
+        }
+        m_blocks.push_back(*header);
+        offset += header->size;
+    }
+}
+
+const std::vector<KpiStoreWriter::Column>&
+KpiStoreReader::GetColumns() const
+{
+    return m_columns;
+}
+
+int
+KpiStoreReader::FindColumn(const std::string& name) const
+{
+    for (size_t i = 0; i < m_columns.size(); i++)
+    {
+        if (m_columns[i].name == name)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const std::vector<KpiStoreWriter::BlockHeader>&
+KpiStoreReader::GetBlocks() const
+{
+    return m_blocks;
+}
+
+std::vector<size_t>
+KpiStoreReader::FindBlocks(int64_t from, int64_t to, int32_t cellId) const
+{
+    std::vector<size_t> blocks;
+    for (size_t i = 0; i < m_blocks.size(); i++)
+    {
+        const auto& block = m_blocks[i];
+        if ((cellId < 0 || block.cellId == cellId) && block.lastTimestamp >= from &&
+            block.firstTimestamp <= to)
+        {
+            blocks.push_back(i);
+        }
+    }
+    return blocks;
+}
+
+const uint8_t*
+KpiStoreReader::GetColumnData(size_t block,
+                              size_t column,
+                              size_t& size,
+                              bool& doubleEncoded) const
+{
+    NS_ABORT_MSG_IF(block >= m_blocks.size(), "No block " << block << " in " << m_fileName);
+    NS_ABORT_MSG_IF(column > m_columns.size(), "No column " << column << " in " << m_fileName);
+    const uint8_t* start = m_data + m_blocks[block].offset;
+    const auto* ends =
+        reinterpret_cast<const uint32_t*>(start + sizeof(KpiStoreWriter::BlockHeader));
+    const uint8_t* data =
+        start + sizeof(KpiStoreWriter::BlockHeader) + (m_columns.size() + 1) * sizeof(uint32_t);
+
+    uint32_t begin = (column == 0) ? 0 : ends[column - 1] & ~KpiStoreWriter::DOUBLE_ENCODED;
+    uint32_t end = ends[column] & ~KpiStoreWriter::DOUBLE_ENCODED;
+    NS_ABORT_MSG_IF(end < begin || data + end > start + m_blocks[block].size,
+                    "Corrupted block " << block << " in " << m_fileName);
+    size = end - begin;
+    doubleEncoded = ends[column] & KpiStoreWriter::DOUBLE_ENCODED;
+    return data + begin;
+}
+
+void
+KpiStoreReader::ReadTimestamps(size_t block, std::vector<int64_t>& timestamps) const
+{
+    size_t size;
+    bool doubleEncoded;
+    const uint8_t* data = GetColumnData(block, 0, size, doubleEncoded);
+    const uint8_t* end = data + size;
+    NS_ABORT_MSG_IF(doubleEncoded, "Corrupted block " << block << " in " << m_fileName);
+
+    timestamps.resize(m_blocks[block].rows);
+    int64_t previous = 0;
+    for (auto& timestamp : timestamps)
+    {
+        previous += UnZigZag(GetVarint(data, end));
+        timestamp = previous;
+    }
+}
+
+void
+KpiStoreReader::ReadColumn(size_t block, size_t column, std::vector<double>& values) const
+{
+    size_t size;
+    bool doubleEncoded;
+    const uint8_t* data = GetColumnData(block, column + 1, size, doubleEncoded);
+    const uint8_t* end = data + size;
+
+    values.resize(m_blocks[block].rows);
+    if (m_columns[column].type == KpiStoreWriter::INT && !doubleEncoded)
+    {
+        int64_t previous = 0;
+        for (auto& value : values)
+        {
+            previous += UnZigZag(GetVarint(data, end));
+            value = previous;
+        }
+    }
+    else
+    {
+        uint64_t previousBits = 0;
+        for (auto& value : values)
+        {
+            bool swap;
+            uint64_t diff = GetTaggedVarint(data, end, swap);
+            previousBits ^= swap ? __builtin_bswap64(diff) : diff;
+            memcpy(&value, &previousBits, sizeof(value));
+        }
+    }
+}
+
+size_t
+KpiStoreReader::GetSize() const
+{
+    return m_size;
+}
+
+} // namespace ns3
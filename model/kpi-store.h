@@ -0,0 +1,283 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include "ns3/simple-ref-count.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Columnar binary store of KPI time series, written incrementally.
+ *
+ * A store is a table with a fixed schema: every row has a timestamp, a cell ID
+ * and one value per column. The rows are grouped in blocks of one cell, of at most
+ * RowsPerBlock rows, and each block keeps its columns one after the other:
+ * - the timestamps and the INT columns are delta encoded and written as zigzag
+ *   varints, so that counters and sorted timestamps take one or two bytes;
+ * - the DOUBLE columns are XORed with the previous value and written as varints,
+ *   byte swapped when the low bytes are the zero ones, so that repeated, close
+ *   and integral values take few bytes;
+ * - an INT column given a value that is not finite, or out of the int64_t range,
+ *   is encoded as a DOUBLE column in that block, so that the value is kept as is.
+ *
+ * The file starts with a FileHeader and the column descriptors, followed by the
+ * blocks, and ends with an index of the blocks (cell and time range of each) and
+ * a Footer. Only the blocks being filled are kept in memory, one per cell. All the
+ * fields are in the byte order of the host that wrote the store.
+ */
+class KpiStoreWriter : public SimpleRefCount<KpiStoreWriter>
+{
+  public:
+    static const uint32_t MAGIC = 0x49504b4e;        //!< "NKPI"
+    static const uint32_t BLOCK_MAGIC = 0x4b4c4253;  //!< "SBLK"
+    static const uint32_t VERSION = 2;               //!< Layout version
+    static const uint32_t DOUBLE_ENCODED = 1u << 31; //!< Column end flag, see BlockHeader
+
+    /**
+     * Type of a column
+     */
+    enum ColumnType : uint8_t
+    {
+        INT = 0,    //!< Integer, delta encoded
+        DOUBLE = 1, //!< IEEE 754 double, XOR encoded
+    };
+
+    /**
+     * Descriptor of a column
+     */
+    struct Column
+    {
+        std::string name; //!< Column name, at most 255 characters
+        ColumnType type;  //!< Column type
+    };
+
+    /**
+     * Layout of the start of the file, followed by the column descriptors: type,
+     * name length and name of each, padded to a multiple of 8 bytes
+     */
+    struct FileHeader
+    {
+        uint32_t magic;        //!< MAGIC
+        uint32_t version;      //!< VERSION
+        uint32_t nColumns;     //!< Number of columns, timestamp and cell ID excluded
+        uint32_t rowsPerBlock; //!< Maximum rows of a block
+    };
+
+    /**
+     * Header of each block, followed by the end offset of each encoded column,
+     * from the end of the header, and by the encoded columns, timestamps first,
+     * padded to a multiple of 8 bytes. The end offset of an INT column encoded as a
+     * DOUBLE one in the block carries DOUBLE_ENCODED. Also the entry of a block in the
+     * index
+     */
+    struct BlockHeader
+    {
+        uint32_t magic;         //!< BLOCK_MAGIC
+        uint32_t rows;          //!< Number of rows
+        uint16_t cellId;        //!< Cell of all the rows
+        uint16_t reserved;      //!< Reserved, 0
+        uint32_t size;          //!< Block size, header and padding included
+        int64_t firstTimestamp; //!< Timestamp of the first row
+        int64_t lastTimestamp;  //!< Timestamp of the last row
+        uint64_t offset;        //!< Offset of the block in the file
+    };
+
+    /**
+     * Layout of the end of the file
+     */
+    struct Footer
+    {
+        uint64_t indexOffset; //!< Offset of the index, an array of BlockHeader
+        uint32_t nBlocks;     //!< Number of blocks in the index
+        uint32_t magic;       //!< MAGIC
+    };
+
+    static_assert(sizeof(FileHeader) == 16, "FileHeader must stay 16 bytes");
+    static_assert(sizeof(BlockHeader) == 40, "BlockHeader must stay 40 bytes");
+    static_assert(sizeof(Footer) == 16, "Footer must stay 16 bytes");
+
+    /**
+     * @brief Create the store, truncating the file if it exists
+     * @param fileName the file name
+     * @param columns the columns of the rows
+     * @param rowsPerBlock the maximum rows of a block
+     */
+    KpiStoreWriter(const std::string& fileName,
+                   const std::vector<Column>& columns,
+                   uint32_t rowsPerBlock = 4096);
+
+    /**
+     * @brief Close the store, if not done yet
+     */
+    ~KpiStoreWriter();
+
+    /**
+     * @brief Append a row
+     * @param cellId the cell the row belongs to
+     * @param timestamp the timestamp of the row
+     * @param values one value per column, the INT columns are rounded when finite
+     */
+    void Append(uint16_t cellId, int64_t timestamp, const std::vector<double>& values);
+
+    /**
+     * @brief Write the blocks being filled, even if not full
+     */
+    void Flush();
+
+    /**
+     * @brief Write the blocks being filled and the index. Nothing can be appended
+     * afterwards
+     */
+    void Close();
+
+    /**
+     * @brief Get the columns of the rows
+     */
+    const std::vector<Column>& GetColumns() const;
+
+    /**
+     * @return the number of rows appended
+     */
+    uint64_t GetRows() const;
+
+    /**
+     * @return the number of bytes written
+     */
+    uint64_t GetBytes() const;
+
+  private:
+    /**
+     * Rows of a cell not yet written
+     */
+    struct PendingBlock
+    {
+        std::vector<int64_t> timestamps; //!< Timestamp of each row
+        std::vector<double> values;      //!< Values, row after row
+    };
+
+    /**
+     * @brief Encode and write a block, and add it to the index
+     * @param cellId the cell of the block
+     * @param block the rows of the block, cleared
+     */
+    void WriteBlock(uint16_t cellId, PendingBlock& block);
+
+    /**
+     * @brief Write a memory block to the file, handling partial writes
+     * @param data the block
+     * @param size its size
+     */
+    void Write(const uint8_t* data, size_t size);
+
+    std::string m_fileName;                     //!< Store file name
+    int m_fd{-1};                               //!< Store file descriptor
+    std::vector<Column> m_columns;              //!< Columns of the rows
+    uint32_t m_rowsPerBlock;                    //!< Maximum rows of a block
+    std::map<uint16_t, PendingBlock> m_pending; //!< Blocks being filled, by cell
+    std::vector<BlockHeader> m_index;           //!< Blocks written
+    std::vector<uint8_t> m_encoded;             //!< Encoding buffer of a block
+    uint64_t m_offset{0};                       //!< Bytes written
+    uint64_t m_rows{0};                         //!< Rows appended
+};
+
+/**
+ * @brief Read-only view of a KpiStoreWriter file, mapped in memory.
+ *
+ * The index locates the blocks of a cell and of a time range without reading
+ * them, and each column of a block is decoded on its own. A store whose index
+ * is missing, because the writer did not close it, is indexed by walking the
+ * blocks, up to the last complete one.
+ */
+class KpiStoreReader : public SimpleRefCount<KpiStoreReader>
+{
+  public:
+    /**
+     * @brief Map a store
+     * @param fileName the file name
+     */
+    KpiStoreReader(const std::string& fileName);
+
+    ~KpiStoreReader();
+
+    /**
+     * @brief Get the columns of the rows
+     */
+    const std::vector<KpiStoreWriter::Column>& GetColumns() const;
+
+    /**
+     * @brief Find a column by name
+     * @param name the column name
+     * @return the index of the column, -1 if not found
+     */
+    int FindColumn(const std::string& name) const;
+
+    /**
+     * @brief Get the index of the blocks, in file order
+     */
+    const std::vector<KpiStoreWriter::BlockHeader>& GetBlocks() const;
+
+    /**
+     * @brief Find the blocks that may hold rows of a time range
+     * @param from the first timestamp, included
+     * @param to the last timestamp, included
+     * @param cellId the cell, -1 for all the cells
+     * @return the indexes of the blocks, in file order
+     */
+    std::vector<size_t> FindBlocks(int64_t from, int64_t to, int32_t cellId = -1) const;
+
+    /**
+     * @brief Decode the timestamps of a block
+     * @param block the index of the block
+     * @param timestamps the timestamps, one per row
+     */
+    void ReadTimestamps(size_t block, std::vector<int64_t>& timestamps) const;
+
+    /**
+     * @brief Decode a column of a block
+     * @param block the index of the block
+     * @param column the index of the column
+     * @param values the values, one per row
+     */
+    void ReadColumn(size_t block, size_t column, std::vector<double>& values) const;
+
+    /**
+     * @return the size of the store, in bytes
+     */
+    size_t GetSize() const;
+
+  private:
+    /**
+     * @brief Get the encoded data of a column of a block
+     * @param block the index of the block
+     * @param column the column, 0 for the timestamps and i + 1 for column i
+     * @param size the size of the data
+     * @param doubleEncoded whether the column is encoded as a DOUBLE one
+     * @return the data
+     */
+    const uint8_t* GetColumnData(size_t block,
+                                 size_t column,
+                                 size_t& size,
+                                 bool& doubleEncoded) const;
+
+    /**
+     * @brief Build the index by walking the blocks
+     * @param offset the offset of the first block
+     */
+    void ScanBlocks(size_t offset);
+
+    std::string m_fileName;                            //!< Store file name
+    const uint8_t* m_data{nullptr};                    //!< Start of the mapping
+    size_t m_size{0};                                  //!< Size of the mapping
+    std::vector<KpiStoreWriter::Column> m_columns;     //!< Columns of the rows
+    std::vector<KpiStoreWriter::BlockHeader> m_blocks; //!< Index of the blocks
+};
+
+} // namespace ns3
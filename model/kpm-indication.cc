@@ -16,9 +16,12 @@
 #include "kpm-indication.h"
 
 #include "asn1c-types.h"
+#include "pdu-dump.h"
 
 #include "ns3/log.h"
 
+#include <cstring>
+
 extern "C"
 {
 #include "CUUPMeasurement-Container.h"
@@ -28,6 +31,8 @@ extern "C"
 #include "E2SM-KPM-IndicationMessage-Format1.h"
 #include "EPC-CUUP-PM-Format.h"
 #include "EPC-DU-PM-Container.h"
+#include "FGC-DU-PM-Container.h"
+#include "FQIPERSlicesPerPlmnPerCellListItem.h"
 #include "GlobalE2node-ID.h"
 #include "GlobalE2node-eNB-ID.h"
 #include "GlobalE2node-en-gNB-ID.h"
@@ -44,6 +49,7 @@ extern "C"
 #include "RIC-EventTriggerStyle-Item.h"
 #include "RIC-ReportStyle-Item.h"
 #include "ServedPlmnPerCellListItem.h"
+#include "SlicePerPlmnPerCellListItem.h"
 #include "TimeStamp.h"
 }
 
@@ -52,6 +58,39 @@ namespace ns3
 
 NS_LOG_COMPONENT_DEFINE("KpmIndication");
 
+uint64_t
+GetKpmMeasurementGroup(const std::string& measName)
+{
+    static const std::pair<const char*, uint64_t> prefixes[] = {
+        {"QosFlow.PdcpPduVolumeDL", KPM_MEAS_PDCP},
+        {"DRB.PdcpPduNbrDl", KPM_MEAS_PDCP},
+        {"DRB.PdcpSduBitRateDl", KPM_MEAS_PDCP},
+        {"DRB.PdcpSduVolumeDl", KPM_MEAS_PDCP},
+        {"DRB.PdcpSduDelayDl", KPM_MEAS_PDCP},
+        {"Tot.PdcpSduNbrDl", KPM_MEAS_PDCP},
+        {"DRB.EstabSucc", KPM_MEAS_DRB},
+        {"DRB.RelActNbr", KPM_MEAS_DRB},
+        {"HO.SrcCellQual", KPM_MEAS_L3_SINR},
+        {"HO.TrgtCellQual", KPM_MEAS_L3_SINR},
+        {"TB.", KPM_MEAS_TB},
+        {"RRU.PrbUsed", KPM_MEAS_PRB},
+        {"CARR.PDSCHMCSDist", KPM_MEAS_MCS},
+        {"L1M.RS-SINR", KPM_MEAS_SINR_BINS},
+        {"DRB.BufferSize", KPM_MEAS_BUFFER},
+        {"DRB.UEThpDl", KPM_MEAS_THROUGHPUT},
+        {"DRB.MeanActiveUeDl", KPM_MEAS_ACTIVE_UE},
+    };
+
+    for (const auto& [prefix, group] : prefixes)
+    {
+        if (measName.compare(0, strlen(prefix), prefix) == 0)
+        {
+            return group;
+        }
+    }
+    return 0;
+}
+
 KpmIndicationHeader::KpmIndicationHeader(GlobalE2nodeType nodeType,
                                          KpmRicIndicationHeaderValues values)
 {
@@ -190,7 +229,7 @@ KpmIndicationHeader::FillAndEncodeKpmRicIndicationHeader(E2SM_KPM_IndicationHead
 
     ind_header->collectionStartTime = ts->GetValue();
 
-    NS_LOG_INFO(xer_fprint(stderr, &asn_DEF_E2SM_KPM_IndicationHeader_Format1, ind_header));
+    NORI_PDU_DUMP(asn_DEF_E2SM_KPM_IndicationHeader_Format1, ind_header);
 
     descriptor->present = E2SM_KPM_IndicationHeader_PR_indicationHeader_Format1;
     descriptor->choice.indicationHeader_Format1 = ind_header;
@@ -390,6 +429,48 @@ KpmIndicationMessage::FillODuContainer(PF_Container_t* ranContainer, Ptr<ODuCont
             }
 
             sppcl->du_PM_EPC = edpc;
+
+            if (!servedPlmnCell->m_perSliceReportItems.empty())
+            {
+                auto* fgdpc = (FGC_DU_PM_Container_t*)calloc(1, sizeof(FGC_DU_PM_Container_t));
+
+                for (auto perSliceReportItem : servedPlmnCell->m_perSliceReportItems)
+                {
+                    NS_LOG_LOGIC("O-DU: Add Per Slice Report Item");
+                    auto* sppcli = (SlicePerPlmnPerCellListItem_t*)calloc(
+                        1,
+                        sizeof(SlicePerPlmnPerCellListItem_t));
+                    Ptr<OctetString> sst = Create<OctetString>(perSliceReportItem->m_sst, 1);
+                    sppcli->sliceID.sST = sst->GetValue();
+
+                    auto* fqili = (FQIPERSlicesPerPlmnPerCellListItem_t*)calloc(
+                        1,
+                        sizeof(FQIPERSlicesPerPlmnPerCellListItem_t));
+                    fqili->fiveQI = perSliceReportItem->m_fiveQi;
+
+                    NS_ABORT_MSG_IF(
+                        (perSliceReportItem->m_dlPrbUsage < 0) |
+                            (perSliceReportItem->m_dlPrbUsage > 100),
+                        "As per ASN definition, dl_PRBUsage should be between 0 and 100");
+                    long* dlUsedPrbs = (long*)calloc(1, sizeof(long));
+                    *dlUsedPrbs = perSliceReportItem->m_dlPrbUsage;
+                    fqili->dl_PRBUsage = dlUsedPrbs;
+
+                    NS_ABORT_MSG_IF(
+                        (perSliceReportItem->m_ulPrbUsage < 0) |
+                            (perSliceReportItem->m_ulPrbUsage > 100),
+                        "As per ASN definition, ul_PRBUsage should be between 0 and 100");
+                    long* ulUsedPrbs = (long*)calloc(1, sizeof(long));
+                    *ulUsedPrbs = perSliceReportItem->m_ulPrbUsage;
+                    fqili->ul_PRBUsage = ulUsedPrbs;
+
+                    ASN_SEQUENCE_ADD(&sppcli->fQIPERSlicesPerPlmnPerCellList.list, fqili);
+                    ASN_SEQUENCE_ADD(&fgdpc->slicePerPlmnPerCellList.list, sppcli);
+                }
+
+                sppcl->du_PM_5GC = fgdpc;
+            }
+
             ASN_SEQUENCE_ADD(&crrli->servedPlmnPerCellList.list, sppcl);
         }
     }
@@ -401,9 +482,13 @@ void
 KpmIndicationMessage::FillAndEncodeKpmIndicationMessage(E2SM_KPM_IndicationMessage_t* descriptor,
                                                         KpmIndicationMessageValues values)
 {
-    // Create and fill the RAN Container
-    auto* ranContainer = (PF_Container_t*)calloc(1, sizeof(PF_Container_t));
-    FillPmContainer(ranContainer, values.m_pmContainerValues);
+    // Create and fill the RAN Container, left out of the segments after the first one
+    PF_Container_t* ranContainer = nullptr;
+    if (values.m_pmContainerValues)
+    {
+        ranContainer = (PF_Container_t*)calloc(1, sizeof(PF_Container_t));
+        FillPmContainer(ranContainer, values.m_pmContainerValues);
+    }
 
     //------- now fill the message
     auto* containers_list = (PM_Containers_Item_t*)calloc(1, sizeof(PM_Containers_Item_t));
@@ -472,11 +557,28 @@ KpmIndicationMessage::FillAndEncodeKpmIndicationMessage(E2SM_KPM_IndicationMessa
     descriptor->present = E2SM_KPM_IndicationMessage_PR_indicationMessage_Format1;
     descriptor->choice.indicationMessage_Format1 = format;
 
-    NS_LOG_INFO(xer_fprint(stderr, &asn_DEF_E2SM_KPM_IndicationMessage_Format1, format));
+    NORI_PDU_DUMP(asn_DEF_E2SM_KPM_IndicationMessage_Format1, format);
 
     // xer_fprint (stderr, &asn_DEF_PF_Container, ranContainer);
     Encode(descriptor);
 
+    // The measurement items and the UE IDs belong to the values, which can be encoded
+    // again in another segment. Detach them, so that only the message structures are freed.
+    if (format->list_of_PM_Information)
+    {
+        format->list_of_PM_Information->list.count = 0;
+    }
+    if (format->list_of_matched_UEs)
+    {
+        for (int i = 0; i < format->list_of_matched_UEs->list.count; i++)
+        {
+            PerUE_PM_Item_t* perUEItem = format->list_of_matched_UEs->list.array[i];
+            perUEItem->ueId.buf = nullptr;
+            perUEItem->ueId.size = 0;
+            perUEItem->list_of_PM_Information->list.count = 0;
+        }
+    }
+
     free(cellObjectID);
     // free (ranContainer);
     ASN_STRUCT_FREE(asn_DEF_E2SM_KPM_IndicationMessage_Format1, format);
@@ -492,7 +594,14 @@ MeasurementItemList::MeasurementItemList(std::string id)
     m_id = Create<OctetString>(id, id.length());
 }
 
-MeasurementItemList::~MeasurementItemList(){};
+MeasurementItemList::~MeasurementItemList()
+{
+    // The buffer of the ID is borrowed by the KPM messages, see GetId
+    if (m_id != nullptr)
+    {
+        free(m_id->GetPointer()->buf);
+    }
+}
 
 std::vector<Ptr<MeasurementItem>>
 MeasurementItemList::GetItems()
@@ -18,6 +18,7 @@
 #include "ns3/object.h"
 
 #include <set>
+#include <string>
 
 extern "C"
 {
@@ -36,6 +37,40 @@ extern "C"
 namespace ns3
 {
 
+/**
+ * Groups of KPM measurements that a subscription can request in its action
+ * definition. A measurement mask is an OR of these bits, and the measurements
+ * whose group is not in the mask are neither computed nor encoded.
+ */
+enum KpmMeasurementGroup : uint64_t
+{
+    KPM_MEAS_PDCP = 1 << 0,       //!< PDCP volume, PDU count, bitrate and delay
+    KPM_MEAS_DRB = 1 << 1,        //!< DRB establishment and release
+    KPM_MEAS_L3_SINR = 1 << 2,    //!< Serving and neighbour L3 SINR
+    KPM_MEAS_TB = 1 << 3,         //!< MAC transport blocks and modulations
+    KPM_MEAS_PRB = 1 << 4,        //!< PRB usage, per UE, cell and slice
+    KPM_MEAS_MCS = 1 << 5,        //!< MCS distribution
+    KPM_MEAS_SINR_BINS = 1 << 6,  //!< SINR distribution
+    KPM_MEAS_BUFFER = 1 << 7,     //!< RLC buffer occupancy
+    KPM_MEAS_THROUGHPUT = 1 << 8, //!< UE throughput
+    KPM_MEAS_ACTIVE_UE = 1 << 9,  //!< Mean number of active UEs
+    KPM_MEAS_ALL = ~0ULL,         //!< Every measurement
+
+    // Groups carried by each report
+    KPM_MEAS_CU_UP = KPM_MEAS_PDCP,
+    KPM_MEAS_CU_CP = KPM_MEAS_DRB | KPM_MEAS_L3_SINR,
+    KPM_MEAS_DU = KPM_MEAS_TB | KPM_MEAS_PRB | KPM_MEAS_MCS | KPM_MEAS_SINR_BINS |
+                  KPM_MEAS_BUFFER | KPM_MEAS_THROUGHPUT | KPM_MEAS_ACTIVE_UE,
+};
+
+/**
+ * Get the group of a KPM measurement
+ *
+ * @param measName the measurement name, e.g. "RRU.PrbUsedDl.UEID"
+ * @return the group, or 0 if the measurement is not supported
+ */
+uint64_t GetKpmMeasurementGroup(const std::string& measName);
+
 class KpmIndicationHeader : public SimpleRefCount<KpmIndicationHeader>
 {
   public:
@@ -132,6 +167,15 @@ class MeasurementItemList : public SimpleRefCount<MeasurementItemList>
         m_items.push_back(item);
     }
 
+    /**
+     * @brief Add an item of another list, the items are only borrowed by the messages
+     * @param item the item
+     */
+    void AddItem(Ptr<MeasurementItem> item)
+    {
+        m_items.push_back(item);
+    }
+
     std::vector<Ptr<MeasurementItem>> GetItems();
     OCTET_STRING_t GetId();
 };
@@ -185,7 +229,7 @@ class EpcDuPmContainer : public SimpleRefCount<EpcDuPmContainer>
 class FiveGcDuPmContainer : public SimpleRefCount<FiveGcDuPmContainer>
 {
   public:
-    // Snssai m_sliceId; //!< S-NSSAI
+    std::string m_sst; //!< S-NSSAI sST of the monitored slice, 1 byte
     long m_fiveQi;     //!< 5QI value
     long m_dlPrbUsage; //!< Used number of PRBs in an average of DL for the monitored slice during
                        //!< E2 reporting period
@@ -200,6 +244,7 @@ class ServedPlmnPerCell : public SimpleRefCount<ServedPlmnPerCell>
     std::string m_plmId; //!< PLMN identity, octet string, 3 bytes
     uint16_t m_nrCellId;
     std::set<Ptr<EpcDuPmContainer>> m_perQciReportItems;
+    std::set<Ptr<FiveGcDuPmContainer>> m_perSliceReportItems;
 };
 
 class CellResourceReport : public SimpleRefCount<CellResourceReport>
@@ -0,0 +1,77 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "latency-histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+LatencyHistogram::LatencyHistogram()
+    : m_bins(BINS_PER_DECADE * NUM_DECADES + 2, 0)
+{
+}
+
+void
+LatencyHistogram::Add(double latencyMs)
+{
+    size_t bin = 0;
+    if (latencyMs > MIN_MS)
+    {
+        bin = 1 + static_cast<size_t>(std::log10(latencyMs / MIN_MS) * BINS_PER_DECADE);
+        bin = std::min(bin, m_bins.size() - 1);
+    }
+    m_bins[bin]++;
+    m_count++;
+    m_sum += latencyMs;
+    m_max = std::max(m_max, latencyMs);
+}
+
+uint64_t
+LatencyHistogram::GetCount() const
+{
+    return m_count;
+}
+
+double
+LatencyHistogram::GetMean() const
+{
+    return m_count == 0 ? 0 : m_sum / m_count;
+}
+
+double
+LatencyHistogram::GetMax() const
+{
+    return m_max;
+}
+
+double
+LatencyHistogram::GetPercentile(double percentile) const
+{
+    if (m_count == 0)
+    {
+        return 0;
+    }
+
+    auto rank = static_cast<uint64_t>(std::ceil(percentile / 100 * m_count));
+    uint64_t cumulative = 0;
+    for (size_t bin = 0; bin < m_bins.size(); bin++)
+    {
+        cumulative += m_bins[bin];
+        if (cumulative >= std::max<uint64_t>(rank, 1))
+        {
+            if (bin == m_bins.size() - 1)
+            {
+                break;
+            }
+            double upperEdge = MIN_MS * std::pow(10.0, static_cast<double>(bin) / BINS_PER_DECADE);
+            return std::min(upperEdge, m_max);
+        }
+    }
+    return m_max;
+}
+
+} // namespace ns3
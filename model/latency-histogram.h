@@ -0,0 +1,65 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Histogram of latencies with logarithmic bins, for percentile estimates.
+ *
+ * The bins span from 1 us to 100 s, with BINS_PER_DECADE bins per decade, so the
+ * memory used does not grow with the number of samples and the percentiles are
+ * accurate within about 12%.
+ */
+class LatencyHistogram
+{
+  public:
+    static const int BINS_PER_DECADE = 20; //!< Resolution of the histogram
+    static const int NUM_DECADES = 8;      //!< Decades covered, from MIN_MS on
+
+    LatencyHistogram();
+
+    /**
+     * @brief Add a sample
+     * @param latencyMs the latency, in ms
+     */
+    void Add(double latencyMs);
+
+    /**
+     * @return the number of samples
+     */
+    uint64_t GetCount() const;
+
+    /**
+     * @return the mean of the samples, in ms
+     */
+    double GetMean() const;
+
+    /**
+     * @return the largest sample, in ms
+     */
+    double GetMax() const;
+
+    /**
+     * @brief Estimate a percentile as the upper edge of the bin it falls in
+     * @param percentile the percentile, between 0 and 100
+     * @return the latency, in ms, 0 if there are no samples
+     */
+    double GetPercentile(double percentile) const;
+
+  private:
+    static constexpr double MIN_MS = 1e-3; //!< Upper edge of the first bin
+
+    std::vector<uint64_t> m_bins; //!< Sample count per bin, the last one is the overflow
+    uint64_t m_count{0};          //!< Number of samples
+    double m_sum{0};              //!< Sum of the samples, in ms
+    double m_max{0};              //!< Largest sample, in ms
+};
+
+} // namespace ns3
@@ -0,0 +1,320 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "nori-bearer-stats.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("NoriBearerStats");
+NS_OBJECT_ENSURE_REGISTERED(NoriBearerStats);
+
+TypeId
+NoriBearerStats::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::NoriBearerStats")
+            .SetParent<NrBearerStatsBase>()
+            .AddConstructor<NoriBearerStats>()
+            .AddAttribute("Window",
+                          "Length of the windows of the delay and PDU size statistics",
+                          TimeValue(MilliSeconds(250)),
+                          MakeTimeAccessor(&NoriBearerStats::m_window),
+                          MakeTimeChecker(MilliSeconds(1)))
+            .AddAttribute("IdleTimeout",
+                          "Time without PDUs after which the windowed statistics of a bearer "
+                          "are forgotten. Its cumulative counters are kept",
+                          TimeValue(Seconds(5)),
+                          MakeTimeAccessor(&NoriBearerStats::m_idleTimeout),
+                          MakeTimeChecker())
+            .AddAttribute("OutputFilename",
+                          "File where the statistics of each window are written. Empty keeps "
+                          "the statistics in memory only",
+                          StringValue(""),
+                          MakeStringAccessor(&NoriBearerStats::m_outputFilename),
+                          MakeStringChecker());
+    return tid;
+}
+
+NoriBearerStats::NoriBearerStats()
+    : NoriBearerStats("PDCP")
+{
+}
+
+NoriBearerStats::NoriBearerStats(std::string protocolType)
+    : m_protocolType(std::move(protocolType))
+{
+    NS_LOG_FUNCTION(this << m_protocolType);
+}
+
+NoriBearerStats::~NoriBearerStats()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+NoriBearerStats::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_outputFile.is_open())
+    {
+        m_outputFile.close();
+    }
+    m_bearers.clear();
+    m_counters.clear();
+    NrBearerStatsBase::DoDispose();
+}
+
+void
+NoriBearerStats::SampleStats::Add(double value)
+{
+    min = (count == 0) ? value : std::min(min, value);
+    max = (count == 0) ? value : std::max(max, value);
+    count++;
+    sum += value;
+    sumSq += value * value;
+}
+
+double
+NoriBearerStats::SampleStats::GetMean() const
+{
+    return (count == 0) ? 0 : sum / count;
+}
+
+std::vector<double>
+NoriBearerStats::SampleStats::Get() const
+{
+    if (count == 0)
+    {
+        return {0, 0, 0, 0};
+    }
+    double mean = GetMean();
+    double variance = std::max(0.0, sumSq / count - mean * mean);
+    return {mean, std::sqrt(variance), min, max};
+}
+
+uint64_t
+NoriBearerStats::GetKey(uint64_t imsi, uint8_t lcid)
+{
+    // The IMSI has at most 15 digits, i.e. fewer than 50 bits
+    return (imsi << 8) | lcid;
+}
+
+NoriBearerStats::Bearer&
+NoriBearerStats::Update(uint16_t cellId, uint64_t imsi, uint16_t rnti, uint8_t lcid)
+{
+    RollWindow();
+    uint64_t key = GetKey(imsi, lcid);
+    Bearer& bearer = m_bearers[key];
+    if (bearer.counters == nullptr)
+    {
+        // The elements of an unordered_map keep their address across rehashes
+        bearer.counters = &m_counters[key];
+    }
+    bearer.cellId = cellId;
+    bearer.rnti = rnti;
+    bearer.lastActivity = Simulator::Now();
+    return bearer;
+}
+
+const NoriBearerStats::Bearer*
+NoriBearerStats::Find(uint64_t imsi, uint8_t lcid)
+{
+    RollWindow();
+    auto it = m_bearers.find(GetKey(imsi, lcid));
+    return (it == m_bearers.end()) ? nullptr : &it->second;
+}
+
+const NoriBearerStats::Counters*
+NoriBearerStats::FindCounters(uint64_t imsi, uint8_t lcid) const
+{
+    auto it = m_counters.find(GetKey(imsi, lcid));
+    return (it == m_counters.end()) ? nullptr : &it->second;
+}
+
+void
+NoriBearerStats::UlTxPdu(uint16_t cellId,
+                         uint64_t imsi,
+                         uint16_t rnti,
+                         uint8_t lcid,
+                         uint32_t packetSize)
+{
+    Bearer& bearer = Update(cellId, imsi, rnti, lcid);
+    bearer.counters->ulTxPackets++;
+    bearer.counters->ulTxData += packetSize;
+}
+
+void
+NoriBearerStats::UlRxPdu(uint16_t cellId,
+                         uint64_t imsi,
+                         uint16_t rnti,
+                         uint8_t lcid,
+                         uint32_t packetSize,
+                         [[maybe_unused]] uint64_t delay)
+{
+    Bearer& bearer = Update(cellId, imsi, rnti, lcid);
+    bearer.counters->ulRxPackets++;
+    bearer.counters->ulRxData += packetSize;
+}
+
+void
+NoriBearerStats::DlTxPdu(uint16_t cellId,
+                         uint64_t imsi,
+                         uint16_t rnti,
+                         uint8_t lcid,
+                         uint32_t packetSize)
+{
+    Bearer& bearer = Update(cellId, imsi, rnti, lcid);
+    bearer.counters->dlTxPackets++;
+    bearer.counters->dlTxData += packetSize;
+}
+
+void
+NoriBearerStats::DlRxPdu(uint16_t cellId,
+                         uint64_t imsi,
+                         uint16_t rnti,
+                         uint8_t lcid,
+                         uint32_t packetSize,
+                         uint64_t delay)
+{
+    Bearer& bearer = Update(cellId, imsi, rnti, lcid);
+    bearer.counters->dlRxPackets++;
+    bearer.counters->dlRxData += packetSize;
+    bearer.dlDelay.Add(delay);
+    bearer.dlPduSize.Add(packetSize);
+}
+
+uint64_t
+NoriBearerStats::GetDlTxPackets(uint64_t imsi, uint8_t lcid)
+{
+    const Counters* counters = FindCounters(imsi, lcid);
+    return counters ? counters->dlTxPackets : 0;
+}
+
+uint64_t
+NoriBearerStats::GetDlRxPackets(uint64_t imsi, uint8_t lcid)
+{
+    const Counters* counters = FindCounters(imsi, lcid);
+    return counters ? counters->dlRxPackets : 0;
+}
+
+uint64_t
+NoriBearerStats::GetDlTxData(uint64_t imsi, uint8_t lcid)
+{
+    const Counters* counters = FindCounters(imsi, lcid);
+    return counters ? counters->dlTxData : 0;
+}
+
+uint64_t
+NoriBearerStats::GetDlRxData(uint64_t imsi, uint8_t lcid)
+{
+    const Counters* counters = FindCounters(imsi, lcid);
+    return counters ? counters->dlRxData : 0;
+}
+
+uint64_t
+NoriBearerStats::GetUlTxData(uint64_t imsi, uint8_t lcid)
+{
+    const Counters* counters = FindCounters(imsi, lcid);
+    return counters ? counters->ulTxData : 0;
+}
+
+double
+NoriBearerStats::GetDlDelay(uint64_t imsi, uint8_t lcid)
+{
+    const Bearer* bearer = Find(imsi, lcid);
+    return bearer ? bearer->lastDlDelay.GetMean() : 0;
+}
+
+std::vector<double>
+NoriBearerStats::GetDlDelayStats(uint64_t imsi, uint8_t lcid)
+{
+    const Bearer* bearer = Find(imsi, lcid);
+    return bearer ? bearer->lastDlDelay.Get() : SampleStats().Get();
+}
+
+std::vector<double>
+NoriBearerStats::GetDlPduSizeStats(uint64_t imsi, uint8_t lcid)
+{
+    const Bearer* bearer = Find(imsi, lcid);
+    return bearer ? bearer->lastDlPduSize.Get() : SampleStats().Get();
+}
+
+size_t
+NoriBearerStats::GetNBearers() const
+{
+    return m_bearers.size();
+}
+
+void
+NoriBearerStats::RollWindow()
+{
+    Time now = Simulator::Now();
+    if (now < m_windowEnd)
+    {
+        return;
+    }
+
+    // When no PDU was seen for a whole window, the last window is empty
+    bool skipped = now >= m_windowEnd + m_window;
+    Time windowStart = m_windowEnd - m_window;
+
+    if (!m_outputFilename.empty() && !m_outputFile.is_open())
+    {
+        m_outputFile.open(m_outputFilename);
+        NS_ABORT_MSG_UNLESS(m_outputFile.is_open(), "Can't open file " << m_outputFilename);
+        m_outputFile << "% start\tend\tCellId\tIMSI\tRNTI\tLCID\tnTxPDUs\tTxBytes\tnRxPDUs"
+                        "\tRxBytes\tdelay\tstdDev\tmin\tmax\tPduSize\tstdDev\tmin\tmax\tdir\t"
+                     << m_protocolType << "\n";
+    }
+
+    for (auto it = m_bearers.begin(); it != m_bearers.end();)
+    {
+        Bearer& bearer = it->second;
+        if (m_outputFile.is_open() && m_windowEnd.IsStrictlyPositive() &&
+            bearer.lastActivity >= windowStart)
+        {
+            auto delay = bearer.dlDelay.Get();
+            auto size = bearer.dlPduSize.Get();
+            const Counters& counters = *bearer.counters;
+            m_outputFile << windowStart.GetSeconds() << "\t" << m_windowEnd.GetSeconds() << "\t"
+                         << bearer.cellId << "\t" << (it->first >> 8) << "\t" << bearer.rnti
+                         << "\t" << (it->first & 0xff) << "\t" << counters.dlTxPackets << "\t"
+                         << counters.dlTxData << "\t" << counters.dlRxPackets << "\t"
+                         << counters.dlRxData << "\t" << delay[0] * 1e-9 << "\t"
+                         << delay[1] * 1e-9 << "\t" << delay[2] * 1e-9 << "\t"
+                         << delay[3] * 1e-9 << "\t" << size[0] << "\t" << size[1] << "\t"
+                         << size[2] << "\t" << size[3] << "\tDL\n";
+        }
+
+        bearer.lastDlDelay = skipped ? SampleStats() : bearer.dlDelay;
+        bearer.lastDlPduSize = skipped ? SampleStats() : bearer.dlPduSize;
+        bearer.dlDelay = SampleStats();
+        bearer.dlPduSize = SampleStats();
+
+        if (now - bearer.lastActivity > m_idleTimeout)
+        {
+            NS_LOG_DEBUG("Bearer of IMSI " << (it->first >> 8) << " LCID " << (it->first & 0xff)
+                                           << " idle, windowed statistics dropped");
+            it = m_bearers.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+
+    // Windows are aligned on multiples of the window length
+    m_windowEnd = TimeStep((now.GetInteger() / m_window.GetInteger() + 1) * m_window.GetInteger());
+}
+
+} // namespace ns3
@@ -0,0 +1,256 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include "ns3/nr-bearer-stats-base.h"
+#include "ns3/nstime.h"
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief In-memory PDCP or RLC bearer statistics for the E2 reports.
+ *
+ * A drop-in for NrBearerStatsCalculator, fed by NrBearerStatsConnector, that keeps
+ * its state in memory only:
+ * - the packet and byte counters of each bearer are cumulative, so that the
+ *   readers compute their own deltas over their report window;
+ * - the delay and PDU size statistics cover the last complete window of Window;
+ * - the windowed state of the bearers idle for longer than IdleTimeout is
+ *   forgotten, so that it is bounded by the UEs currently active. Their counters
+ *   are kept, so that they never go backwards.
+ *
+ * The windows roll lazily, on the first update or query after they end, so no
+ * event is scheduled. Writing each window to a file is opt-in, see OutputFilename.
+ */
+class NoriBearerStats : public NrBearerStatsBase
+{
+  public:
+    /**
+     * @brief Get the type ID
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    NoriBearerStats();
+
+    /**
+     * @brief Constructor
+     * @param protocolType the protocol name, PDCP or RLC, used in the file output
+     */
+    NoriBearerStats(std::string protocolType);
+
+    ~NoriBearerStats() override;
+
+    void UlTxPdu(uint16_t cellId,
+                 uint64_t imsi,
+                 uint16_t rnti,
+                 uint8_t lcid,
+                 uint32_t packetSize) override;
+    void UlRxPdu(uint16_t cellId,
+                 uint64_t imsi,
+                 uint16_t rnti,
+                 uint8_t lcid,
+                 uint32_t packetSize,
+                 uint64_t delay) override;
+    void DlTxPdu(uint16_t cellId,
+                 uint64_t imsi,
+                 uint16_t rnti,
+                 uint8_t lcid,
+                 uint32_t packetSize) override;
+    void DlRxPdu(uint16_t cellId,
+                 uint64_t imsi,
+                 uint16_t rnti,
+                 uint8_t lcid,
+                 uint32_t packetSize,
+                 uint64_t delay) override;
+
+    /**
+     * @brief Get the number of DL transmitted packets
+     * @param imsi the IMSI of the UE
+     * @param lcid the logical channel
+     * @return the packets transmitted since the first PDU of the bearer
+     */
+    uint64_t GetDlTxPackets(uint64_t imsi, uint8_t lcid);
+
+    /**
+     * @brief Get the number of DL received packets
+     * @param imsi the IMSI of the UE
+     * @param lcid the logical channel
+     * @return the packets received since the first PDU of the bearer
+     */
+    uint64_t GetDlRxPackets(uint64_t imsi, uint8_t lcid);
+
+    /**
+     * @brief Get the DL transmitted data
+     * @param imsi the IMSI of the UE
+     * @param lcid the logical channel
+     * @return the bytes transmitted since the first PDU of the bearer
+     */
+    uint64_t GetDlTxData(uint64_t imsi, uint8_t lcid);
+
+    /**
+     * @brief Get the DL received data
+     * @param imsi the IMSI of the UE
+     * @param lcid the logical channel
+     * @return the bytes received since the first PDU of the bearer
+     */
+    uint64_t GetDlRxData(uint64_t imsi, uint8_t lcid);
+
+    /**
+     * @brief Get the UL transmitted data
+     * @param imsi the IMSI of the UE
+     * @param lcid the logical channel
+     * @return the bytes transmitted since the first PDU of the bearer
+     */
+    uint64_t GetUlTxData(uint64_t imsi, uint8_t lcid);
+
+    /**
+     * @brief Get the mean DL delay over the last window
+     * @param imsi the IMSI of the UE
+     * @param lcid the logical channel
+     * @return the mean delay in ns, 0 without packets
+     */
+    double GetDlDelay(uint64_t imsi, uint8_t lcid);
+
+    /**
+     * @brief Get the DL delay statistics over the last window
+     * @param imsi the IMSI of the UE
+     * @param lcid the logical channel
+     * @return the mean, standard deviation, minimum and maximum delay in ns
+     */
+    std::vector<double> GetDlDelayStats(uint64_t imsi, uint8_t lcid);
+
+    /**
+     * @brief Get the DL PDU size statistics over the last window
+     * @param imsi the IMSI of the UE
+     * @param lcid the logical channel
+     * @return the mean, standard deviation, minimum and maximum size in bytes
+     */
+    std::vector<double> GetDlPduSizeStats(uint64_t imsi, uint8_t lcid);
+
+    /**
+     * @return the number of bearers currently tracked
+     */
+    size_t GetNBearers() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * Running statistics of a sample
+     */
+    struct SampleStats
+    {
+        uint64_t count{0}; //!< Number of samples
+        double sum{0};     //!< Sum of the samples
+        double sumSq{0};   //!< Sum of the squared samples
+        double min{0};     //!< Smallest sample
+        double max{0};     //!< Largest sample
+
+        /**
+         * @brief Add a sample
+         * @param value the sample
+         */
+        void Add(double value);
+
+        /**
+         * @return the mean, 0 without samples
+         */
+        double GetMean() const;
+
+        /**
+         * @return the mean, standard deviation, minimum and maximum
+         */
+        std::vector<double> Get() const;
+    };
+
+    /**
+     * Cumulative counters of a bearer, kept when the bearer goes idle
+     */
+    struct Counters
+    {
+        uint64_t dlTxPackets{0}; //!< DL transmitted packets
+        uint64_t dlTxData{0};    //!< DL transmitted bytes
+        uint64_t dlRxPackets{0}; //!< DL received packets
+        uint64_t dlRxData{0};    //!< DL received bytes
+        uint64_t ulTxPackets{0}; //!< UL transmitted packets
+        uint64_t ulTxData{0};    //!< UL transmitted bytes
+        uint64_t ulRxPackets{0}; //!< UL received packets
+        uint64_t ulRxData{0};    //!< UL received bytes
+    };
+
+    /**
+     * State of an active bearer
+     */
+    struct Bearer
+    {
+        uint16_t cellId{0};          //!< Last serving cell
+        uint16_t rnti{0};            //!< Last RNTI
+        Time lastActivity;           //!< Time of the last PDU
+        Counters* counters{nullptr}; //!< Counters of the bearer, in m_counters
+        SampleStats dlDelay;         //!< DL delay in the current window, ns
+        SampleStats dlPduSize;       //!< DL PDU size in the current window, bytes
+        SampleStats lastDlDelay;     //!< DL delay in the last window, ns
+        SampleStats lastDlPduSize;   //!< DL PDU size in the last window, bytes
+    };
+
+    /**
+     * @brief Get the state of a bearer, creating it on its first PDU
+     * @param cellId the serving cell
+     * @param imsi the IMSI of the UE
+     * @param rnti the RNTI of the UE
+     * @param lcid the logical channel
+     * @return the bearer
+     */
+    Bearer& Update(uint16_t cellId, uint64_t imsi, uint16_t rnti, uint8_t lcid);
+
+    /**
+     * @brief Find the state of an active bearer
+     * @param imsi the IMSI of the UE
+     * @param lcid the logical channel
+     * @return the bearer, nullptr if it is not active
+     */
+    const Bearer* Find(uint64_t imsi, uint8_t lcid);
+
+    /**
+     * @brief Find the counters of a bearer
+     * @param imsi the IMSI of the UE
+     * @param lcid the logical channel
+     * @return the counters, nullptr if the bearer never had a PDU
+     */
+    const Counters* FindCounters(uint64_t imsi, uint8_t lcid) const;
+
+    /**
+     * @brief Close the current window if it ended: write it if requested, make it
+     * the last window and forget the windowed state of the idle bearers
+     */
+    void RollWindow();
+
+    /**
+     * @brief Build the key of a bearer
+     * @param imsi the IMSI of the UE
+     * @param lcid the logical channel
+     * @return the key
+     */
+    static uint64_t GetKey(uint64_t imsi, uint8_t lcid);
+
+    std::string m_protocolType;                        //!< PDCP or RLC
+    Time m_window;                                     //!< Length of a window
+    Time m_idleTimeout;                                //!< Idle time before a bearer is inactive
+    std::string m_outputFilename;                      //!< File receiving the windows, if any
+    std::ofstream m_outputFile;                        //!< Output file, opened on first use
+    Time m_windowEnd;                                  //!< End of the current window
+    std::unordered_map<uint64_t, Bearer> m_bearers;    //!< Active bearers by IMSI and LCID
+    std::unordered_map<uint64_t, Counters> m_counters; //!< Counters by IMSI and LCID
+};
+
+} // namespace ns3
@@ -0,0 +1,134 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+/**
+ * @file
+ * Stable C ABI between NORI and in-process slicing policy plugins.
+ *
+ * A plugin is a shared library exporting nori_policy_abi_version, nori_policy_create,
+ * nori_policy_decide and nori_policy_destroy, with the signatures of the function
+ * pointer types declared at the bottom of this file. Every E2 period, NORI hands the
+ * plugin the same KPIs it would report over KPM and applies the returned PRB quotas
+ * directly to the slicing scheduler, without the RIC round trip.
+ *
+ * Only fixed-width C types are used, so plugins can be built with any compiler and the
+ * layout does not depend on the data model of the platform. Fields are only ever
+ * appended, and NORI_POLICY_ABI_VERSION is increased when that happens. Version 2
+ * replaced the long fields of version 1 with int32_t, and version 1 plugins are refused.
+ */
+
+#ifndef NORI_POLICY_PLUGIN_H
+#define NORI_POLICY_PLUGIN_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define NORI_POLICY_ABI_VERSION 2
+#define NORI_POLICY_ABI_MIN_VERSION 2
+
+#ifdef __cplusplus
+#define NORI_POLICY_STATIC_ASSERT(cond, msg) static_assert(cond, msg)
+#else
+#define NORI_POLICY_STATIC_ASSERT(cond, msg) _Static_assert(cond, msg)
+#endif
+
+    /**
+     * KPIs of a single UE over the last period
+     */
+    typedef struct
+    {
+        uint64_t imsi;           //!< UE IMSI
+        uint16_t rnti;           //!< UE RNTI
+        uint32_t sliceId;        //!< Slice the UE belongs to
+        double dlThroughputKbps; //!< PDCP DL throughput, kbit/s
+        double ulThroughputKbps; //!< PDCP UL throughput, kbit/s
+        double prbUsedDl;        //!< Average number of DL PRBs used
+        double sinrDb;           //!< Last serving cell SINR, dB
+        uint32_t macPdu;         //!< Number of MAC PDUs
+        uint32_t macRetx;        //!< Number of MAC retransmissions
+    } nori_ue_kpi;
+
+    /**
+     * PRB usage of a single slice over the last period
+     */
+    typedef struct
+    {
+        uint32_t sliceId;  //!< Slice index
+        int32_t fiveQi;    //!< 5QI served by the slice
+        double dlPrbUsage; //!< Percentage of the DL resources granted to the slice
+        double ulPrbUsage; //!< Percentage of the UL resources granted to the slice
+    } nori_slice_kpi;
+
+    /**
+     * KPI snapshot of a cell, valid only for the duration of the decide call
+     */
+    typedef struct
+    {
+        uint64_t timestampMs;         //!< Collection time, ms
+        uint16_t cellId;              //!< NR cell ID
+        double periodS;               //!< Length of the period the KPIs refer to, s
+        uint32_t numUes;              //!< Number of entries in ues
+        const nori_ue_kpi* ues;       //!< Per-UE KPIs
+        uint32_t numSlices;           //!< Number of entries in slices
+        const nori_slice_kpi* slices; //!< Per-slice KPIs
+    } nori_kpi_snapshot;
+
+    /**
+     * PRB quota decided by the plugin for a slice, as in the RC RRM policy ratio
+     */
+    typedef struct
+    {
+        uint32_t sliceId;          //!< Slice index
+        int32_t maxPrbRatio;       //!< Maximum PRB percentage
+        int32_t minPrbRatio;       //!< Minimum PRB percentage
+        int32_t dedicatedPrbRatio; //!< Dedicated PRB percentage
+    } nori_slice_quota;
+
+    NORI_POLICY_STATIC_ASSERT(sizeof(nori_ue_kpi) == 56, "nori_ue_kpi layout changed");
+    NORI_POLICY_STATIC_ASSERT(sizeof(nori_slice_kpi) == 24, "nori_slice_kpi layout changed");
+    NORI_POLICY_STATIC_ASSERT(sizeof(void*) != 8 || sizeof(nori_kpi_snapshot) == 56,
+                              "nori_kpi_snapshot layout changed");
+    NORI_POLICY_STATIC_ASSERT(sizeof(nori_slice_quota) == 16, "nori_slice_quota layout changed");
+
+    /**
+     * @return the NORI_POLICY_ABI_VERSION the plugin was built against
+     */
+    typedef uint32_t (*nori_policy_abi_version_fn)(void);
+
+    /**
+     * Create a policy instance for a cell
+     * @param cellId the NR cell ID
+     * @param config opaque configuration string, possibly empty
+     * @return the instance, or NULL on failure
+     */
+    typedef void* (*nori_policy_create_fn)(uint16_t cellId, const char* config);
+
+    /**
+     * Decide the slice quotas for the next period
+     * @param instance the instance returned by nori_policy_create
+     * @param snapshot the KPIs of the last period
+     * @param quotas output array
+     * @param maxQuotas capacity of the output array
+     * @return the number of quotas written, 0 to keep the current configuration
+     */
+    typedef uint32_t (*nori_policy_decide_fn)(void* instance,
+                                              const nori_kpi_snapshot* snapshot,
+                                              nori_slice_quota* quotas,
+                                              uint32_t maxQuotas);
+
+    /**
+     * Release a policy instance
+     * @param instance the instance returned by nori_policy_create
+     */
+    typedef void (*nori_policy_destroy_fn)(void* instance);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NORI_POLICY_PLUGIN_H */
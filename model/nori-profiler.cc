@@ -0,0 +1,57 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "nori-profiler.h"
+
+namespace ns3
+{
+
+void
+NoriProfiler::Add(Stage stage, std::chrono::steady_clock::duration duration)
+{
+    auto ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    auto& counters = m_stages[stage];
+    counters.calls.fetch_add(1, std::memory_order_relaxed);
+    counters.totalNs.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max = counters.maxNs.load(std::memory_order_relaxed);
+    while (ns > max && !counters.maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+void
+NoriProfiler::Print(std::ostream& os) const
+{
+    os << "stage\tcalls\ttotal_ms\tmean_us\tmax_us\n";
+    for (int stage = 0; stage < NUM_STAGES; stage++)
+    {
+        const auto& counters = m_stages[stage];
+        uint64_t calls = counters.calls.load(std::memory_order_relaxed);
+        uint64_t totalNs = counters.totalNs.load(std::memory_order_relaxed);
+        os << GetStageName(static_cast<Stage>(stage)) << "\t" << calls << "\t" << totalNs / 1e6
+           << "\t" << (calls == 0 ? 0 : totalNs / 1e3 / calls) << "\t"
+           << counters.maxNs.load(std::memory_order_relaxed) / 1e3 << "\n";
+    }
+}
+
+const char*
+NoriProfiler::GetStageName(Stage stage)
+{
+    static const char* names[NUM_STAGES] = {"trace-phy",
+                                            "trace-tx-pdu",
+                                            "trace-sinr",
+                                            "snapshot",
+                                            "build-cu-up",
+                                            "build-cu-cp",
+                                            "build-du",
+                                            "encode",
+                                            "send",
+                                            "control-decode",
+                                            "sched-dl",
+                                            "sched-ul"};
+    return names[stage];
+}
+
+} // namespace ns3
@@ -0,0 +1,124 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include "ns3/simple-ref-count.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * Time the rest of the enclosing scope as a NoriProfiler stage. Nothing is measured
+ * when the profiler pointer is null.
+ */
+#define NORI_PROFILE(profiler, stage) ns3::NoriProfiler::Scope noriProfileScope(profiler, stage)
+
+namespace ns3
+{
+
+/**
+ * @brief Wall-clock time spent in each stage of NORI, accumulated per gNB.
+ *
+ * Each stage keeps the number of calls, the total and the largest duration, in
+ * relaxed atomics since some stages run in the e2sim thread.
+ */
+class NoriProfiler : public SimpleRefCount<NoriProfiler>
+{
+  public:
+    /**
+     * Profiled stages
+     */
+    enum Stage
+    {
+        TRACE_PHY = 0,      //!< NoriE2Report::UpdateTraces
+        TRACE_TX_PDU,       //!< E2Interface::ReportTxPDU
+        TRACE_SINR,         //!< E2Interface::RegisterNewSinrReadingCallback
+        SNAPSHOT,           //!< E2Interface::CollectKpiSnapshot
+        BUILD_CU_UP,        //!< CU-UP report builder
+        BUILD_CU_CP,        //!< CU-CP report builder
+        BUILD_DU,           //!< DU report builder
+        ENCODE,             //!< ASN.1 encoding of the KPM messages
+        SEND,               //!< E2AP indication encoding and send
+        CONTROL_DECODE,     //!< Decoding of the RIC control messages
+        SCHED_DL,           //!< DL allocation of the slicing scheduler
+        SCHED_UL,           //!< UL allocation of the slicing scheduler
+        NUM_STAGES,
+    };
+
+    /**
+     * Times a scope, see NORI_PROFILE
+     */
+    class Scope
+    {
+      public:
+        Scope(NoriProfiler* profiler, Stage stage)
+            : m_profiler(profiler),
+              m_stage(stage)
+        {
+            if (m_profiler)
+            {
+                m_start = std::chrono::steady_clock::now();
+            }
+        }
+
+        template <class T>
+        Scope(const T& profiler, Stage stage)
+            : Scope(PeekPointer(profiler), stage)
+        {
+        }
+
+        ~Scope()
+        {
+            if (m_profiler)
+            {
+                m_profiler->Add(m_stage, std::chrono::steady_clock::now() - m_start);
+            }
+        }
+
+      private:
+        NoriProfiler* m_profiler;                      //!< Profiler, may be null
+        Stage m_stage;                                 //!< Stage being timed
+        std::chrono::steady_clock::time_point m_start; //!< Start of the scope
+    };
+
+    /**
+     * @brief Account a call of a stage
+     * @param stage the stage
+     * @param duration the time spent in the call
+     */
+    void Add(Stage stage, std::chrono::steady_clock::duration duration);
+
+    /**
+     * @brief Write one line per stage with the number of calls and the total, mean
+     * and largest duration
+     * @param os the output stream
+     */
+    void Print(std::ostream& os) const;
+
+    /**
+     * @brief Name of a stage, as printed in the summary
+     * @param stage the stage
+     * @return the name
+     */
+    static const char* GetStageName(Stage stage);
+
+  private:
+    /**
+     * Counters of a stage
+     */
+    struct Counters
+    {
+        std::atomic<uint64_t> calls{0};   //!< Number of calls
+        std::atomic<uint64_t> totalNs{0}; //!< Total time, in ns
+        std::atomic<uint64_t> maxNs{0};   //!< Longest call, in ns
+    };
+
+    std::array<Counters, NUM_STAGES> m_stages; //!< Counters of each stage
+};
+
+} // namespace ns3
@@ -6,6 +6,8 @@
 
 #include "ns3/log.h"
 #include "ns3/nr-fh-control.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
 
 #include <algorithm>
 #include <random>
@@ -46,29 +48,51 @@ NrRLMacSchedulerOfdma::GetTypeId()
         //              Vector2DValue(),
         //              MakeUintegerAccessor(&NrRLMacSchedulerOfdma::m_sliceUeRnti),
         //              MakeUintegerChecker<std::vector<uint32_t>>())
-        ;
+                            .AddAttribute("MaxSlices",
+                                          "Number of slices the RIC or a policy plugin may "
+                                          "configure. The quotas of higher slice IDs are "
+                                          "ignored",
+                                          UintegerValue(8),
+                                          MakeUintegerAccessor(&NrRLMacSchedulerOfdma::m_maxSlices),
+                                          MakeUintegerChecker<uint32_t>(1, 256))
+                            .AddTraceSource("SlicingApplied",
+                                            "First DL allocation made with the slicing "
+                                            "parameters last set",
+                                            MakeTraceSourceAccessor(
+                                                &NrRLMacSchedulerOfdma::m_slicingAppliedTrace),
+                                            "ns3::NrRLMacSchedulerOfdma::SlicingAppliedTracedCallback");
     return tid;
 }
 
 NrRLMacSchedulerOfdma::NrRLMacSchedulerOfdma()
-    : NrMacSchedulerOfdmaRR()
+    : NrMacSchedulerOfdmaRR(),
+#ifdef NS3_NORI_SCHED_TRACE
+      m_schedDecisions(4096)
+#else
+      // Nothing is recorded, keep the unused buffer to a single record
+      m_schedDecisions(1)
+#endif
 {
     NS_LOG_FUNCTION(this);
-    // Default values -> SHouldn't be hardcoded
-    m_numberSlices = 2;
-    m_minRbPercSlices = {70, 30};
-    m_dedicatedRbPercSlices = {30, 30};
-    m_maxRbPercSlices = {100, 100};
+    // Default slicing, until the RIC or a policy plugin sets its own
     m_sliceUeRnti = {{1, 2}, {3, 4}};
+    SetSlicingParameters({{0, 100, 70, 30}, {1, 100, 30, 30}});
+    m_slicingPending = false;
 }
 
 NrMacSchedulerNs3::BeamSymbolMap
 NrRLMacSchedulerOfdma::AssignDLRBG(uint32_t symAvail, const ActiveUeMap& activeDl) const
 {
     NS_LOG_FUNCTION(this);
+    NORI_PROFILE(m_profiler, NoriProfiler::SCHED_DL);
 
     NS_LOG_DEBUG("# beams active flows: " << activeDl.size() << ", # sym: " << symAvail);
 
+    if (m_slicingPending.exchange(false))
+    {
+        m_slicingAppliedTrace();
+    }
+
     GetFirst GetBeamId;
     GetSecond GetUeVector;
     BeamSymbolMap symPerBeam = GetSymPerBeam(symAvail, activeDl);
@@ -91,10 +115,9 @@ NrRLMacSchedulerOfdma::AssignDLRBG(uint32_t symAvail, const ActiveUeMap& activeD
                                  : GetBandwidthInRbg();
         uint32_t total_resources = resources;
         NS_ASSERT(resources > 0);
+        m_dlAvailable += static_cast<uint64_t>(total_resources) * beamSym;
 
         // RAN slicing addition
-        uint32_t m_numberSlices = 2;
-
         for (uint16_t sliceIdx = 0; sliceIdx < m_numberSlices; sliceIdx++)
         {
             NS_ASSERT(m_dedicatedRbPercSlices[sliceIdx] <= m_minRbPercSlices[sliceIdx]);
@@ -174,15 +197,12 @@ NrRLMacSchedulerOfdma::AssignDLRBG(uint32_t symAvail, const ActiveUeMap& activeD
 
                         slicesResource -=
                             1; // Resources are RBG, so they do not consider the beamSym
+                        m_dlGrantedPerSlice[sliceIdx] += rbgAssignable;
 
                         if (allocProcess !=
                             0) // If dedicated(allocProcess=0), then do not update the resources yet
                             resources -= 1;
 
-                        // Update metrics
-                        NS_LOG_DEBUG("Assigned " << rbgAssignable << " DL RBG, spanned over "
-                                                 << beamSym << " SYM, to UE "
-                                                 << GetUe(*schedInfoIt)->m_rnti);
                         // Following call to AssignedDlResources would update the
                         // TB size in the NrMacSchedulerUeInfo of this particular UE
                         // according the Rank Indicator reported by it. Only one call
@@ -191,6 +211,16 @@ NrRLMacSchedulerOfdma::AssignDLRBG(uint32_t symAvail, const ActiveUeMap& activeD
                         AssignedDlResources(*schedInfoIt,
                                             FTResources(rbgAssignable, beamSym),
                                             assigned);
+                        NORI_SCHED_TRACE(
+                            m_schedDecisions,
+                            Simulator::Now().GetNanoSeconds(),
+                            GetBeamId(el).GetSector(),
+                            static_cast<uint8_t>(sliceIdx),
+                            GetUe(*schedInfoIt)->m_rnti,
+                            rbgAssignable,
+                            static_cast<uint8_t>(beamSym),
+                            GetUe(*schedInfoIt)->m_dlTbSize,
+                            static_cast<SchedDecisionTrace::Phase>(allocProcess));
                     } while (GetUe(*schedInfoIt)->m_dlTbSize < 10 && slicesResource > 0);
 
                     // Update metrics for the unsuccessful UEs (who did not get any resource in this
@@ -230,18 +260,153 @@ NrRLMacSchedulerOfdma::AssignDLRBG(uint32_t symAvail, const ActiveUeMap& activeD
     return symPerBeam;
 }
 
-void NrRLMacSchedulerOfdma::SetSlicingParameters(const std::vector<RicControlMessage::SlicePRBQuota>& quotas)
+NrMacSchedulerNs3::BeamSymbolMap
+NrRLMacSchedulerOfdma::AssignULRBG(uint32_t symAvail, const ActiveUeMap& activeUl) const
 {
+    NS_LOG_FUNCTION(this);
+    NORI_PROFILE(m_profiler, NoriProfiler::SCHED_UL);
 
-    size_t maxSliceId = 0;
-    for (auto const& q : quotas) {
-        maxSliceId = std::max(maxSliceId, static_cast<size_t>(q.sliceId));
+    BeamSymbolMap symPerBeam = NrMacSchedulerOfdmaRR::AssignULRBG(symAvail, activeUl);
+
+    GetFirst GetBeamId;
+    GetSecond GetUeVector;
+    GetFirst GetUe;
+    for (const auto& el : activeUl)
+    {
+        m_ulAvailable += static_cast<uint64_t>(GetBandwidthInRbg()) * symPerBeam.at(GetBeamId(el));
+        for (const auto& ue : GetUeVector(el))
+        {
+            uint32_t sliceIdx = GetSliceIndex(GetUe(ue)->m_rnti);
+            if (sliceIdx < m_ulGrantedPerSlice.size())
+            {
+                m_ulGrantedPerSlice[sliceIdx] += GetUe(ue)->m_ulRBG;
+            }
+        }
+    }
+    return symPerBeam;
+}
+
+uint32_t
+NrRLMacSchedulerOfdma::GetSliceIndex(uint16_t rnti) const
+{
+    for (uint32_t sliceIdx = 0; sliceIdx < m_sliceUeRnti.size(); sliceIdx++)
+    {
+        for (uint32_t sliceRnti : m_sliceUeRnti[sliceIdx])
+        {
+            if (sliceRnti == rnti)
+            {
+                return sliceIdx;
+            }
+        }
+    }
+    return m_numberSlices;
+}
+
+std::vector<NrRLMacSchedulerOfdma::SlicePrbUsage>
+NrRLMacSchedulerOfdma::GetSlicePrbUsage(SlicePrbBaseline& baseline) const
+{
+    // A slice added since the last read starts from zero
+    baseline.dlGranted.resize(m_numberSlices, 0);
+    baseline.ulGranted.resize(m_numberSlices, 0);
+    uint64_t dlAvailable = m_dlAvailable - baseline.dlAvailable;
+    uint64_t ulAvailable = m_ulAvailable - baseline.ulAvailable;
+
+    std::vector<SlicePrbUsage> usage(m_numberSlices);
+    for (uint32_t sliceIdx = 0; sliceIdx < m_numberSlices; sliceIdx++)
+    {
+        usage[sliceIdx].sliceId = sliceIdx;
+        usage[sliceIdx].fiveQi = GetSliceFiveQi(sliceIdx);
+        // A slice dropped and added again between two reads restarts its counters
+        uint64_t dlGranted = m_dlGrantedPerSlice[sliceIdx] >= baseline.dlGranted[sliceIdx]
+                                 ? m_dlGrantedPerSlice[sliceIdx] - baseline.dlGranted[sliceIdx]
+                                 : m_dlGrantedPerSlice[sliceIdx];
+        uint64_t ulGranted = m_ulGrantedPerSlice[sliceIdx] >= baseline.ulGranted[sliceIdx]
+                                 ? m_ulGrantedPerSlice[sliceIdx] - baseline.ulGranted[sliceIdx]
+                                 : m_ulGrantedPerSlice[sliceIdx];
+        if (dlAvailable > 0)
+        {
+            usage[sliceIdx].dlPrbUsage = std::min(100.0, dlGranted * 100.0 / dlAvailable);
+        }
+        if (ulAvailable > 0)
+        {
+            usage[sliceIdx].ulPrbUsage = std::min(100.0, ulGranted * 100.0 / ulAvailable);
+        }
+    }
+
+    baseline.dlGranted = m_dlGrantedPerSlice;
+    baseline.ulGranted = m_ulGrantedPerSlice;
+    baseline.dlAvailable = m_dlAvailable;
+    baseline.ulAvailable = m_ulAvailable;
+    return usage;
+}
+
+void
+NrRLMacSchedulerOfdma::DumpSchedDecisions(const std::string& fileName) const
+{
+    NS_LOG_FUNCTION(this << fileName);
+#ifdef NS3_NORI_SCHED_TRACE
+    std::ofstream out(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    NS_ABORT_MSG_IF(!out.is_open(), "Can't open file " << fileName);
+    m_schedDecisions.Dump(out);
+#else
+    NS_LOG_WARN("Scheduler decisions are not recorded, build with NS3_NORI_SCHED_TRACE");
+#endif
+}
+
+void
+NrRLMacSchedulerOfdma::SetSchedDecisionStreamFile(const std::string& fileName)
+{
+    NS_LOG_FUNCTION(this << fileName);
+#ifdef NS3_NORI_SCHED_TRACE
+    m_schedDecisions.SetStreamFile(fileName);
+#else
+    NS_LOG_WARN("Scheduler decisions are not recorded, build with NS3_NORI_SCHED_TRACE");
+#endif
+}
+
+void
+NrRLMacSchedulerOfdma::SetProfiler(Ptr<NoriProfiler> profiler)
+{
+    m_profiler = profiler;
+}
+
+int32_t
+NrRLMacSchedulerOfdma::GetSliceFiveQi(uint32_t sliceId)
+{
+    switch (sliceId)
+    {
+    case 2: // URLLC, delay critical GBR
+        return 82;
+    case 4: // V2X messages
+        return 79;
+    default: // eMBB and the other service types, default non-GBR
+        return 9;
     }
-    m_dedicatedRbPercSlices.resize(maxSliceId+1);
-    m_minRbPercSlices      .resize(maxSliceId+1);
-    m_maxRbPercSlices      .resize(maxSliceId+1);
+}
 
+void NrRLMacSchedulerOfdma::SetSlicingParameters(const std::vector<RicControlMessage::SlicePRBQuota>& quotas)
+{
+    NS_LOG_FUNCTION(this << quotas.size());
+
+    // Slices are only ever added, the ones not named keep their quotas and their UEs
     for (auto const& q : quotas) {
+        if (q.sliceId >= m_maxSlices)
+        {
+            NS_LOG_WARN("Ignoring the quotas of slice " << q.sliceId << ", MaxSlices is "
+                                                        << m_maxSlices);
+            continue;
+        }
+        if (q.sliceId >= m_numberSlices)
+        {
+            m_numberSlices = q.sliceId + 1;
+            m_dedicatedRbPercSlices.resize(m_numberSlices, 0);
+            m_minRbPercSlices      .resize(m_numberSlices, 0);
+            m_maxRbPercSlices      .resize(m_numberSlices, 0);
+            m_sliceUeRnti          .resize(m_numberSlices);
+            m_dlGrantedPerSlice    .resize(m_numberSlices, 0);
+            m_ulGrantedPerSlice    .resize(m_numberSlices, 0);
+        }
+
         NS_LOG_INFO("Setting slicing parameters for slice " << q.sliceId
                     << ": " << q.dedicatePRBRatio << "% dedicated, "
                     << q.minPRBRatio      << "% min, "
@@ -254,6 +419,7 @@ void NrRLMacSchedulerOfdma::SetSlicingParameters(const std::vector<RicControlMes
         m_minRbPercSlices      [q.sliceId] = minPRB;
         m_maxRbPercSlices      [q.sliceId] = maxPRB;
     }
+    m_slicingPending = true;
 }
 
 } // namespace ns3
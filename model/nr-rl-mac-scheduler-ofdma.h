@@ -6,8 +6,12 @@
 
 #include "ns3/nr-mac-scheduler-ofdma-rr.h"
 #include "ns3/nr-mac-scheduler-ofdma.h"
+#include "ns3/nori-profiler.h"
 #include "ns3/ric-control-message.h"
-#include "ns3/traced-value.h"
+#include "ns3/sched-decision-trace.h"
+#include "ns3/traced-callback.h"
+
+#include <atomic>
 
 namespace ns3
 {
@@ -21,6 +25,29 @@ namespace ns3
 class NrRLMacSchedulerOfdma : public NrMacSchedulerOfdmaRR
 {
   public:
+    /**
+     * @brief Resources granted to a slice during the current reporting window
+     */
+    struct SlicePrbUsage
+    {
+        uint32_t sliceId = 0;  //!< Slice index, reported as S-NSSAI sST
+        int32_t fiveQi = 0;    //!< 5QI of the traffic served by the slice
+        double dlPrbUsage = 0; //!< Percentage of the DL resources granted to the slice
+        double ulPrbUsage = 0; //!< Percentage of the UL resources granted to the slice
+    };
+
+    /**
+     * @brief Counters a consumer of the slice PRB usage last read. The scheduler
+     * counters only grow, so every consumer computes its window from its own baseline
+     */
+    struct SlicePrbBaseline
+    {
+        std::vector<uint64_t> dlGranted; //!< DL RBG-symbols granted per slice
+        std::vector<uint64_t> ulGranted; //!< UL RBG-symbols granted per slice
+        uint64_t dlAvailable = 0;        //!< DL RBG-symbols offered to the scheduler
+        uint64_t ulAvailable = 0;        //!< UL RBG-symbols offered to the scheduler
+    };
+
     /**
      * @brief GetTypeIdNrRLMacSchedulerOfdma
      * @return The TypeId of the class
@@ -48,20 +75,94 @@ class NrRLMacSchedulerOfdma : public NrMacSchedulerOfdmaRR
      * 
      *  - Maximum physical resource block per slice
      * 
+     * Only the slices named in the quotas are updated. The slices go from 0 to the
+     * highest slice ID ever configured, and never shrink, so that a slice keeps its UEs.
+     * The quotas of slice IDs not below MaxSlices are ignored. To be called by the
+     * simulator thread only.
+     *
      * @param slicePRBQuota The slice PRB quota
      */
     void SetSlicingParameters(const std::vector<RicControlMessage::SlicePRBQuota>& quotas);
 
+    /**
+     * TracedCallback signature for the first DL allocation made with new slicing
+     * parameters
+     */
+    typedef void (*SlicingAppliedTracedCallback)();
+
+    /**
+     * @brief Get the per-slice PRB usage accumulated since the baseline, and move the
+     * baseline to the current counters.
+     *
+     * The usage is the share of the RBG-symbols offered to the scheduler that were
+     * granted to the UEs of each slice.
+     *
+     * @param baseline the counters the consumer last read, updated
+     * @return one entry for each configured slice
+     */
+    std::vector<SlicePrbUsage> GetSlicePrbUsage(SlicePrbBaseline& baseline) const;
+
+    /**
+     * @brief Get the slice index a UE belongs to
+     * @param rnti the UE RNTI
+     * @return the slice index, or the number of slices if the UE is not assigned to any slice
+     */
+    uint32_t GetSliceIndex(uint16_t rnti) const;
+
+    /**
+     * @brief Write the scheduler decisions held in the ring buffer, oldest first.
+     *
+     * Decisions are only recorded when the module is built with NS3_NORI_SCHED_TRACE.
+     *
+     * @param fileName the binary output file name
+     */
+    void DumpSchedDecisions(const std::string& fileName) const;
+
+    /**
+     * @brief Stream every scheduler decision to a binary file
+     * @param fileName the binary output file name
+     */
+    void SetSchedDecisionStreamFile(const std::string& fileName);
+
+    /**
+     * @brief Time the allocations in a profiler
+     * @param profiler the profiler of the gNB, nullptr to stop profiling
+     */
+    void SetProfiler(Ptr<NoriProfiler> profiler);
+
   protected:
     BeamSymbolMap AssignDLRBG(uint32_t symAvail, const ActiveUeMap& activeDl) const override;
 
+    BeamSymbolMap AssignULRBG(uint32_t symAvail, const ActiveUeMap& activeUl) const override;
+
   private:
-    uint32_t m_numberSlices; //!< Number of slices
+    /**
+     * @brief Get the 5QI reported for a slice. The slice ID is the SST of its S-NSSAI,
+     * the slice is reported with the standardized 5QI of its service type, TS 23.501
+     * 5.15.2.2, and with the default 5QI 9 for the other SSTs
+     * @param sliceId the slice ID
+     * @return the 5QI
+     */
+    static int32_t GetSliceFiveQi(uint32_t sliceId);
+
+    uint32_t m_numberSlices{0}; //!< Number of slices
+    uint32_t m_maxSlices{8};    //!< Number of slices that may be configured
     std::vector<uint32_t> m_dedicatedRbPercSlices; //!< Dedicated RB percentage per slice
     std::vector<uint32_t> m_minRbPercSlices; //!< Minimum RB percentage per slice
     std::vector<uint32_t> m_maxRbPercSlices; //!< Maximum RB percentage per slice
     std::vector<std::vector<uint32_t>> m_sliceUeRnti; //!< UE RNTI per slice
 
-    TracedValue<uint32_t> m_tracedValueSymPerBeam;
+    mutable std::vector<uint64_t> m_dlGrantedPerSlice; //!< DL RBG-symbols granted per slice, ever
+    mutable std::vector<uint64_t> m_ulGrantedPerSlice; //!< UL RBG-symbols granted per slice, ever
+    mutable uint64_t m_dlAvailable{0}; //!< DL RBG-symbols offered to the scheduler
+    mutable uint64_t m_ulAvailable{0}; //!< UL RBG-symbols offered to the scheduler
+
+    mutable std::atomic<bool> m_slicingPending{false}; //!< New slicing parameters not used yet
+    TracedCallback<> m_slicingAppliedTrace;            //!< First DL allocation with new parameters
+    Ptr<NoriProfiler> m_profiler;                      //!< Profiler of the gNB, may be null
+
+    // Always declared, so that the class layout does not depend on NS3_NORI_SCHED_TRACE
+    // in the translation units that include this header. Only the recording is compiled out.
+    mutable SchedDecisionTrace m_schedDecisions; //!< Ring buffer of per-slot decisions
 };
 } // namespace ns3
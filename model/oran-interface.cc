@@ -17,18 +17,29 @@
 
 #include "asn1c-types.h"
 #include "encode_e2apv1.hpp"
+#include "pdu-dump.h"
 #include "ric-control-message.h"
 
 #include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
 
 #include <thread>
 
 extern "C"
 {
+#include "E2AP-PDU.h"
+#include "E2SM-KPM-ActionDefinition-Format1.h"
+#include "E2SM-KPM-ActionDefinition.h"
+#include "E2SM-KPM-EventTriggerDefinition.h"
 #include "InitiatingMessage.h"
+#include "MeasurementInfoItem.h"
 #include "ProtocolIE-Field.h"
 #include "RICactionType.h"
+#include "RICcontrolRequest.h"
 #include "RICsubscriptionRequest.h"
+#include "Trigger-ConditionIE-Item.h"
 }
 
 namespace ns3
@@ -42,7 +53,26 @@ TypeId
 E2Termination::GetTypeId()
 {
     static TypeId tid =
-        TypeId("ns3::E2Termination").SetParent<Object>().AddConstructor<E2Termination>();
+        TypeId("ns3::E2Termination")
+            .SetParent<Object>()
+            .AddConstructor<E2Termination>()
+            .AddAttribute("ShmName",
+                          "Prefix of the shared memory rings used to talk to a local agent "
+                          "instead of the RIC. The rings are <prefix>-ind and <prefix>-ctrl. "
+                          "If empty, e2sim is used",
+                          StringValue(""),
+                          MakeStringAccessor(&E2Termination::m_shmName),
+                          MakeStringChecker())
+            .AddAttribute("ShmCapacity",
+                          "Capacity of each shared memory ring, in bytes",
+                          UintegerValue(4 << 20),
+                          MakeUintegerAccessor(&E2Termination::m_shmCapacity),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("ShmPollInterval",
+                          "Simulation time between two polls of the control ring",
+                          TimeValue(MilliSeconds(1)),
+                          MakeTimeAccessor(&E2Termination::m_shmPollInterval),
+                          MakeTimeChecker());
     return tid;
 }
 
@@ -86,6 +116,7 @@ E2Termination::RegisterKpmCallbackToE2Sm(long ranFunctionId,
 {
     RegisterFunctionDescToE2Sm(ranFunctionId, ranFunctionDescription);
     m_e2sim->register_subscription_callback(ranFunctionId, sbCb);
+    m_subscriptionCallbacks[ranFunctionId] = sbCb;
 }
 
 void
@@ -95,6 +126,7 @@ E2Termination::RegisterSmCallbackToE2Sm(long ranFunctionId,
 {
     RegisterFunctionDescToE2Sm(ranFunctionId, ranFunctionDescription);
     m_e2sim->register_sm_callback(ranFunctionId, smCb);
+    m_smCallbacks[ranFunctionId] = smCb;
 }
 
 void
@@ -102,6 +134,21 @@ E2Termination::Start()
 {
     NS_LOG_FUNCTION(this);
 
+    if (IsRecording())
+    {
+        NS_LOG_INFO("GNB " << m_gnbId << " recording to " << m_recordLog->GetFileName());
+        return;
+    }
+
+    if (IsShmTransport())
+    {
+        m_indicationRing = Create<ShmRing>(m_shmName + "-ind", m_shmCapacity);
+        m_controlRing = Create<ShmRing>(m_shmName + "-ctrl", m_shmCapacity);
+        NS_LOG_INFO("GNB " << m_gnbId << " using shared memory rings " << m_shmName);
+        Simulator::Schedule(m_shmPollInterval, &E2Termination::PollControlRing, this);
+        return;
+    }
+
     NS_ABORT_MSG_IF(m_ricAddress.empty(), "Set the RIC information first");
 
     // create a thread to host e2sim execution
@@ -139,58 +186,40 @@ E2Termination::~E2Termination()
     delete m_e2sim;
 }
 
-E2Termination::RicSubscriptionRequest_rval_s
+E2Termination::RicSubscriptionRequest_s
 E2Termination::ProcessRicSubscriptionRequest(E2AP_PDU_t* sub_req_pdu)
 {
-    // Intro params
-    RicSubscriptionRequest_rval_s reqParams;
+    RicSubscriptionRequest_s request;
 
     // Record RIC Request ID
     // Go through RIC action to be Setup List
-    // Find first entry with REPORT action Type
-    // Record ricActionID
-    // Encode subscription response
-
-    RICsubscriptionRequest_t orig_req =
+    // Accept every REPORT and INSERT action, reject the others
+    const RICsubscriptionRequest_t& orig_req =
         sub_req_pdu->choice.initiatingMessage->value.choice.RICsubscriptionRequest;
 
-    // RICsubscriptionResponse_IEs_t *ricreqid = (RICsubscriptionResponse_IEs_t*)calloc(1,
-    // sizeof(RICsubscriptionResponse_IEs_t));
-
     int count = orig_req.protocolIEs.list.count;
-    int size = orig_req.protocolIEs.list.size;
-
     auto** ies = (RICsubscriptionRequest_IEs_t**)orig_req.protocolIEs.list.array;
-
     NS_LOG_DEBUG("Number of IEs " << count);
-    NS_LOG_DEBUG("Size of IEs " << size);
-
-    RICsubscriptionRequest_IEs__value_PR pres;
 
-    uint16_t reqRequestorId{};
-    uint16_t reqInstanceId{};
     uint16_t ranFuncionId{};
-    uint8_t reqActionId{};
-
-    std::vector<long> actionIdsAccept;
-    std::vector<long> actionIdsReject;
+    uint32_t reportPeriodMs{0};
+    const RICactions_ToBeSetup_List_t* actionList = nullptr;
 
     // iterate over the IEs
     for (int i = 0; i < count; i++)
     {
         RICsubscriptionRequest_IEs_t* next_ie = ies[i];
-        pres = next_ie->value.present; // value of the current IE
 
-        switch (pres)
+        switch (next_ie->value.present)
         {
         // IE containing the RIC Request ID
         case RICsubscriptionRequest_IEs__value_PR_RICrequestID: {
             NS_LOG_DEBUG("Processing RIC Request ID field");
-            RICrequestID_t reqId = next_ie->value.choice.RICrequestID;
-            reqRequestorId = reqId.ricRequestorID;
-            reqInstanceId = reqId.ricInstanceID;
-            NS_LOG_DEBUG("RIC Requestor ID " << reqRequestorId);
-            NS_LOG_DEBUG("RIC Instance ID " << reqInstanceId);
+            const RICrequestID_t& reqId = next_ie->value.choice.RICrequestID;
+            request.requestorId = reqId.ricRequestorID;
+            request.instanceId = reqId.ricInstanceID;
+            NS_LOG_DEBUG("RIC Requestor ID " << request.requestorId);
+            NS_LOG_DEBUG("RIC Instance ID " << request.instanceId);
             break;
         }
         // IE containing the RAN Function ID
@@ -202,53 +231,15 @@ E2Termination::ProcessRicSubscriptionRequest(E2AP_PDU_t* sub_req_pdu)
         }
         case RICsubscriptionRequest_IEs__value_PR_RICsubscriptionDetails: {
             NS_LOG_DEBUG("Processing RIC Subscription Details field");
-            RICsubscriptionDetails_t subDetails = next_ie->value.choice.RICsubscriptionDetails;
+            const RICsubscriptionDetails_t& subDetails =
+                next_ie->value.choice.RICsubscriptionDetails;
 
             // RIC Event Trigger Definition
-            RICeventTriggerDefinition_t triggerDef = subDetails.ricEventTriggerDefinition;
-
-            // TODO How to decode this field?
-            uint8_t size = 20;
-            auto* buf = (uint8_t*)calloc(1, size);
-            memcpy(buf, &triggerDef, size);
-            NS_LOG_DEBUG("RIC Event Trigger Definition " << std::to_string(*buf));
-
-            // Sequence of actions
-            RICactions_ToBeSetup_List_t actionList = subDetails.ricAction_ToBeSetup_List;
-            // TODO We are ignoring the trigger definition
+            reportPeriodMs = DecodeReportPeriod(subDetails.ricEventTriggerDefinition);
+            NS_LOG_DEBUG("Report period " << reportPeriodMs << " ms");
 
-            int actionCount = actionList.list.count;
-            NS_LOG_DEBUG("Number of actions " << actionCount);
-
-            auto** item_array = actionList.list.array;
-            bool foundAction = false;
-
-            for (int i = 0; i < actionCount; i++)
-            {
-                auto* next_item = item_array[i];
-                RICactionID_t actionId = ((RICaction_ToBeSetup_ItemIEs*)next_item)
-                                             ->value.choice.RICaction_ToBeSetup_Item.ricActionID;
-                RICactionType_t actionType =
-                    ((RICaction_ToBeSetup_ItemIEs*)next_item)
-                        ->value.choice.RICaction_ToBeSetup_Item.ricActionType;
-
-                // We identify the first action whose type is REPORT or INSERT
-                // That is the only one accepted; all others are rejected
-                if (!foundAction &&
-                    (actionType == RICactionType_report || actionType == RICactionType_insert))
-                {
-                    reqActionId = actionId;
-                    actionIdsAccept.push_back(reqActionId);
-                    NS_LOG_DEBUG("Action ID " << actionId << " accepted");
-                    foundAction = true;
-                }
-                else
-                {
-                    // reqActionId = actionId;
-                    // NS_LOG_DEBUG("Policy Action ID " << actionId << " processed");
-                    // actionIdsReject.push_back(reqActionId);
-                }
-            }
+            // Sequence of actions, processed once all the IEs are known
+            actionList = &subDetails.ricAction_ToBeSetup_List;
             break;
         }
         default: {
@@ -258,35 +249,376 @@ E2Termination::ProcessRicSubscriptionRequest(E2AP_PDU_t* sub_req_pdu)
         }
     }
 
+    if (actionList == nullptr)
+    {
+        NS_LOG_WARN("RIC Subscription Request without subscription details");
+        return request;
+    }
+
+    int actionCount = actionList->list.count;
+    NS_LOG_DEBUG("Number of actions " << actionCount);
+    request.actions.reserve(actionCount);
+    for (int i = 0; i < actionCount; i++)
+    {
+        const RICaction_ToBeSetup_Item_t& item =
+            ((RICaction_ToBeSetup_ItemIEs*)actionList->list.array[i])
+                ->value.choice.RICaction_ToBeSetup_Item;
+
+        // Every REPORT or INSERT action sets up its own report stream
+        if (item.ricActionType == RICactionType_report ||
+            item.ricActionType == RICactionType_insert)
+        {
+            RicSubscriptionRequest_rval_s action;
+            action.requestorId = request.requestorId;
+            action.instanceId = request.instanceId;
+            action.ranFuncionId = ranFuncionId;
+            action.actionId = item.ricActionID;
+            action.reportPeriodMs = reportPeriodMs;
+            action.measurementMask = DecodeMeasurementMask(item.ricActionDefinition);
+            request.actions.push_back(action);
+            NS_LOG_DEBUG("Action ID " << item.ricActionID << " accepted");
+        }
+        else
+        {
+            request.rejectedActionIds.push_back(item.ricActionID);
+            NS_LOG_DEBUG("Action ID " << item.ricActionID << " of type " << item.ricActionType
+                                      << " rejected");
+        }
+    }
+    return request;
+}
+
+bool
+E2Termination::SendRicSubscriptionResponse(const RicSubscriptionRequest_s& request)
+{
     NS_LOG_DEBUG("Create RIC Subscription Response");
-    auto* e2ap_pdu = (E2AP_PDU*)calloc(1, sizeof(E2AP_PDU));
-    long* accept_array = &actionIdsAccept[0];
-    long* reject_array = &actionIdsReject[0];
-    int accept_size = actionIdsAccept.size();
-    int reject_size = actionIdsReject.size();
-
-    encoding::generate_e2apv1_subscription_response_success(e2ap_pdu,
-                                                            accept_array,
-                                                            reject_array,
-                                                            accept_size,
-                                                            reject_size,
-                                                            reqRequestorId,
-                                                            reqInstanceId);
+    std::vector<long> accepted;
+    accepted.reserve(request.actions.size());
+    for (const auto& action : request.actions)
+    {
+        accepted.push_back(action.actionId);
+    }
+    std::vector<long> rejected = request.rejectedActionIds;
+
+    E2AP_PDU e2ap_pdu{};
+    encoding::generate_e2apv1_subscription_response_success(&e2ap_pdu,
+                                                            accepted.data(),
+                                                            rejected.data(),
+                                                            accepted.size(),
+                                                            rejected.size(),
+                                                            request.requestorId,
+                                                            request.instanceId);
 
     NS_LOG_DEBUG("Send RIC Subscription Response");
-    m_e2sim->encode_and_send_sctp_data(e2ap_pdu);
+    return SendE2Message(&e2ap_pdu);
+}
+
+uint64_t
+E2Termination::DecodeMeasurementMask(const RICactionDefinition_t* actionDef)
+{
+    if (actionDef == nullptr)
+    {
+        return KPM_MEAS_ALL;
+    }
+
+    E2SM_KPM_ActionDefinition_t* kpmActionDef = nullptr;
+    asn_dec_rval_t rval = asn_decode(nullptr,
+                                     ATS_ALIGNED_BASIC_PER,
+                                     &asn_DEF_E2SM_KPM_ActionDefinition,
+                                     (void**)&kpmActionDef,
+                                     actionDef->buf,
+                                     actionDef->size);
+
+    uint64_t mask = 0;
+    if (rval.code == RC_OK &&
+        kpmActionDef->actionDefinition_formats.present ==
+            E2SM_KPM_ActionDefinition__actionDefinition_formats_PR_actionDefinition_Format1)
+    {
+        auto& measList =
+            kpmActionDef->actionDefinition_formats.choice.actionDefinition_Format1->measInfoList
+                .list;
+        for (int i = 0; i < measList.count; i++)
+        {
+            const auto& measType = measList.array[i]->measType;
+            if (measType.present != MeasurementType_PR_measName)
+            {
+                continue;
+            }
+            std::string name((const char*)measType.choice.measName.buf,
+                             measType.choice.measName.size);
+            uint64_t group = GetKpmMeasurementGroup(name);
+            NS_LOG_DEBUG("Requested measurement " << name << ", group " << group);
+            if (group == 0)
+            {
+                NS_LOG_WARN("Measurement " << name << " is not supported");
+            }
+            mask |= group;
+        }
+    }
+    else
+    {
+        NS_LOG_WARN("Can't decode the KPM action definition, reporting every measurement");
+    }
 
-    reqParams.requestorId = reqRequestorId;
-    reqParams.instanceId = reqInstanceId;
-    reqParams.ranFuncionId = ranFuncionId;
-    reqParams.actionId = reqActionId;
-    return reqParams;
+    ASN_STRUCT_FREE(asn_DEF_E2SM_KPM_ActionDefinition, kpmActionDef);
+    return mask != 0 ? mask : KPM_MEAS_ALL;
 }
 
-void
+uint32_t
+E2Termination::DecodeReportPeriod(const RICeventTriggerDefinition_t& triggerDef)
+{
+    // Values of RT-Period-IE, in ms
+    static const uint32_t rtPeriodsMs[] = {10,   20,   32,   40,   60,   64,   70,
+                                           80,   128,  160,  256,  320,  512,  640,
+                                           1024, 1280, 2048, 2560, 5120, 10240};
+
+    E2SM_KPM_EventTriggerDefinition_t* eventTrigger = nullptr;
+    asn_dec_rval_t rval = asn_decode(nullptr,
+                                     ATS_ALIGNED_BASIC_PER,
+                                     &asn_DEF_E2SM_KPM_EventTriggerDefinition,
+                                     (void**)&eventTrigger,
+                                     triggerDef.buf,
+                                     triggerDef.size);
+
+    uint32_t periodMs = 0;
+    if (rval.code == RC_OK &&
+        eventTrigger->present == E2SM_KPM_EventTriggerDefinition_PR_eventDefinition_Format1 &&
+        eventTrigger->choice.eventDefinition_Format1.policyTest_List != nullptr)
+    {
+        // All the trigger conditions of NORI are periodic, use the shortest period
+        auto& conditions = eventTrigger->choice.eventDefinition_Format1.policyTest_List->list;
+        for (int i = 0; i < conditions.count; i++)
+        {
+            long period = conditions.array[i]->report_Period_IE;
+            if (period >= 0 && period < (long)(sizeof(rtPeriodsMs) / sizeof(rtPeriodsMs[0])) &&
+                (periodMs == 0 || rtPeriodsMs[period] < periodMs))
+            {
+                periodMs = rtPeriodsMs[period];
+            }
+        }
+    }
+    else
+    {
+        NS_LOG_WARN("Can't decode the report period of the event trigger definition");
+    }
+
+    ASN_STRUCT_FREE(asn_DEF_E2SM_KPM_EventTriggerDefinition, eventTrigger);
+    return periodMs;
+}
+
+bool
 E2Termination::SendE2Message(E2AP_PDU* pdu)
 {
-    m_e2sim->encode_and_send_sctp_data(pdu);
+    NORI_PDU_DUMP(asn_DEF_E2AP_PDU, pdu);
+    if (m_recordLog)
+    {
+        E2RecordLog::FrameHeader frame{};
+        frame.cellId = m_recordCellId;
+        frame.simTimeNs = Simulator::Now().GetNanoSeconds();
+        return RecordPdu(pdu, frame);
+    }
+
+    if (!m_indicationRing)
+    {
+        m_e2sim->encode_and_send_sctp_data(pdu);
+        return true;
+    }
+
+    ssize_t encoded = EncodePdu(pdu);
+    if (encoded < 0)
+    {
+        return false;
+    }
+    bool written = m_indicationRing->Write(ShmRing::E2AP_PDU, m_encodeBuffer.data(), encoded);
+    if (!written)
+    {
+        NS_LOG_WARN("Indication ring full, E2AP PDU dropped");
+    }
+    return written;
+}
+
+bool
+E2Termination::SendRicIndication(E2AP_PDU* pdu,
+                                 const RicSubscriptionRequest_rval_s& params,
+                                 uint32_t sequenceNumber)
+{
+    if (!m_recordLog)
+    {
+        return SendE2Message(pdu);
+    }
+
+    NORI_PDU_DUMP(asn_DEF_E2AP_PDU, pdu);
+    E2RecordLog::FrameHeader frame{};
+    frame.cellId = m_recordCellId;
+    frame.ranFunctionId = params.ranFuncionId;
+    frame.simTimeNs = Simulator::Now().GetNanoSeconds();
+    frame.requestorId = params.requestorId;
+    frame.instanceId = params.instanceId;
+    frame.sequenceNumber = sequenceNumber;
+    frame.actionId = params.actionId;
+    return RecordPdu(pdu, frame);
+}
+
+bool
+E2Termination::RecordPdu(E2AP_PDU* pdu, const E2RecordLog::FrameHeader& frame)
+{
+    ssize_t encoded = EncodePdu(pdu);
+    if (encoded < 0)
+    {
+        return false;
+    }
+    m_recordLog->Append(frame, m_encodeBuffer.data(), encoded);
+    return true;
+}
+
+ssize_t
+E2Termination::EncodePdu(E2AP_PDU* pdu)
+{
+    // Encoded in a buffer kept across messages, grown when a PDU does not fit
+    if (m_encodeBuffer.empty())
+    {
+        m_encodeBuffer.resize(16384);
+    }
+    asn_enc_rval_t encoded = asn_encode_to_buffer(nullptr,
+                                                  ATS_ALIGNED_BASIC_PER,
+                                                  &asn_DEF_E2AP_PDU,
+                                                  pdu,
+                                                  m_encodeBuffer.data(),
+                                                  m_encodeBuffer.size());
+    if (encoded.encoded > (ssize_t)m_encodeBuffer.size())
+    {
+        m_encodeBuffer.resize(encoded.encoded);
+        encoded = asn_encode_to_buffer(nullptr,
+                                       ATS_ALIGNED_BASIC_PER,
+                                       &asn_DEF_E2AP_PDU,
+                                       pdu,
+                                       m_encodeBuffer.data(),
+                                       m_encodeBuffer.size());
+    }
+    ASN_STRUCT_FREE_CONTENTS_ONLY(asn_DEF_E2AP_PDU, pdu);
+    if (encoded.encoded < 0)
+    {
+        NS_LOG_ERROR("Error during the encoding of the E2AP PDU, failed type "
+                     << encoded.failed_type->name);
+    }
+    return encoded.encoded;
+}
+
+void
+E2Termination::SetRecordLog(Ptr<E2RecordLog> log, uint16_t cellId)
+{
+    NS_LOG_FUNCTION(this << cellId);
+    m_recordLog = log;
+    m_recordCellId = cellId;
+}
+
+bool
+E2Termination::IsRecording() const
+{
+    return m_recordLog != nullptr;
+}
+
+double
+E2Termination::GetOutboundBacklog() const
+{
+    return m_indicationRing ? m_indicationRing->GetOccupancy() : 0;
+}
+
+bool
+E2Termination::SendKpiSnapshot(const nori_kpi_snapshot& snapshot)
+{
+    NS_ABORT_MSG_UNLESS(m_indicationRing, "Raw KPI snapshots need the shared memory transport");
+
+    size_t uesSize = snapshot.numUes * sizeof(nori_ue_kpi);
+    size_t slicesSize = snapshot.numSlices * sizeof(nori_slice_kpi);
+    m_shmBuffer.resize(sizeof(snapshot) + uesSize + slicesSize);
+    memcpy(m_shmBuffer.data(), &snapshot, sizeof(snapshot));
+    memcpy(m_shmBuffer.data() + sizeof(snapshot), snapshot.ues, uesSize);
+    memcpy(m_shmBuffer.data() + sizeof(snapshot) + uesSize, snapshot.slices, slicesSize);
+    return m_indicationRing->Write(ShmRing::KPI_SNAPSHOT, m_shmBuffer.data(), m_shmBuffer.size());
+}
+
+bool
+E2Termination::IsShmTransport() const
+{
+    return !m_shmName.empty();
+}
+
+void
+E2Termination::PollControlRing()
+{
+    ProcessControlRing();
+    Simulator::Schedule(m_shmPollInterval, &E2Termination::PollControlRing, this);
+}
+
+void
+E2Termination::ProcessControlRing()
+{
+    uint16_t type;
+    while (m_controlRing->Read(type, m_shmBuffer))
+    {
+        if (type != ShmRing::E2AP_PDU)
+        {
+            NS_LOG_WARN("Ignoring control record of type " << type);
+            continue;
+        }
+
+        E2AP_PDU_t* pdu = nullptr;
+        asn_dec_rval_t rval = asn_decode(nullptr,
+                                         ATS_ALIGNED_BASIC_PER,
+                                         &asn_DEF_E2AP_PDU,
+                                         (void**)&pdu,
+                                         m_shmBuffer.data(),
+                                         m_shmBuffer.size());
+        if (rval.code != RC_OK || pdu->present != E2AP_PDU_PR_initiatingMessage)
+        {
+            NS_LOG_ERROR("Dropping malformed control record of " << m_shmBuffer.size()
+                                                                 << " bytes");
+            ASN_STRUCT_FREE(asn_DEF_E2AP_PDU, pdu);
+            continue;
+        }
+
+        // Same dispatch as e2sim: subscriptions and controls go to the callback of
+        // the RAN function they address
+        auto& value = pdu->choice.initiatingMessage->value;
+        if (value.present == InitiatingMessage__value_PR_RICsubscriptionRequest)
+        {
+            auto& ies = value.choice.RICsubscriptionRequest.protocolIEs.list;
+            for (int i = 0; i < ies.count; i++)
+            {
+                auto& ie = ies.array[i]->value;
+                if (ie.present == RICsubscriptionRequest_IEs__value_PR_RANfunctionID)
+                {
+                    auto cb = m_subscriptionCallbacks.find(ie.choice.RANfunctionID);
+                    if (cb != m_subscriptionCallbacks.end())
+                    {
+                        cb->second(pdu);
+                    }
+                }
+            }
+        }
+        else if (value.present == InitiatingMessage__value_PR_RICcontrolRequest)
+        {
+            auto& ies = value.choice.RICcontrolRequest.protocolIEs.list;
+            for (int i = 0; i < ies.count; i++)
+            {
+                auto& ie = ies.array[i]->value;
+                if (ie.present == RICcontrolRequest_IEs__value_PR_RANfunctionID)
+                {
+                    auto cb = m_smCallbacks.find(ie.choice.RANfunctionID);
+                    if (cb != m_smCallbacks.end())
+                    {
+                        cb->second(pdu);
+                    }
+                }
+            }
+        }
+        else
+        {
+            NS_LOG_WARN("Ignoring control PDU of type " << value.present);
+        }
+        ASN_STRUCT_FREE(asn_DEF_E2AP_PDU, pdu);
+    }
 }
 
 } // namespace ns3
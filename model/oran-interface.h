@@ -15,14 +15,20 @@
 
 #pragma once
 
+#include "e2-record-log.h"
 #include "e2sim.hpp"
 #include "kpm-function-description.h"
 #include "kpm-indication.h"
+#include "nori-policy-plugin.h"
 #include "ric-control-function-description.h"
 #include "ric-control-message.h"
+#include "shm-ring.h"
 
+#include "ns3/nstime.h"
 #include "ns3/object.h"
 
+#include <map>
+
 namespace ns3
 {
 
@@ -57,9 +63,26 @@ class E2Termination : public Object
      * Start the E2 termination.
      * Create a separate thread to host the execution of e2sim. The thread will
      * execute the method DoStart.
+     * If the ShmName attribute is set, e2sim is not started: the indication and
+     * control rings are created instead, and the control ring is polled.
+     * If a record log is set, nothing is started: the messages are only recorded.
      */
     void Start();
 
+    /**
+     * Record the encoded messages to a log instead of sending them, to run without
+     * a RIC. Must be called before Start.
+     *
+     * @param log the log, possibly shared with other E2 terminations
+     * @param cellId the cell ID written in the frames
+     */
+    void SetRecordLog(Ptr<E2RecordLog> log, uint16_t cellId);
+
+    /**
+     * @return true if the messages are recorded instead of being sent
+     */
+    bool IsRecording() const;
+
     /**
      * Register an E2 Service Model.
      * Create a RAN Function Description item containing the configurations
@@ -105,31 +128,136 @@ class E2Termination : public Object
      */
     struct RicSubscriptionRequest_rval_s
     {
-        uint16_t requestorId;  //!< RIC Requestor ID
-        uint16_t instanceId;   //!< RIC Instance ID
-        uint16_t ranFuncionId; //!< RAN Function ID
-        uint8_t actionId;      //!< RIC Action ID
+        uint16_t requestorId;     //!< RIC Requestor ID
+        uint16_t instanceId;      //!< RIC Instance ID
+        uint16_t ranFuncionId;    //!< RAN Function ID
+        uint8_t actionId;         //!< RIC Action ID
+        uint32_t reportPeriodMs;  //!< Report period from the event trigger, 0 if absent
+        uint64_t measurementMask; //!< KpmMeasurementGroup bits requested by the action
+    };
+
+    /**
+     * Struct holding a RIC Subscription Request, split in the actions it sets up
+     */
+    struct RicSubscriptionRequest_s
+    {
+        uint16_t requestorId{0};                            //!< RIC Requestor ID
+        uint16_t instanceId{0};                             //!< RIC Instance ID
+        std::vector<RicSubscriptionRequest_rval_s> actions; //!< Accepted REPORT/INSERT actions
+        std::vector<long> rejectedActionIds;                //!< Actions of other types
     };
 
     /**
      * Process RIC Subscription Request.
-     * This function processes the RIC Subscription Request and sends the
-     * RIC Subscription Response.
+     * This function only decodes the request: every REPORT or INSERT action is
+     * accepted, the others are rejected, and the response is left to
+     * SendRicSubscriptionResponse. The PDU is not referenced afterwards.
      *
      * @param sub_req_pdu request message
      * @return RIC subscription request parameters
      */
-    RicSubscriptionRequest_rval_s ProcessRicSubscriptionRequest(E2AP_PDU_t* sub_req_pdu);
+    RicSubscriptionRequest_s ProcessRicSubscriptionRequest(E2AP_PDU_t* sub_req_pdu);
+
+    /**
+     * Send the RIC Subscription Response of a request
+     *
+     * @param request the request, as returned by ProcessRicSubscriptionRequest
+     * @return false if the message could not be encoded or queued
+     */
+    bool SendRicSubscriptionResponse(const RicSubscriptionRequest_s& request);
 
     /**
      * Sends an E2 message to the RIC
-     * This function encodes and sends an E2 message to the RIC
+     * This function encodes and sends an E2 message to the RIC. As e2sim does, the
+     * contents of the PDU are released once encoded, the caller only releases the
+     * top-level structure.
      *
      * @param pdu the PDU of the message
+     * @return false if the message could not be encoded or queued
+     */
+    bool SendE2Message(E2AP_PDU* pdu);
+
+    /**
+     * Sends a RIC Indication to the RIC, as SendE2Message. When recording, the
+     * subscription and the sequence number are written in the frame.
+     *
+     * @param pdu the PDU of the indication
+     * @param params the subscription the indication belongs to
+     * @param sequenceNumber the RIC indication sequence number
+     * @return false if the message could not be encoded or queued
+     */
+    bool SendRicIndication(E2AP_PDU* pdu,
+                           const RicSubscriptionRequest_rval_s& params,
+                           uint32_t sequenceNumber);
+
+    /**
+     * Sends a raw KPI snapshot to a local agent through the indication ring.
+     * The record holds the nori_kpi_snapshot, whose pointers are meaningless for
+     * the agent, followed by the UE array and the slice array.
+     *
+     * @param snapshot the KPI snapshot
+     * @return false if the ring is full
+     */
+    bool SendKpiSnapshot(const nori_kpi_snapshot& snapshot);
+
+    /**
+     * @brief Get the depth of the outbound queue
+     * @return the fraction of the indication ring waiting for the agent, 0 with e2sim,
+     * whose socket buffer is not visible (a full buffer shows as a slow SendE2Message)
+     */
+    double GetOutboundBacklog() const;
+
+    /**
+     * @return true if the messages go through shared memory instead of e2sim
+     */
+    bool IsShmTransport() const;
+
+    /**
+     * Decode the E2AP PDUs written by the local agent in the control ring and
+     * dispatch them to the callbacks registered for their RAN function, as e2sim
+     * does for the PDUs received from the RIC.
      */
-    void SendE2Message(E2AP_PDU* pdu);
+    void ProcessControlRing();
 
   private:
+    /**
+     * Encode a PDU in m_encodeBuffer and release its contents
+     *
+     * @param pdu the PDU
+     * @return the encoded size, negative on error
+     */
+    ssize_t EncodePdu(E2AP_PDU* pdu);
+
+    /**
+     * Encode a PDU and append it to the record log
+     *
+     * @param pdu the PDU
+     * @param frame the frame header, without the size
+     * @return false if the message could not be encoded
+     */
+    bool RecordPdu(E2AP_PDU* pdu, const E2RecordLog::FrameHeader& frame);
+
+    /**
+     * Process the control ring and reschedule.
+     */
+    void PollControlRing();
+
+    /**
+     * Decode the report period of an E2SM-KPM event trigger definition
+     *
+     * @param triggerDef the event trigger definition
+     * @return the period, in ms, or 0 if it can't be decoded
+     */
+    static uint32_t DecodeReportPeriod(const RICeventTriggerDefinition_t& triggerDef);
+
+    /**
+     * Decode the measurements requested by an E2SM-KPM action definition
+     *
+     * @param actionDef the action definition, possibly null
+     * @return the mask of KpmMeasurementGroup, KPM_MEAS_ALL if no measurement is listed
+     */
+    static uint64_t DecodeMeasurementMask(const RICactionDefinition_t* actionDef);
+
     /**
      * Run the e2sim main loop.
      * Starts the e2sim main loop, it will open a socket towards the RIC and
@@ -154,5 +282,17 @@ class E2Termination : public Object
     std::string m_gnbId;      //!< GNB id
     std::string m_plmnId;     //!< PLMN Id
     Ptr<RicControlMessage> m_ricControlMessage; //! RAN control message handler
+
+    std::string m_shmName;               //!< Prefix of the shared memory rings, empty for e2sim
+    uint32_t m_shmCapacity;              //!< Capacity of each ring, in bytes
+    Time m_shmPollInterval;              //!< Control ring polling interval
+    Ptr<ShmRing> m_indicationRing;       //!< Ring from the simulator to the agent
+    Ptr<ShmRing> m_controlRing;          //!< Ring from the agent to the simulator
+    std::vector<uint8_t> m_shmBuffer;    //!< Record buffer, reused across messages
+    std::vector<uint8_t> m_encodeBuffer; //!< E2AP encoding buffer, reused across messages
+    Ptr<E2RecordLog> m_recordLog;        //!< Log of the recorded messages, if recording
+    uint16_t m_recordCellId{0};          //!< Cell ID written in the recorded frames
+    std::map<long, SubscriptionCallback> m_subscriptionCallbacks; //!< Per RAN function
+    std::map<long, SmCallback> m_smCallbacks;                     //!< Per RAN function
 };
 } // namespace ns3
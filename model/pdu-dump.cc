@@ -0,0 +1,196 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "pdu-dump.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <chrono>
+
+extern "C"
+{
+#include <xer_encoder.h>
+}
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("PduDump");
+
+std::atomic<bool> PduDump::s_enabled{false};
+
+PduDump&
+PduDump::Get()
+{
+    static PduDump instance;
+    return instance;
+}
+
+PduDump::~PduDump()
+{
+    Disable();
+}
+
+void
+PduDump::EnableFile(const std::string& fileName)
+{
+    NS_LOG_FUNCTION(fileName);
+    auto& dump = Get();
+    std::lock_guard<std::mutex> lock(dump.m_mutex);
+    NS_ABORT_MSG_IF(dump.m_writer.joinable(), "PDU dumps already go to a file");
+    dump.m_file.open(fileName);
+    NS_ABORT_MSG_UNLESS(dump.m_file.is_open(), "Can't open file " << fileName);
+    dump.m_stopWriter = false;
+    dump.m_writer = std::thread(&PduDump::WriterLoop, &dump);
+    dump.UpdateEnabled();
+}
+
+void
+PduDump::EnableRing(size_t capacity)
+{
+    NS_LOG_FUNCTION(capacity);
+    auto& dump = Get();
+    std::lock_guard<std::mutex> lock(dump.m_mutex);
+    dump.m_ringCapacity = capacity;
+    while (dump.m_ring.size() > capacity)
+    {
+        dump.m_ring.pop_front();
+    }
+    dump.UpdateEnabled();
+}
+
+void
+PduDump::Disable()
+{
+    auto& dump = Get();
+    {
+        std::lock_guard<std::mutex> lock(dump.m_mutex);
+        dump.m_ringCapacity = 0;
+        dump.m_stopWriter = true;
+        dump.UpdateEnabled();
+    }
+    dump.m_cv.notify_one();
+    if (dump.m_writer.joinable())
+    {
+        dump.m_writer.join();
+    }
+
+    std::lock_guard<std::mutex> lock(dump.m_mutex);
+    if (dump.m_file.is_open())
+    {
+        if (dump.m_dropped > 0)
+        {
+            dump.m_file << "<!-- " << dump.m_dropped << " dumps dropped -->\n";
+        }
+        dump.m_file.close();
+    }
+    dump.m_dropped = 0;
+}
+
+void
+PduDump::UpdateEnabled()
+{
+    s_enabled.store((m_writer.joinable() && !m_stopWriter) || m_ringCapacity > 0,
+                    std::memory_order_relaxed);
+}
+
+/**
+ * Append the XER output of asn1c to a string
+ * @param buffer the output chunk
+ * @param size its size
+ * @param appKey the string
+ * @return 0 to continue
+ */
+static int
+AppendToString(const void* buffer, size_t size, void* appKey)
+{
+    static_cast<std::string*>(appKey)->append(static_cast<const char*>(buffer), size);
+    return 0;
+}
+
+void
+PduDump::Dump(const asn_TYPE_descriptor_s* type, const void* structure)
+{
+    auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+    std::string entry =
+        "<!-- " + std::to_string(now.count()) + " us " + std::string(type->name) + " -->\n";
+    // The serialization happens here, the structure may be released as soon as the
+    // caller goes on
+    asn_enc_rval_t rval = xer_encode(type, structure, XER_F_BASIC, AppendToString, &entry);
+    if (rval.encoded < 0)
+    {
+        entry += "<!-- XER encoding failed -->\n";
+    }
+
+    auto& dump = Get();
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(dump.m_mutex);
+        if (dump.m_writer.joinable() && !dump.m_stopWriter)
+        {
+            if (dump.m_queue.size() < MAX_PENDING)
+            {
+                dump.m_queue.push_back(dump.m_ringCapacity > 0 ? entry : std::move(entry));
+                notify = true;
+            }
+            else
+            {
+                dump.m_dropped++;
+            }
+        }
+        if (dump.m_ringCapacity > 0)
+        {
+            if (dump.m_ring.size() == dump.m_ringCapacity)
+            {
+                dump.m_ring.pop_front();
+            }
+            dump.m_ring.push_back(std::move(entry));
+        }
+    }
+    if (notify)
+    {
+        dump.m_cv.notify_one();
+    }
+}
+
+void
+PduDump::PrintRing(std::ostream& os)
+{
+    auto& dump = Get();
+    std::lock_guard<std::mutex> lock(dump.m_mutex);
+    for (const auto& entry : dump.m_ring)
+    {
+        os << entry;
+    }
+}
+
+void
+PduDump::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_cv.wait(lock, [this] { return m_stopWriter || !m_queue.empty(); });
+        if (m_queue.empty())
+        {
+            // Stopped and flushed
+            break;
+        }
+        std::deque<std::string> batch;
+        batch.swap(m_queue);
+
+        // Written without the lock, so that the callers are never blocked by the disk
+        lock.unlock();
+        for (const auto& entry : batch)
+        {
+            m_file << entry;
+        }
+        m_file.flush();
+        lock.lock();
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,123 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+extern "C"
+{
+    struct asn_TYPE_descriptor_s;
+}
+
+/**
+ * Dump an asn1c structure in XER if PDU dumping is enabled. When it is not, only an
+ * atomic flag is read and the structure is not touched.
+ */
+#define NORI_PDU_DUMP(type, structure)                                                         \
+    do                                                                                         \
+    {                                                                                          \
+        if (ns3::PduDump::IsEnabled())                                                         \
+        {                                                                                      \
+            ns3::PduDump::Dump(&(type), structure);                                            \
+        }                                                                                      \
+    } while (false)
+
+namespace ns3
+{
+
+/**
+ * @brief XER dumps of the E2AP and E2SM PDUs, for debugging.
+ *
+ * The dumps are disabled by default and do not depend on the log levels. When
+ * enabled, each PDU is serialized in memory by the thread handling it and the
+ * result goes to a file, written by a background thread, and/or to an in-memory
+ * ring of the most recent dumps. The facility is shared by all the E2 nodes of the
+ * process.
+ */
+class PduDump
+{
+  public:
+    /**
+     * @return whether any sink is enabled
+     */
+    static bool IsEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Write the dumps to a file, from a background thread. Dumps are dropped
+     * rather than blocking the caller when the writer falls behind.
+     * @param fileName the file name
+     */
+    static void EnableFile(const std::string& fileName);
+
+    /**
+     * @brief Keep the most recent dumps in memory
+     * @param capacity the number of dumps kept
+     */
+    static void EnableRing(size_t capacity);
+
+    /**
+     * @brief Stop dumping, flush and close the file
+     */
+    static void Disable();
+
+    /**
+     * @brief Serialize a structure in XER and hand it to the sinks
+     * @param type the asn1c type descriptor
+     * @param structure the structure
+     */
+    static void Dump(const asn_TYPE_descriptor_s* type, const void* structure);
+
+    /**
+     * @brief Write the dumps held by the ring, oldest first
+     * @param os the output stream
+     */
+    static void PrintRing(std::ostream& os);
+
+  private:
+    PduDump() = default;
+    ~PduDump();
+
+    /**
+     * @return the process-wide instance
+     */
+    static PduDump& Get();
+
+    /**
+     * @brief Body of the file writer thread
+     */
+    void WriterLoop();
+
+    /**
+     * @brief Update the enabled flag after a sink changed, with m_mutex held
+     */
+    void UpdateEnabled();
+
+    static const size_t MAX_PENDING = 4096; //!< Dumps waiting for the writer
+
+    static std::atomic<bool> s_enabled; //!< Whether any sink is enabled
+
+    std::mutex m_mutex;               //!< Protects the members below
+    std::condition_variable m_cv;     //!< Signals the writer
+    std::ofstream m_file;             //!< File sink
+    std::thread m_writer;             //!< File writer thread
+    bool m_stopWriter{false};         //!< Whether the writer must exit
+    std::deque<std::string> m_queue;  //!< Dumps waiting for the writer
+    uint64_t m_dropped{0};            //!< Dumps dropped because the writer fell behind
+    size_t m_ringCapacity{0};         //!< Dumps kept in memory, 0 if disabled
+    std::deque<std::string> m_ring;   //!< Most recent dumps
+};
+
+} // namespace ns3
@@ -0,0 +1,76 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "policy-plugin.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <dlfcn.h>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("PolicyPlugin");
+
+PolicyPlugin::PolicyPlugin(const std::string& path, uint16_t cellId, const std::string& config)
+    : m_quotas(MAX_QUOTAS)
+{
+    NS_LOG_FUNCTION(this << path << cellId);
+
+    m_handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    NS_ABORT_MSG_IF(m_handle == nullptr, "Can't load policy plugin " << path << ": " << dlerror());
+
+    auto abiVersion =
+        reinterpret_cast<nori_policy_abi_version_fn>(dlsym(m_handle, "nori_policy_abi_version"));
+    auto create = reinterpret_cast<nori_policy_create_fn>(dlsym(m_handle, "nori_policy_create"));
+    m_decide = reinterpret_cast<nori_policy_decide_fn>(dlsym(m_handle, "nori_policy_decide"));
+    m_destroy = reinterpret_cast<nori_policy_destroy_fn>(dlsym(m_handle, "nori_policy_destroy"));
+    NS_ABORT_MSG_IF(!abiVersion || !create || !m_decide || !m_destroy,
+                    "Policy plugin " << path << " does not export the NORI policy ABI");
+    NS_ABORT_MSG_IF(abiVersion() < NORI_POLICY_ABI_MIN_VERSION ||
+                        abiVersion() > NORI_POLICY_ABI_VERSION,
+                    "Policy plugin " << path << " was built against ABI version " << abiVersion()
+                                     << ", NORI supports " << NORI_POLICY_ABI_MIN_VERSION
+                                     << " to " << NORI_POLICY_ABI_VERSION);
+
+    m_instance = create(cellId, config.c_str());
+    NS_ABORT_MSG_IF(m_instance == nullptr,
+                    "Policy plugin " << path << " failed to create an instance for cell "
+                                     << cellId);
+}
+
+PolicyPlugin::~PolicyPlugin()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_instance != nullptr)
+    {
+        m_destroy(m_instance);
+    }
+    if (m_handle != nullptr)
+    {
+        dlclose(m_handle);
+    }
+}
+
+std::vector<RicControlMessage::SlicePRBQuota>
+PolicyPlugin::Decide(const nori_kpi_snapshot& snapshot)
+{
+    uint32_t count = m_decide(m_instance, &snapshot, m_quotas.data(), MAX_QUOTAS);
+    NS_ABORT_MSG_IF(count > MAX_QUOTAS, "Policy plugin returned more quotas than allowed");
+
+    std::vector<RicControlMessage::SlicePRBQuota> quotas;
+    quotas.reserve(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const auto& q = m_quotas[i];
+        NS_LOG_DEBUG("Plugin quota for slice " << q.sliceId << ": " << q.dedicatedPrbRatio
+                                               << "% dedicated, " << q.minPrbRatio << "% min, "
+                                               << q.maxPrbRatio << "% max");
+        quotas.push_back({q.sliceId, q.maxPrbRatio, q.minPrbRatio, q.dedicatedPrbRatio});
+    }
+    return quotas;
+}
+
+} // namespace ns3
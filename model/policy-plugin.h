@@ -0,0 +1,55 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include "nori-policy-plugin.h"
+#include "ric-control-message.h"
+
+#include "ns3/object.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Loader of an in-process slicing policy plugin.
+ *
+ * Opens a shared library implementing the C ABI of nori-policy-plugin.h and
+ * creates one policy instance for the cell. The library is closed when the
+ * object is destroyed.
+ */
+class PolicyPlugin : public SimpleRefCount<PolicyPlugin>
+{
+  public:
+    /**
+     * @brief Load the plugin and create the policy instance
+     * @param path path of the shared library
+     * @param cellId the NR cell ID
+     * @param config opaque configuration string passed to the plugin
+     */
+    PolicyPlugin(const std::string& path, uint16_t cellId, const std::string& config);
+
+    ~PolicyPlugin();
+
+    /**
+     * @brief Ask the plugin for the slice quotas of the next period
+     * @param snapshot the KPIs of the last period
+     * @return the quotas to apply, empty to keep the current configuration
+     */
+    std::vector<RicControlMessage::SlicePRBQuota> Decide(const nori_kpi_snapshot& snapshot);
+
+  private:
+    static const uint32_t MAX_QUOTAS = 64; //!< Maximum number of quotas returned per call
+
+    void* m_handle{nullptr};   //!< dlopen handle
+    void* m_instance{nullptr}; //!< Policy instance
+    nori_policy_decide_fn m_decide{nullptr};
+    nori_policy_destroy_fn m_destroy{nullptr};
+    std::vector<nori_slice_quota> m_quotas; //!< Output buffer, reused across calls
+};
+
+} // namespace ns3
@@ -16,6 +16,7 @@
 #include "ric-control-message.h"
 
 #include "asn1c-types.h"
+#include "pdu-dump.h"
 
 #include "ns3/log.h"
 
@@ -34,9 +35,75 @@ namespace ns3
 
 NS_LOG_COMPONENT_DEFINE("RicControlMessage");
 
+RicControlDecoder::RicControlDecoder()
+{
+    m_header = (E2SM_RC_ControlHeader_t*)calloc(1, sizeof(E2SM_RC_ControlHeader_t));
+    m_message = (E2SM_RC_ControlMessage_t*)calloc(1, sizeof(E2SM_RC_ControlMessage_t));
+}
+
+RicControlDecoder::~RicControlDecoder()
+{
+    ASN_STRUCT_FREE(asn_DEF_E2SM_RC_ControlHeader, m_header);
+    ASN_STRUCT_FREE(asn_DEF_E2SM_RC_ControlMessage, m_message);
+}
+
+E2SM_RC_ControlHeader_t*
+RicControlDecoder::DecodeHeader(const RICcontrolHeader_t& header)
+{
+    // Decoding into the existing structure keeps its allocation, whatever was
+    // allocated inside it by a previous decoding is released first
+    ASN_STRUCT_RESET(asn_DEF_E2SM_RC_ControlHeader, m_header);
+    asn_dec_rval_t rval = asn_decode(nullptr,
+                                     ATS_ALIGNED_BASIC_PER,
+                                     &asn_DEF_E2SM_RC_ControlHeader,
+                                     (void**)&m_header,
+                                     header.buf,
+                                     header.size);
+    if (rval.code != RC_OK)
+    {
+        NS_LOG_ERROR("[E2SM] Error decoding the E2SM RC Control Header");
+        ASN_STRUCT_RESET(asn_DEF_E2SM_RC_ControlHeader, m_header);
+        return nullptr;
+    }
+    return m_header;
+}
+
+E2SM_RC_ControlMessage_t*
+RicControlDecoder::DecodeMessage(const RICcontrolMessage_t& message)
+{
+    ASN_STRUCT_RESET(asn_DEF_E2SM_RC_ControlMessage, m_message);
+    asn_dec_rval_t rval = asn_decode(nullptr,
+                                     ATS_ALIGNED_BASIC_PER,
+                                     &asn_DEF_E2SM_RC_ControlMessage,
+                                     (void**)&m_message,
+                                     message.buf,
+                                     message.size);
+    if (rval.code != RC_OK)
+    {
+        NS_LOG_ERROR("[E2SM] Error decoding the E2SM RC Control Message");
+        ASN_STRUCT_RESET(asn_DEF_E2SM_RC_ControlMessage, m_message);
+        return nullptr;
+    }
+    return m_message;
+}
+
+void
+RicControlDecoder::Reset()
+{
+    ASN_STRUCT_RESET(asn_DEF_E2SM_RC_ControlHeader, m_header);
+    ASN_STRUCT_RESET(asn_DEF_E2SM_RC_ControlMessage, m_message);
+}
+
 RicControlMessage::RicControlMessage(E2AP_PDU_t* pdu)
 {
-    DecodeRicControlMessage(pdu);
+    RicControlDecoder decoder;
+    DecodeRicControlMessage(pdu, decoder);
+    NS_LOG_INFO("End of RicControlMessage::RicControlMessage()");
+}
+
+RicControlMessage::RicControlMessage(E2AP_PDU_t* pdu, RicControlDecoder& decoder)
+{
+    DecodeRicControlMessage(pdu, decoder);
     NS_LOG_INFO("End of RicControlMessage::RicControlMessage()");
 }
 
@@ -45,11 +112,11 @@ RicControlMessage::~RicControlMessage()
 }
 
 void
-RicControlMessage::DecodeRicControlMessage(E2AP_PDU_t* pdu)
+RicControlMessage::DecodeRicControlMessage(E2AP_PDU_t* pdu, RicControlDecoder& decoder)
 {
     InitiatingMessage_t* mess = pdu->choice.initiatingMessage;
     auto* request = (RICcontrolRequest_t*)&mess->value.choice.RICcontrolRequest;
-    NS_LOG_INFO(xer_fprint(stderr, &asn_DEF_RICcontrolRequest, request));
+    NORI_PDU_DUMP(asn_DEF_RICcontrolRequest, request);
 
     size_t count = request->protocolIEs.list.count;
     if (count <= 0)
@@ -83,6 +150,11 @@ RicControlMessage::DecodeRicControlMessage(E2AP_PDU_t* pdu)
                 m_requestType = ControlMessageRequestIdType::RAN_SLICING;
                 break;
             }
+            case 1004: {
+                NS_LOG_DEBUG("No-op acknowledgement");
+                m_requestType = ControlMessageRequestIdType::NOOP_ACK;
+                break;
+            }
             }
             break;
         }
@@ -93,7 +165,9 @@ RicControlMessage::DecodeRicControlMessage(E2AP_PDU_t* pdu)
             break;
         }
         case RICcontrolRequest_IEs__value_PR_RICcallProcessID: {
-            m_ricCallProcessId = ie->value.choice.RICcallProcessID;
+            // Copied, the PDU is released by the caller
+            m_ricCallProcessId.assign((const char*)ie->value.choice.RICcallProcessID.buf,
+                                      ie->value.choice.RICcallProcessID.size);
             NS_LOG_DEBUG("[E2SM] RICcontrolRequest_IEs__value_PR_RICcallProcessID");
             break;
         }
@@ -101,67 +175,21 @@ RicControlMessage::DecodeRicControlMessage(E2AP_PDU_t* pdu)
             NS_LOG_DEBUG("[E2SM] RICcontrolRequest_IEs__value_PR_RICcontrolHeader");
             // xer_fprint(stderr, &asn_DEF_RICcontrolHeader, &ie->value.choice.RICcontrolHeader);
 
-            auto* e2smControlHeader =
-                (E2SM_RC_ControlHeader_t*)calloc(1, sizeof(E2SM_RC_ControlHeader_t));
-            ASN_STRUCT_RESET(asn_DEF_E2SM_RC_ControlHeader, e2smControlHeader);
-            asn_decode(nullptr,
-                       ATS_ALIGNED_BASIC_PER,
-                       &asn_DEF_E2SM_RC_ControlHeader,
-                       (void**)&e2smControlHeader,
-                       ie->value.choice.RICcontrolHeader.buf,
-                       ie->value.choice.RICcontrolHeader.size);
-
-            NS_LOG_INFO(xer_fprint(stderr, &asn_DEF_E2SM_RC_ControlHeader, e2smControlHeader));
-            if (e2smControlHeader->present == E2SM_RC_ControlHeader_PR_controlHeader_Format1)
+            E2SM_RC_ControlHeader_t* e2smControlHeader =
+                decoder.DecodeHeader(ie->value.choice.RICcontrolHeader);
+            if (e2smControlHeader == nullptr)
             {
-                m_e2SmRcControlHeaderFormat1 = e2smControlHeader->choice.controlHeader_Format1;
-
-                auto *prList = m_e2SmRcControlHeaderFormat1->rrmPolicyList;
-
-                for (size_t i = 0; i < prList->list.count; ++i)
-                {
-                    auto *grp = prList->list.array[i];
-
-                    uint32_t sliceId = 0;
-                    if (grp->rrmPolicy.rrmPolicyMemberList.list.count > 0){
-                        auto *member = grp->rrmPolicy.rrmPolicyMemberList.list.array[0];
-                        if (grp->rrmPolicy.rrmPolicyMemberList.list.count > 0) {
-                            // Get the slice ID from the first member
-                            RRMPolicyMember_t *member =
-                              grp->rrmPolicy.rrmPolicyMemberList.list.array[0];
-                            if (member->sNSSAI) {
-                                auto *raw = member->sNSSAI;
-
-                                SNSSAI_t *snssai = reinterpret_cast<SNSSAI_t*>(raw);
-                                //S_NSSAI *snssai = member->sNSSAI;
-                                
-                                if (snssai->sST.buf && snssai->sST.size > 0) {
-                                    sliceId = (uint32_t) snssai->sST.buf[0];
-                              }
-                            }
-                          }
-                        //if (member->sNSSAI && member->sNSSAI->sST.buf && member->sNSSAI->sST.size  > 0){
-                        //    sliceId = member->sNSSAI->sST.buf[0];
-                        //}
-                    }
-                    long maxPRBRatio = grp->maxPRBPolicyRatio ? *grp->maxPRBPolicyRatio : 100;
-                    long minPRBRatio = grp->minPRBPolicyRatio ? *grp->minPRBPolicyRatio : 100;
-                    long dedicatePRBRatio = grp->dedicatedPRBPolicyRatio ? *grp->dedicatedPRBPolicyRatio : 100;
-
-                    m_prbQuotas.push_back({sliceId, maxPRBRatio, minPRBRatio, dedicatePRBRatio});
-                }
-
-                //uint8_t sliceId = prb->sliceID.sST.buf[0];
-
+                break;
+            }
 
-                // Get the UE ID
-                // uint8_t ueId = m_e2SmRcControlHeaderFormat1->ueId.buf[0];
-                //m_slicePRBQuota = {sliceId,
-                //                   prb->maxPRBRatio,
-                //                   prb->minPRBRatio,
-                //                   prb->dedicatePRBRatio};
-                // m_e2SmRcControlHeaderFormat1->ric_ControlAction_ID;
-                // m_e2SmRcControlHeaderFormat1->ric_ControlStyle_Type;
+            NORI_PDU_DUMP(asn_DEF_E2SM_RC_ControlHeader, e2smControlHeader);
+            if (e2smControlHeader->present == E2SM_RC_ControlHeader_PR_controlHeader_Format1)
+            {
+                // Only plain values are kept, the decoded header does not outlive the
+                // decoding
+                auto* format1 = e2smControlHeader->choice.controlHeader_Format1;
+                m_ueId.assign((const char*)format1->ueId.buf, format1->ueId.size);
+                m_prbQuotas = ExtractSlicePrbQuotas(format1);
             }
             else
             {
@@ -173,17 +201,14 @@ RicControlMessage::DecodeRicControlMessage(E2AP_PDU_t* pdu)
             NS_LOG_DEBUG("[E2SM] RICcontrolRequest_IEs__value_PR_RICcontrolMessage");
             // xer_fprint(stderr, &asn_DEF_RICcontrolMessage, &ie->value.choice.RICcontrolMessage);
 
-            auto* e2SmControlMessage =
-                (E2SM_RC_ControlMessage_t*)calloc(1, sizeof(E2SM_RC_ControlMessage_t));
-            ASN_STRUCT_RESET(asn_DEF_E2SM_RC_ControlMessage, e2SmControlMessage);
-            asn_decode(nullptr,
-                       ATS_ALIGNED_BASIC_PER,
-                       &asn_DEF_E2SM_RC_ControlMessage,
-                       (void**)&e2SmControlMessage,
-                       ie->value.choice.RICcontrolMessage.buf,
-                       ie->value.choice.RICcontrolMessage.size);
+            E2SM_RC_ControlMessage_t* e2SmControlMessage =
+                decoder.DecodeMessage(ie->value.choice.RICcontrolMessage);
+            if (e2SmControlMessage == nullptr)
+            {
+                break;
+            }
 
-            NS_LOG_INFO(xer_fprint(stderr, &asn_DEF_E2SM_RC_ControlMessage, e2SmControlMessage));
+            NORI_PDU_DUMP(asn_DEF_E2SM_RC_ControlMessage, e2SmControlMessage);
 
             if (e2SmControlMessage->present == E2SM_RC_ControlMessage_PR_controlMessage_Format1)
             {
@@ -250,9 +275,50 @@ RicControlMessage::DecodeRicControlMessage(E2AP_PDU_t* pdu)
         }
         }
     }
+    decoder.Reset();
     NS_LOG_INFO("End of DecodeRicControlMessage");
 }
 
+std::vector<RicControlMessage::SlicePRBQuota>
+RicControlMessage::ExtractSlicePrbQuotas(
+    const E2SM_RC_ControlHeader_Format1_t* e2SmRcControlHeaderFormat1)
+{
+    std::vector<SlicePRBQuota> quotas;
+    auto* prList = e2SmRcControlHeaderFormat1->rrmPolicyList;
+    if (prList == nullptr)
+    {
+        return quotas;
+    }
+
+    quotas.reserve(prList->list.count);
+    for (int i = 0; i < prList->list.count; ++i)
+    {
+        auto* grp = prList->list.array[i];
+
+        // The slice ID is the SST of the first member
+        uint32_t sliceId = 0;
+        if (grp->rrmPolicy.rrmPolicyMemberList.list.count > 0)
+        {
+            RRMPolicyMember_t* member = grp->rrmPolicy.rrmPolicyMemberList.list.array[0];
+            if (member->sNSSAI)
+            {
+                auto* snssai = reinterpret_cast<SNSSAI_t*>(member->sNSSAI);
+                if (snssai->sST.buf && snssai->sST.size > 0)
+                {
+                    sliceId = (uint32_t)snssai->sST.buf[0];
+                }
+            }
+        }
+        long maxPRBRatio = grp->maxPRBPolicyRatio ? *grp->maxPRBPolicyRatio : 100;
+        long minPRBRatio = grp->minPRBPolicyRatio ? *grp->minPRBPolicyRatio : 100;
+        long dedicatePRBRatio =
+            grp->dedicatedPRBPolicyRatio ? *grp->dedicatedPRBPolicyRatio : 100;
+
+        quotas.push_back({sliceId, maxPRBRatio, minPRBRatio, dedicatePRBRatio});
+    }
+    return quotas;
+}
+
 std::string
 RicControlMessage::GetSecondaryCellIdHO()
 {
@@ -36,6 +36,45 @@ extern "C"
 namespace ns3
 {
 
+/**
+ * Decode context of the E2SM-RC header and message of the RIC Control messages of an
+ * E2 node.
+ *
+ * The top-level asn1c structures are allocated once and reused, and everything the
+ * decoder allocates inside them is released by Reset, so the memory used does not
+ * grow with the number of messages. The decoded structures are only valid until the
+ * next Reset. A context must not be shared by threads.
+ */
+class RicControlDecoder : public SimpleRefCount<RicControlDecoder>
+{
+  public:
+    RicControlDecoder();
+    ~RicControlDecoder();
+
+    /**
+     * Decode the E2SM-RC header of a RIC Control message
+     * @param header the encoded header
+     * @return the decoded header, nullptr on failure
+     */
+    E2SM_RC_ControlHeader_t* DecodeHeader(const RICcontrolHeader_t& header);
+
+    /**
+     * Decode the E2SM-RC message of a RIC Control message
+     * @param message the encoded message
+     * @return the decoded message, nullptr on failure
+     */
+    E2SM_RC_ControlMessage_t* DecodeMessage(const RICcontrolMessage_t& message);
+
+    /**
+     * Release the memory allocated by the last decodings
+     */
+    void Reset();
+
+  private:
+    E2SM_RC_ControlHeader_t* m_header;   //!< Reused header structure
+    E2SM_RC_ControlMessage_t* m_message; //!< Reused message structure
+};
+
 class RicControlMessage : public SimpleRefCount<RicControlMessage>
 {
   public:
@@ -57,9 +96,22 @@ class RicControlMessage : public SimpleRefCount<RicControlMessage>
         TS = 1001,
         QoS = 1002,
         RAN_SLICING = 1003,
+        NOOP_ACK = 1004, //!< Acknowledges a report without any action, for lockstep mode
     };
 
+    /**
+     * Decode a RIC Control message with a context of its own
+     * @param pdu PDU passed by the RIC, still owned by the caller
+     */
     RicControlMessage(E2AP_PDU_t* pdu);
+
+    /**
+     * Decode a RIC Control message with the context of the E2 node. The values are
+     * copied out of the asn1c structures, and the context is reset before returning.
+     * @param pdu PDU passed by the RIC, still owned by the caller
+     * @param decoder the decode context of the E2 node
+     */
+    RicControlMessage(E2AP_PDU_t* pdu, RicControlDecoder& decoder);
     ~RicControlMessage();
 
     ControlMessageRequestIdType m_requestType;
@@ -67,11 +119,19 @@ class RicControlMessage : public SimpleRefCount<RicControlMessage>
     static std::vector<RANParameterItem> ExtractRANParametersFromControlMessage(
         E2SM_RC_ControlMessage_Format1_t* e2SmRcControlMessageFormat1);
 
+    /**
+     * Extract the slice PRB quotas of the RRM policies of a control header
+     * @param e2SmRcControlHeaderFormat1 the decoded header
+     * @return the quotas, one per RRM policy
+     */
+    static std::vector<SlicePRBQuota> ExtractSlicePrbQuotas(
+        const E2SM_RC_ControlHeader_Format1_t* e2SmRcControlHeaderFormat1);
+
     std::vector<RANParameterItem> m_valuesExtracted;
     RANfunctionID_t m_ranFunctionId;
     RICrequestID_t m_ricRequestId;
-    RICcallProcessID_t m_ricCallProcessId;
-    E2SM_RC_ControlHeader_Format1_t* m_e2SmRcControlHeaderFormat1;
+    std::string m_ricCallProcessId; //!< Content of the RIC call process ID
+    std::string m_ueId;             //!< Content of the UE ID of the control header
     std::string GetSecondaryCellIdHO();
     std::vector<SlicePRBQuota> m_prbQuotas;
   private:
@@ -79,8 +139,9 @@ class RicControlMessage : public SimpleRefCount<RicControlMessage>
      * Decodes the RIC Control message .
      *
      * @param pdu PDU passed by the RIC
+     * @param decoder the decode context, reset before returning
      */
-    void DecodeRicControlMessage(E2AP_PDU_t* pdu);
+    void DecodeRicControlMessage(E2AP_PDU_t* pdu, RicControlDecoder& decoder);
     std::string m_secondaryCellId;
 };
 } // namespace ns3
@@ -0,0 +1,82 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "sched-decision-trace.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("SchedDecisionTrace");
+
+SchedDecisionTrace::SchedDecisionTrace(uint32_t capacity)
+{
+    NS_ABORT_MSG_IF(capacity == 0, "The scheduler decision trace needs a non-zero capacity");
+    uint64_t size = 1;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    m_records.resize(size, Entry{});
+    m_mask = size - 1;
+}
+
+SchedDecisionTrace::~SchedDecisionTrace()
+{
+    if (m_stream.is_open())
+    {
+        Flush();
+        m_stream.close();
+    }
+}
+
+void
+SchedDecisionTrace::SetStreamFile(const std::string& fileName)
+{
+    NS_LOG_FUNCTION(this << fileName);
+    if (m_stream.is_open())
+    {
+        Flush();
+        m_stream.close();
+    }
+    m_stream.open(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    NS_ABORT_MSG_IF(!m_stream.is_open(), "Can't open file " << fileName);
+    // Records stored before the stream was set are not streamed
+    m_flushed = m_head;
+}
+
+void
+SchedDecisionTrace::Flush()
+{
+    // The records not yet streamed are at most one buffer long, since Flush is
+    // called every time the buffer wraps around
+    uint64_t pending = std::min<uint64_t>(m_head - m_flushed, m_records.size());
+    for (uint64_t i = m_head - pending; i < m_head; i++)
+    {
+        m_stream.write(reinterpret_cast<const char*>(&m_records[i & m_mask]), sizeof(Entry));
+    }
+    m_flushed = m_head;
+}
+
+void
+SchedDecisionTrace::Dump(std::ostream& os) const
+{
+    uint64_t size = GetSize();
+    for (uint64_t i = m_head - size; i < m_head; i++)
+    {
+        os.write(reinterpret_cast<const char*>(&m_records[i & m_mask]), sizeof(Entry));
+    }
+}
+
+uint32_t
+SchedDecisionTrace::GetSize() const
+{
+    return static_cast<uint32_t>(std::min<uint64_t>(m_head, m_records.size()));
+}
+
+} // namespace ns3
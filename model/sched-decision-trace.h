@@ -0,0 +1,132 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Record a scheduler decision in a SchedDecisionTrace.
+ *
+ * The macro expands to nothing unless the module is built with NS3_NORI_SCHED_TRACE, so
+ * the recording has no cost in the default build.
+ */
+#ifdef NS3_NORI_SCHED_TRACE
+#define NORI_SCHED_TRACE(trace, ...) (trace).Record(__VA_ARGS__)
+#else
+#define NORI_SCHED_TRACE(trace, ...)
+#endif
+
+namespace ns3
+{
+
+/**
+ * @brief Fixed-size binary ring buffer of per-slot scheduler decisions.
+ *
+ * Each grant is stored as a fixed-width record, so that the buffer can be written
+ * to disk as is and parsed offline. Once the buffer is full the oldest records are
+ * overwritten, unless a stream file is set, in which case the buffer is flushed to
+ * the file every time it wraps around.
+ */
+class SchedDecisionTrace
+{
+  public:
+    /**
+     * Allocation phase of the slicing scheduler
+     */
+    enum Phase : uint8_t
+    {
+        DEDICATED = 0,
+        MIN = 1,
+        MAX = 2
+    };
+
+    /**
+     * A single scheduler decision, 32 bytes on disk
+     */
+    struct Entry
+    {
+        int64_t timeNs;  //!< Simulation time of the slot, in ns
+        uint32_t tbSize; //!< TB size of the UE after the grant, in bytes
+        uint32_t rbg;    //!< RBGs assigned to the UE in this grant
+        uint16_t beam;   //!< Beam sector
+        uint16_t rnti;   //!< UE RNTI
+        uint8_t slice;   //!< Slice index
+        uint8_t sym;     //!< Symbols spanned by the grant
+        uint8_t phase;   //!< Allocation phase, see Phase
+        uint8_t pad[9];  //!< Padding to keep the record size fixed
+    };
+
+    static_assert(sizeof(Entry) == 32, "Entry must keep a fixed on-disk layout");
+
+    /**
+     * @brief Constructor
+     * @param capacity number of records, rounded up to a power of two
+     */
+    SchedDecisionTrace(uint32_t capacity = 4096);
+
+    ~SchedDecisionTrace();
+
+    /**
+     * @brief Store a decision in the buffer
+     */
+    inline void Record(int64_t timeNs,
+                       uint16_t beam,
+                       uint8_t slice,
+                       uint16_t rnti,
+                       uint32_t rbg,
+                       uint8_t sym,
+                       uint32_t tbSize,
+                       Phase phase)
+    {
+        auto& rec = m_records[m_head & m_mask];
+        rec.timeNs = timeNs;
+        rec.tbSize = tbSize;
+        rec.rbg = rbg;
+        rec.beam = beam;
+        rec.rnti = rnti;
+        rec.slice = slice;
+        rec.sym = sym;
+        rec.phase = phase;
+        if ((++m_head & m_mask) == 0 && m_stream.is_open())
+        {
+            Flush();
+        }
+    }
+
+    /**
+     * @brief Write the records currently held in the buffer, oldest first
+     * @param os the output stream, opened in binary mode
+     */
+    void Dump(std::ostream& os) const;
+
+    /**
+     * @brief Stream every record to a binary file, instead of overwriting old ones
+     * @param fileName the output file name
+     */
+    void SetStreamFile(const std::string& fileName);
+
+    /**
+     * @brief Number of records held in the buffer
+     */
+    uint32_t GetSize() const;
+
+  private:
+    /**
+     * @brief Write the records not yet streamed to the stream file
+     */
+    void Flush();
+
+    std::vector<Entry> m_records; //!< Record storage
+    uint64_t m_mask;              //!< Capacity - 1
+    uint64_t m_head{0};           //!< Number of records ever stored
+    uint64_t m_flushed{0};        //!< Number of records already streamed
+    std::ofstream m_stream;       //!< Optional stream file
+};
+
+} // namespace ns3
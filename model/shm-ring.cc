@@ -0,0 +1,192 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "shm-ring.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("ShmRing");
+
+namespace
+{
+
+/// Records are aligned to 8 bytes, so that the headers are always naturally aligned
+uint64_t
+Align8(uint64_t size)
+{
+    return (size + 7) & ~uint64_t(7);
+}
+
+/// Offset of the data area from the start of the segment
+const size_t DATA_OFFSET = (sizeof(ShmRing::ShmRingHeader) + 63) & ~size_t(63);
+
+} // namespace
+
+ShmRing::ShmRing(const std::string& name, uint64_t capacity)
+    : m_name(name)
+{
+    NS_LOG_FUNCTION(this << name << capacity);
+
+    uint64_t roundedCapacity = 64;
+    while (roundedCapacity < capacity)
+    {
+        roundedCapacity <<= 1;
+    }
+    m_mapSize = DATA_OFFSET + roundedCapacity;
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0)
+    {
+        m_owner = true;
+        NS_ABORT_MSG_IF(ftruncate(fd, m_mapSize) != 0,
+                        "Can't size shared memory " << name << ": " << strerror(errno));
+    }
+    else
+    {
+        // The agent created the segment first, attach to it
+        fd = shm_open(name.c_str(), O_RDWR, 0600);
+        NS_ABORT_MSG_IF(fd < 0, "Can't open shared memory " << name << ": " << strerror(errno));
+        struct stat st;
+        NS_ABORT_MSG_IF(fstat(fd, &st) != 0 || (size_t)st.st_size != m_mapSize,
+                        "Shared memory " << name << " exists with a different capacity");
+    }
+
+    void* addr = mmap(nullptr, m_mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    NS_ABORT_MSG_IF(addr == MAP_FAILED,
+                    "Can't map shared memory " << name << ": " << strerror(errno));
+
+    m_data = static_cast<uint8_t*>(addr) + DATA_OFFSET;
+    m_mask = roundedCapacity - 1;
+    if (m_owner)
+    {
+        m_header = new (addr) ShmRingHeader;
+        m_header->version = VERSION;
+        m_header->capacity = roundedCapacity;
+        m_header->head.store(0, std::memory_order_relaxed);
+        m_header->tail.store(0, std::memory_order_relaxed);
+        // Publish the magic last, so that an agent polling it sees a consistent header
+        std::atomic_thread_fence(std::memory_order_release);
+        m_header->magic = MAGIC;
+    }
+    else
+    {
+        m_header = static_cast<ShmRingHeader*>(addr);
+        NS_ABORT_MSG_IF(m_header->magic != MAGIC || m_header->version != VERSION ||
+                            m_header->capacity != roundedCapacity,
+                        "Shared memory " << name << " is not a compatible NORI ring");
+    }
+}
+
+ShmRing::~ShmRing()
+{
+    NS_LOG_FUNCTION(this);
+    munmap(m_header, m_mapSize);
+    if (m_owner)
+    {
+        shm_unlink(m_name.c_str());
+    }
+}
+
+bool
+ShmRing::Write(uint16_t type,
+               const void* first,
+               uint32_t firstSize,
+               const void* second,
+               uint32_t secondSize)
+{
+    uint64_t capacity = m_mask + 1;
+    uint64_t recordSize = Align8(sizeof(RecordHeader) + firstSize + secondSize);
+    NS_ABORT_MSG_IF(recordSize > capacity / 2,
+                    "Record of " << recordSize << " bytes is too large for ring " << m_name);
+
+    uint64_t head = m_header->head.load(std::memory_order_relaxed);
+    uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+    uint64_t offset = head & m_mask;
+    uint64_t padSize = offset + recordSize > capacity ? capacity - offset : 0;
+    if (head + padSize + recordSize - tail > capacity)
+    {
+        NS_LOG_WARN("Ring " << m_name << " is full, dropping a record of type " << type);
+        return false;
+    }
+
+    if (padSize != 0)
+    {
+        auto pad = reinterpret_cast<RecordHeader*>(m_data + offset);
+        pad->size = padSize - sizeof(RecordHeader);
+        pad->type = PAD;
+        pad->flags = 0;
+        offset = 0;
+    }
+
+    auto rec = reinterpret_cast<RecordHeader*>(m_data + offset);
+    rec->size = firstSize + secondSize;
+    rec->type = type;
+    rec->flags = 0;
+    memcpy(m_data + offset + sizeof(RecordHeader), first, firstSize);
+    if (secondSize != 0)
+    {
+        memcpy(m_data + offset + sizeof(RecordHeader) + firstSize, second, secondSize);
+    }
+
+    m_header->head.store(head + padSize + recordSize, std::memory_order_release);
+    return true;
+}
+
+bool
+ShmRing::Read(uint16_t& type, std::vector<uint8_t>& payload)
+{
+    uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+    while (true)
+    {
+        uint64_t head = m_header->head.load(std::memory_order_acquire);
+        if (tail == head)
+        {
+            return false;
+        }
+
+        auto rec = reinterpret_cast<const RecordHeader*>(m_data + (tail & m_mask));
+        uint16_t recordType = rec->type;
+        if (recordType != PAD)
+        {
+            auto data = reinterpret_cast<const uint8_t*>(rec + 1);
+            payload.assign(data, data + rec->size);
+        }
+        // The record may be overwritten as soon as tail moves past it
+        tail += Align8(sizeof(RecordHeader) + rec->size);
+        m_header->tail.store(tail, std::memory_order_release);
+        if (recordType != PAD)
+        {
+            type = recordType;
+            return true;
+        }
+    }
+}
+
+const std::string&
+ShmRing::GetName() const
+{
+    return m_name;
+}
+
+double
+ShmRing::GetOccupancy() const
+{
+    uint64_t head = m_header->head.load(std::memory_order_relaxed);
+    uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+    return static_cast<double>(head - tail) / (m_mask + 1);
+}
+
+} // namespace ns3
@@ -0,0 +1,117 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include "ns3/simple-ref-count.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Single-producer single-consumer ring buffer in POSIX shared memory.
+ *
+ * The segment starts with a ShmRingHeader, followed by the data area. Each record is
+ * an 8-byte RecordHeader followed by the payload, padded to a multiple of 8 bytes.
+ * A record never wraps around the end of the data area: when it does not fit, the
+ * producer fills the tail of the area with a PAD record and starts again from the
+ * beginning. The producer only writes head, the consumer only writes tail, so an
+ * agent in another process can read the payloads in place, without copies.
+ */
+class ShmRing : public SimpleRefCount<ShmRing>
+{
+  public:
+    static const uint32_t MAGIC = 0x4e4f5249; //!< "NORI"
+    static const uint32_t VERSION = 1;        //!< Layout version
+
+    /**
+     * Type of the records
+     */
+    enum RecordType : uint16_t
+    {
+        PAD = 0,          //!< Filler up to the end of the data area, to be skipped
+        E2AP_PDU = 1,     //!< APER encoded E2AP PDU
+        KPI_SNAPSHOT = 2, //!< nori_kpi_snapshot followed by its UE and slice arrays
+    };
+
+    /**
+     * Layout of the start of the segment
+     */
+    struct ShmRingHeader
+    {
+        uint32_t magic;                         //!< MAGIC, set once the segment is ready
+        uint32_t version;                       //!< VERSION
+        uint64_t capacity;                      //!< Size of the data area, power of two
+        alignas(64) std::atomic<uint64_t> head; //!< Bytes ever written by the producer
+        alignas(64) std::atomic<uint64_t> tail; //!< Bytes ever consumed by the consumer
+    };
+
+    /**
+     * Header of each record
+     */
+    struct RecordHeader
+    {
+        uint32_t size;  //!< Payload size, in bytes, without padding
+        uint16_t type;  //!< RecordType
+        uint16_t flags; //!< Reserved
+    };
+
+    /**
+     * @brief Open a ring, creating the segment if needed
+     * @param name POSIX shared memory name, e.g. "/nori-1-ind"
+     * @param capacity size of the data area, rounded up to a power of two
+     */
+    ShmRing(const std::string& name, uint64_t capacity);
+
+    ~ShmRing();
+
+    /**
+     * @brief Append a record made of two contiguous parts
+     * @param type the record type
+     * @param first first part of the payload
+     * @param firstSize size of the first part
+     * @param second second part of the payload, may be null
+     * @param secondSize size of the second part
+     * @return false if the consumer is too slow and the record does not fit
+     */
+    bool Write(uint16_t type,
+               const void* first,
+               uint32_t firstSize,
+               const void* second = nullptr,
+               uint32_t secondSize = 0);
+
+    /**
+     * @brief Pop the next record, skipping padding
+     * @param type the record type
+     * @param payload the payload, resized to the record size
+     * @return false if the ring is empty
+     */
+    bool Read(uint16_t& type, std::vector<uint8_t>& payload);
+
+    /**
+     * @brief Get the name of the segment
+     */
+    const std::string& GetName() const;
+
+    /**
+     * @brief Get the fraction of the data area not yet consumed
+     * @return the occupancy, from 0 to 1
+     */
+    double GetOccupancy() const;
+
+  private:
+    std::string m_name;      //!< Shared memory name
+    bool m_owner{false};     //!< Whether this object created the segment
+    size_t m_mapSize{0};     //!< Size of the mapping
+    ShmRingHeader* m_header; //!< Start of the mapping
+    uint8_t* m_data;         //!< Start of the data area
+    uint64_t m_mask;         //!< Capacity - 1
+};
+
+} // namespace ns3
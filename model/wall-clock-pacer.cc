@@ -0,0 +1,44 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "wall-clock-pacer.h"
+
+#include "ns3/simulator.h"
+
+#include <thread>
+
+namespace ns3
+{
+
+void
+WallClockPacer::Anchor()
+{
+    if (!m_anchored)
+    {
+        m_simAnchor = Simulator::Now();
+        m_wallAnchor = std::chrono::steady_clock::now();
+        m_anchored = true;
+    }
+}
+
+Time
+WallClockPacer::GetLag()
+{
+    Anchor();
+    auto wallElapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - m_wallAnchor);
+    return NanoSeconds(wallElapsed.count()) - (Simulator::Now() - m_simAnchor);
+}
+
+void
+WallClockPacer::WaitForWallClock()
+{
+    Time lag = GetLag();
+    if (lag.IsStrictlyNegative())
+    {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(-lag.GetNanoSeconds()));
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,49 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include "ns3/nstime.h"
+#include "ns3/simple-ref-count.h"
+
+#include <chrono>
+
+namespace ns3
+{
+
+/**
+ * @brief Compare the simulation time with the wall clock, for co-simulation with a
+ * live RIC.
+ *
+ * Both clocks are anchored on the first measurement, so the lag is the drift
+ * accumulated since then. The simulation can also be held back so that it does not
+ * run ahead of the wall clock, with the granularity of the calls to
+ * WaitForWallClock.
+ */
+class WallClockPacer : public SimpleRefCount<WallClockPacer>
+{
+  public:
+    /**
+     * @brief Get how far the simulation is behind the wall clock
+     * @return the lag, negative if the simulation runs ahead of the wall clock
+     */
+    Time GetLag();
+
+    /**
+     * @brief Block until the wall clock catches up with the simulation time
+     */
+    void WaitForWallClock();
+
+  private:
+    /**
+     * @brief Anchor both clocks on the first call
+     */
+    void Anchor();
+
+    bool m_anchored{false};                             //!< Whether the clocks are anchored
+    Time m_simAnchor;                                   //!< Simulation time of the anchor
+    std::chrono::steady_clock::time_point m_wallAnchor; //!< Wall-clock time of the anchor
+};
+
+} // namespace ns3
@@ -0,0 +1,347 @@
+// Copyright (c) 2025 LASSE/UFPA
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "ns3/e2-record-log.h"
+#include "ns3/kpi-history.h"
+#include "ns3/kpi-store.h"
+#include "ns3/shm-ring.h"
+#include "ns3/test.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unistd.h>
+
+using namespace ns3;
+
+/**
+ * @brief Round trip of the KPI store, including the values an INT column can't hold
+ * and a file cut before its index
+ */
+class KpiStoreTestCase : public TestCase
+{
+  public:
+    KpiStoreTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+KpiStoreTestCase::KpiStoreTestCase()
+    : TestCase("KPI store round trip")
+{
+}
+
+void
+KpiStoreTestCase::DoRun()
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+    std::string fileName = CreateTempDirFilename("kpis.nkpi");
+    std::vector<KpiStoreWriter::Column> columns{{"prb", KpiStoreWriter::INT},
+                                                {"sinr", KpiStoreWriter::DOUBLE}};
+
+    // Cell 1 has a block of plain integers and a block the INT column keeps as doubles,
+    // cell 2 a partial block written by Close
+    std::vector<std::vector<double>> rows{{3, 0.1},
+                                          {4, -0.0},
+                                          {5, 1e-300},
+                                          {-6, 12.5},
+                                          {1, inf},
+                                          {nan, nan},
+                                          {1e300, -1e300},
+                                          {-(0x1p63), 7}};
+    {
+        KpiStoreWriter writer(fileName, columns, 4);
+        for (size_t i = 0; i < rows.size(); i++)
+        {
+            writer.Append(1, 1000 + 10 * i, rows[i]);
+        }
+        writer.Append(2, 2000, {42, 0.5});
+        writer.Close();
+        NS_TEST_ASSERT_MSG_EQ(writer.GetRows(), 9, "Wrong number of rows stored");
+    }
+
+    KpiStoreReader reader(fileName);
+    NS_TEST_ASSERT_MSG_EQ(reader.GetColumns().size(), 2, "Wrong number of columns");
+    NS_TEST_ASSERT_MSG_EQ(reader.FindColumn("sinr"), 1, "Column sinr not found");
+    NS_TEST_ASSERT_MSG_EQ(reader.FindColumn("cqi"), -1, "Unknown column found");
+    NS_TEST_ASSERT_MSG_EQ(reader.GetBlocks().size(), 3, "Wrong number of blocks");
+    NS_TEST_ASSERT_MSG_EQ(reader.FindBlocks(1035, 1045, 1).size(), 1, "Wrong blocks in range");
+    NS_TEST_ASSERT_MSG_EQ(reader.FindBlocks(0, 5000, 2).size(), 1, "Wrong blocks of cell 2");
+
+    std::vector<int64_t> timestamps;
+    std::vector<double> values;
+    for (size_t block = 0; block < 2; block++)
+    {
+        reader.ReadTimestamps(block, timestamps);
+        NS_TEST_ASSERT_MSG_EQ(timestamps.size(), 4, "Wrong number of rows in block " << block);
+        for (size_t column = 0; column < columns.size(); column++)
+        {
+            reader.ReadColumn(block, column, values);
+            for (size_t row = 0; row < 4; row++)
+            {
+                double expected = rows[block * 4 + row][column];
+                NS_TEST_ASSERT_MSG_EQ(timestamps[row],
+                                      int64_t(1000 + 10 * (block * 4 + row)),
+                                      "Wrong timestamp of row " << row);
+                // Compared bit by bit, so that NaN and -0 are checked too
+                NS_TEST_ASSERT_MSG_EQ(std::memcmp(&values[row], &expected, sizeof(double)),
+                                      0,
+                                      "Column " << column << " row " << row << " read as "
+                                                << values[row] << " instead of " << expected);
+            }
+        }
+    }
+    reader.ReadColumn(2, 0, values);
+    NS_TEST_ASSERT_MSG_EQ(values.size(), 1, "Wrong number of rows of cell 2");
+    NS_TEST_ASSERT_MSG_EQ(values[0], 42, "Wrong value of cell 2");
+
+    // A store that was not closed has no index, its blocks are scanned up to the last
+    // complete one
+    uint64_t dataEnd;
+    {
+        KpiStoreWriter writer(fileName, columns, 2);
+        for (size_t i = 0; i < 6; i++)
+        {
+            writer.Append(1, 10 * i, rows[i]);
+        }
+        dataEnd = writer.GetBytes();
+    }
+    NS_TEST_ASSERT_MSG_EQ(truncate(fileName.c_str(), dataEnd - 8), 0, "Can't cut the store");
+    KpiStoreReader truncated(fileName);
+    NS_TEST_ASSERT_MSG_EQ(truncated.GetBlocks().size(), 2, "Wrong number of complete blocks");
+    truncated.ReadTimestamps(1, timestamps);
+    NS_TEST_ASSERT_MSG_EQ(timestamps.size(), 2, "Wrong number of rows in the last block");
+    NS_TEST_ASSERT_MSG_EQ(timestamps[1], 30, "Wrong timestamp in the last block");
+    truncated.ReadColumn(1, 0, values);
+    NS_TEST_ASSERT_MSG_EQ(values[1], -6, "Wrong value in the last block");
+}
+
+/**
+ * @brief Records of the shared memory ring wrapping around its end
+ */
+class ShmRingTestCase : public TestCase
+{
+  public:
+    ShmRingTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+ShmRingTestCase::ShmRingTestCase()
+    : TestCase("Shared memory ring wrap-around")
+{
+}
+
+void
+ShmRingTestCase::DoRun()
+{
+    // 64 bytes, the smallest ring, holds two records of 24 to 32 bytes
+    ShmRing ring("/nori-test-" + std::to_string(getpid()), 1);
+    uint16_t type;
+    std::vector<uint8_t> payload;
+    NS_TEST_ASSERT_MSG_EQ(ring.Read(type, payload), false, "Read from an empty ring");
+
+    const char first[] = "0123456789ab";  // 12 bytes, 24 with the header and padding
+    const char second[] = "cdefghijklmn"; // 12 bytes
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        NS_TEST_ASSERT_MSG_EQ(ring.Write(ShmRing::E2AP_PDU, first, 12),
+                              true,
+                              "Write " << i << " failed");
+        NS_TEST_ASSERT_MSG_EQ(ring.Read(type, payload), true, "Read " << i << " failed");
+    }
+
+    // The third record doesn't fit the last 16 bytes, which are padded
+    NS_TEST_ASSERT_MSG_EQ(ring.Write(ShmRing::KPI_SNAPSHOT, first, 5, second, 7),
+                          true,
+                          "Write across the end failed");
+    NS_TEST_EXPECT_MSG_EQ_TOL(ring.GetOccupancy(), 40.0 / 64, 1e-9, "Pad not counted");
+    NS_TEST_ASSERT_MSG_EQ(ring.Read(type, payload), true, "Read after the pad failed");
+    NS_TEST_ASSERT_MSG_EQ(type, ShmRing::KPI_SNAPSHOT, "Pad record returned");
+    NS_TEST_ASSERT_MSG_EQ(std::string(payload.begin(), payload.end()),
+                          "01234cdefghi",
+                          "Wrong payload after the wrap-around");
+    NS_TEST_ASSERT_MSG_EQ(ring.Read(type, payload), false, "Read past the last record");
+    NS_TEST_EXPECT_MSG_EQ_TOL(ring.GetOccupancy(), 0, 1e-9, "Ring not empty");
+
+    // A full ring drops the record instead of overwriting the unread ones
+    NS_TEST_ASSERT_MSG_EQ(ring.Write(ShmRing::E2AP_PDU, first, 12), true, "Write failed");
+    NS_TEST_ASSERT_MSG_EQ(ring.Write(ShmRing::E2AP_PDU, second, 12), true, "Write failed");
+    NS_TEST_ASSERT_MSG_EQ(ring.Write(ShmRing::E2AP_PDU, first, 12), false, "Full ring written");
+    NS_TEST_ASSERT_MSG_EQ(ring.Read(type, payload), true, "Read of a full ring failed");
+    NS_TEST_ASSERT_MSG_EQ(std::string(payload.begin(), payload.end()),
+                          std::string(first, 12),
+                          "Wrong record order");
+    NS_TEST_ASSERT_MSG_EQ(ring.Read(type, payload), true, "Read of a full ring failed");
+    NS_TEST_ASSERT_MSG_EQ(std::string(payload.begin(), payload.end()),
+                          std::string(second, 12),
+                          "Wrong record order");
+}
+
+/**
+ * @brief Frames of the E2 record log, read back from a file cut in its last frame
+ */
+class E2RecordLogTestCase : public TestCase
+{
+  public:
+    E2RecordLogTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+E2RecordLogTestCase::E2RecordLogTestCase()
+    : TestCase("E2 record log truncation")
+{
+}
+
+void
+E2RecordLogTestCase::DoRun()
+{
+    std::string fileName = CreateTempDirFilename("indications.ne2l");
+    const char pdus[] = "abcdefghijklmnopqrstuvwxyz";
+    std::vector<uint32_t> sizes{5, 16, 9};
+    {
+        // Smaller than the last frames, so that they bypass the buffer
+        E2RecordLog log(fileName, 44);
+        for (uint32_t i = 0; i < sizes.size(); i++)
+        {
+            E2RecordLog::FrameHeader frame{};
+            frame.cellId = 2 + i;
+            frame.ranFunctionId = 2;
+            frame.simTimeNs = 1000000 * i;
+            frame.sequenceNumber = i;
+            log.Append(frame, pdus + i, sizes[i]);
+        }
+        NS_TEST_ASSERT_MSG_EQ(log.GetFrames(), 3, "Wrong number of frames");
+    }
+
+    const E2RecordLog::FrameHeader* frame;
+    const uint8_t* pdu;
+    {
+        E2RecordReader reader(fileName);
+        NS_TEST_ASSERT_MSG_EQ(reader.GetSize(), 16 + 3 * 32 + 8 + 16 + 16, "Wrong file size");
+        for (uint32_t i = 0; i < sizes.size(); i++)
+        {
+            NS_TEST_ASSERT_MSG_EQ(reader.Next(frame, pdu), true, "Frame " << i << " missing");
+            NS_TEST_ASSERT_MSG_EQ(frame->size, sizes[i], "Wrong size of frame " << i);
+            NS_TEST_ASSERT_MSG_EQ(frame->cellId, 2 + i, "Wrong cell of frame " << i);
+            NS_TEST_ASSERT_MSG_EQ(frame->sequenceNumber, i, "Wrong SN of frame " << i);
+            NS_TEST_ASSERT_MSG_EQ(std::memcmp(pdu, pdus + i, sizes[i]),
+                                  0,
+                                  "Wrong PDU of frame " << i);
+        }
+        NS_TEST_ASSERT_MSG_EQ(reader.Next(frame, pdu), false, "Frame read past the end");
+    }
+
+    // Cut in the PDU, then in the header, of the last frame
+    for (size_t cut : {4, 40})
+    {
+        NS_TEST_ASSERT_MSG_EQ(truncate(fileName.c_str(), 16 + 3 * 32 + 8 + 16 + 16 - cut),
+                              0,
+                              "Can't cut the log");
+        E2RecordReader reader(fileName);
+        uint32_t frames = 0;
+        while (reader.Next(frame, pdu))
+        {
+            frames++;
+        }
+        NS_TEST_ASSERT_MSG_EQ(frames, 2, "Truncated frame read, cut of " << cut << " bytes");
+        reader.Rewind();
+        NS_TEST_ASSERT_MSG_EQ(reader.Next(frame, pdu), true, "Rewind failed");
+        NS_TEST_ASSERT_MSG_EQ(frame->sequenceNumber, 0, "Rewind to the wrong frame");
+    }
+}
+
+/**
+ * @brief Queries of the KPI history, after its rings wrapped around
+ */
+class KpiHistoryTestCase : public TestCase
+{
+  public:
+    KpiHistoryTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+KpiHistoryTestCase::KpiHistoryTestCase()
+    : TestCase("KPI history queries")
+{
+}
+
+void
+KpiHistoryTestCase::DoRun()
+{
+    auto history = Create<KpiHistory>(std::vector<std::string>{"prb", "sinr"}, 4);
+    NS_TEST_ASSERT_MSG_EQ(history->FindKpi("sinr"), 1, "KPI sinr not found");
+    NS_TEST_ASSERT_MSG_EQ(history->FindKpi("cqi"), -1, "Unknown KPI found");
+
+    // The snapshots at 10 and 20 are overwritten
+    for (int64_t i = 1; i <= 6; i++)
+    {
+        history->Add(7, 10 * i, {double(i), -double(i)});
+    }
+    history->Add(8, 15, {100, 100});
+    NS_TEST_ASSERT_MSG_EQ(history->GetKeys().size(), 2, "Wrong number of keys");
+
+    auto samples = history->GetRange(7, 1, 25, 50);
+    NS_TEST_ASSERT_MSG_EQ(samples.size(), 3, "Wrong number of samples in range");
+    NS_TEST_ASSERT_MSG_EQ(samples.front().timestamp, 30, "Wrong first sample in range");
+    NS_TEST_ASSERT_MSG_EQ(samples.back().timestamp, 50, "Wrong last sample in range");
+    NS_TEST_ASSERT_MSG_EQ(samples.back().value, -5, "Wrong KPI in range");
+    NS_TEST_ASSERT_MSG_EQ(history->GetRange(7, 0, 0, 100).size(), 4, "Overwritten samples");
+    NS_TEST_ASSERT_MSG_EQ(history->GetRange(7, 0, 61, 100).size(), 0, "Samples after the end");
+    NS_TEST_ASSERT_MSG_EQ(history->GetRange(7, 0, 50, 40).size(), 0, "Reversed range");
+    NS_TEST_ASSERT_MSG_EQ(history->GetRange(9, 0, 0, 100).size(), 0, "Samples of no key");
+
+    samples = history->GetLast(7, 0, 2);
+    NS_TEST_ASSERT_MSG_EQ(samples.size(), 2, "Wrong number of last samples");
+    NS_TEST_ASSERT_MSG_EQ(samples[0].timestamp, 50, "Wrong order of the last samples");
+    NS_TEST_ASSERT_MSG_EQ(samples[1].value, 6, "Wrong last sample");
+    NS_TEST_ASSERT_MSG_EQ(history->GetLast(7, 0, 10).size(), 4, "More samples than the depth");
+
+    history->Remove(8);
+    NS_TEST_ASSERT_MSG_EQ(history->GetLast(8, 0, 1).size(), 0, "Removed key returned");
+
+    std::vector<KpiHistory::Sample> window;
+    for (int64_t i = 10; i >= 1; i--)
+    {
+        window.push_back({i, double(i)});
+    }
+    auto summary = KpiHistory::Summarize(window);
+    NS_TEST_ASSERT_MSG_EQ(summary.count, 10, "Wrong count");
+    NS_TEST_EXPECT_MSG_EQ_TOL(summary.mean, 5.5, 1e-9, "Wrong mean");
+    NS_TEST_ASSERT_MSG_EQ(summary.min, 1, "Wrong min");
+    NS_TEST_ASSERT_MSG_EQ(summary.max, 10, "Wrong max");
+    NS_TEST_ASSERT_MSG_EQ(summary.percentile, 10, "Wrong 95th percentile");
+    NS_TEST_ASSERT_MSG_EQ(summary.first, 10, "Wrong first timestamp");
+    NS_TEST_ASSERT_MSG_EQ(summary.last, 1, "Wrong last timestamp");
+    NS_TEST_ASSERT_MSG_EQ(KpiHistory::Summarize(window, 50).percentile, 5, "Wrong median");
+    NS_TEST_ASSERT_MSG_EQ(KpiHistory::Summarize(window, 0).percentile, 1, "Wrong 0th percentile");
+    NS_TEST_ASSERT_MSG_EQ(KpiHistory::Summarize({}).count, 0, "Empty window summarized");
+}
+
+/**
+ * @brief Tests of the NORI stores, ring and history
+ */
+class NoriTestSuite : public TestSuite
+{
+  public:
+    NoriTestSuite();
+};
+
+NoriTestSuite::NoriTestSuite()
+    : TestSuite("nori", Type::UNIT)
+{
+    AddTestCase(new KpiStoreTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new ShmRingTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new E2RecordLogTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new KpiHistoryTestCase, TestCase::Duration::QUICK);
+}
+
+static NoriTestSuite g_noriTestSuite; //!< Static variable for test initialization